@@ -0,0 +1,494 @@
+// The benchmark of simcc::json against rapidjson.
+//
+// Usage: simcc_json_benchmark [test_data_dir] [seconds_per_case]
+//
+// Every corpus is measured with:
+//   parse      : the text to a DOM, simcc::json::JSONParser::Load vs rapidjson::Document::Parse
+//   serialize  : the DOM to the compact text, simcc::json::JSONWriter vs rapidjson::Writer
+//   get        : looking up every member of the root (or of the objects in a root array) by the key
+//   save/load  : the binary format of simcc::json::JSONObject, rapidjson has no counterpart
+//
+// The throughput is in MB/s of the JSON text (lookups/s for get), and the allocations
+// per document are the calls to the global operator new plus the calls to the allocator
+// of rapidjson. The blocks of a simcc::qh::Pool come from malloc and are not counted,
+// the 'simcc/pool' rows show the cost of parsing into a reused pool.
+
+#include "simcc/inner_pre.h"
+#include "simcc/json/json.h"
+#include "simcc/qh_palloc.h"
+#include "simcc/timestamp.h"
+#include "simcc/file_util.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+size_t g_allocations = 0;
+}
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw() {
+    ++g_allocations;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& nt) throw() {
+    return ::operator new(size, nt);
+}
+
+void operator delete(void* p) throw() {
+    free(p);
+}
+
+void operator delete[](void* p) throw() {
+    free(p);
+}
+
+void operator delete(void* p, size_t) throw() {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) throw() {
+    free(p);
+}
+
+namespace {
+
+// The same as rapidjson::CrtAllocator, but every allocation is counted
+class CountingAllocator : public rapidjson::CrtAllocator {
+public:
+    void* Malloc(size_t size) {
+        if (size) {
+            ++g_allocations;
+        }
+        return rapidjson::CrtAllocator::Malloc(size);
+    }
+
+    void* Realloc(void* p, size_t old_size, size_t new_size) {
+        if (new_size) {
+            ++g_allocations;
+        }
+        return rapidjson::CrtAllocator::Realloc(p, old_size, new_size);
+    }
+};
+
+typedef rapidjson::MemoryPoolAllocator<CountingAllocator> RapidAllocator;
+typedef rapidjson::GenericDocument<rapidjson::UTF8<>, RapidAllocator, CountingAllocator> RapidDocument;
+typedef rapidjson::GenericValue<rapidjson::UTF8<>, RapidAllocator> RapidValue;
+typedef rapidjson::GenericStringBuffer<rapidjson::UTF8<>, CountingAllocator> RapidStringBuffer;
+
+struct Corpus {
+    std::string name;
+    std::string text;
+};
+
+struct Result {
+    double per_second; // documents per second
+    double allocations; // per document
+};
+
+double g_seconds = 0.5;
+
+// Run f until g_seconds elapsed, after a warm-up run
+template<class F>
+Result Measure(F f) {
+    f();
+
+    size_t count = 0;
+    size_t allocations = g_allocations;
+    simcc::Timestamp start = simcc::Timestamp::Now();
+    double elapsed = 0;
+    do {
+        for (int i = 0; i < 4; ++i) {
+            f();
+        }
+        count += 4;
+        elapsed = (simcc::Timestamp::Now() - start).Seconds();
+    } while (elapsed < g_seconds);
+
+    Result r;
+    r.per_second = count / elapsed;
+    r.allocations = static_cast<double>(g_allocations - allocations) / count;
+    return r;
+}
+
+void Report(const Corpus& c, const char* lib, const char* op, double bytes, const Result& r) {
+    printf("%-30s %10u %-12s %-10s %10.1f MB/s %12.1f allocs/doc\n",
+           c.name.c_str(), static_cast<unsigned>(c.text.size()), lib, op,
+           r.per_second * bytes / (1024 * 1024), r.allocations);
+}
+
+void ReportLookups(const Corpus& c, const char* lib, size_t lookups, const Result& r) {
+    printf("%-30s %10u %-12s %-10s %10.2f M/s  %12.1f allocs/doc\n",
+           c.name.c_str(), static_cast<unsigned>(c.text.size()), lib, "get",
+           r.per_second * lookups / 1000000, r.allocations);
+}
+
+void ReportNA(const Corpus& c, const char* lib, const char* op) {
+    printf("%-30s %10u %-12s %-10s %15s\n", c.name.c_str(), static_cast<unsigned>(c.text.size()), lib, op, "n/a");
+}
+
+size_t g_sink = 0; // Keeps the results alive
+
+void BenchmarkSimcc(const Corpus& c) {
+    using namespace simcc::json;
+    ObjectPtr root = JSONParser::Load(c.text.data(), c.text.size());
+    assert(root);
+
+    Result r = Measure([&c]() {
+        ObjectPtr o = JSONParser::Load(c.text.data(), c.text.size());
+        g_sink += o->type();
+    });
+    Report(c, "simcc", "parse", c.text.size(), r);
+
+    simcc::qh::Pool pool(4096);
+    r = Measure([&c, &pool]() {
+        {
+            ObjectPtr o = JSONParser::Load(c.text.data(), c.text.size(), &pool);
+            g_sink += o->type();
+        }
+        pool.reset();
+    });
+    Report(c, "simcc/pool", "parse", c.text.size(), r);
+
+    std::string s;
+    JSONWriter::Serialize(*root, s, false);
+    double text_size = static_cast<double>(s.size());
+    r = Measure([&root, &s]() {
+        s.clear();
+        JSONWriter::Serialize(*root, s, false);
+        g_sink += s.size();
+    });
+    Report(c, "simcc", "serialize", text_size, r);
+
+    std::vector<std::pair<JSONObject*, std::string> > keys;
+    if (root->type() == kJSONObject) {
+        JSONObject* jo = static_cast<JSONObject*>(root.get());
+        for (auto it = jo->begin(), ite = jo->end(); it != ite; ++it) {
+            keys.push_back(std::make_pair(jo, std::string(it->first)));
+        }
+    } else if (root->type() == kJSONArray) {
+        JSONArray* ja = static_cast<JSONArray*>(root.get());
+        for (auto it = ja->begin(), ite = ja->end(); it != ite; ++it) {
+            if ((*it)->type() == kJSONObject) {
+                JSONObject* jo = static_cast<JSONObject*>(it->get());
+                for (auto m = jo->begin(), me = jo->end(); m != me; ++m) {
+                    keys.push_back(std::make_pair(jo, std::string(m->first)));
+                }
+            }
+        }
+    }
+
+    if (keys.empty()) {
+        ReportNA(c, "simcc", "get");
+    } else {
+        r = Measure([&keys]() {
+            for (size_t i = 0; i < keys.size(); ++i) {
+                g_sink += (keys[i].first->Get(keys[i].second) != NULL);
+            }
+        });
+        ReportLookups(c, "simcc", keys.size(), r);
+    }
+
+    // The binary format only serializes a JSONObject
+    JSONObject wrapper;
+    JSONObject* jo = NULL;
+    if (root->type() == kJSONObject) {
+        jo = static_cast<JSONObject*>(root.get());
+    } else {
+        wrapper.Put("root", root);
+        jo = &wrapper;
+    }
+
+    simcc::DataStream bin;
+    r = Measure([jo, &bin]() {
+        bin.Reset();
+        bin << *jo;
+        g_sink += bin.size();
+    });
+    Report(c, "simcc", "save", c.text.size(), r);
+
+    r = Measure([&bin]() {
+        bin.seekg(-static_cast<simcc::int32>(bin.tellg()));
+        JSONObject loaded;
+        bin >> loaded;
+        assert(loaded.ok());
+        g_sink += loaded.size();
+    });
+    Report(c, "simcc", "load", c.text.size(), r);
+}
+
+void BenchmarkRapidJSON(const Corpus& c) {
+    RapidDocument root;
+    root.Parse(c.text.c_str());
+    assert(!root.HasParseError());
+
+    Result r = Measure([&c]() {
+        RapidDocument doc;
+        doc.Parse(c.text.c_str());
+        g_sink += doc.GetType();
+    });
+    Report(c, "rapidjson", "parse", c.text.size(), r);
+
+    RapidStringBuffer s;
+    rapidjson::Writer<RapidStringBuffer, rapidjson::UTF8<>, rapidjson::UTF8<>, CountingAllocator> writer(s);
+    root.Accept(writer);
+    double text_size = static_cast<double>(s.GetSize());
+    r = Measure([&root, &s]() {
+        s.Clear();
+        rapidjson::Writer<RapidStringBuffer, rapidjson::UTF8<>, rapidjson::UTF8<>, CountingAllocator> w(s);
+        root.Accept(w);
+        g_sink += s.GetSize();
+    });
+    Report(c, "rapidjson", "serialize", text_size, r);
+
+    std::vector<std::pair<RapidValue*, std::string> > keys;
+    if (root.IsObject()) {
+        for (auto it = root.MemberBegin(), ite = root.MemberEnd(); it != ite; ++it) {
+            keys.push_back(std::make_pair(&root, std::string(it->name.GetString(), it->name.GetStringLength())));
+        }
+    } else if (root.IsArray()) {
+        for (auto it = root.Begin(), ite = root.End(); it != ite; ++it) {
+            if (it->IsObject()) {
+                for (auto m = it->MemberBegin(), me = it->MemberEnd(); m != me; ++m) {
+                    keys.push_back(std::make_pair(&*it, std::string(m->name.GetString(), m->name.GetStringLength())));
+                }
+            }
+        }
+    }
+
+    if (keys.empty()) {
+        ReportNA(c, "rapidjson", "get");
+    } else {
+        r = Measure([&keys]() {
+            for (size_t i = 0; i < keys.size(); ++i) {
+                RapidValue name(rapidjson::StringRef(keys[i].second.data(), keys[i].second.size()));
+                g_sink += (keys[i].first->FindMember(name) != keys[i].first->MemberEnd());
+            }
+        });
+        ReportLookups(c, "rapidjson", keys.size(), r);
+    }
+
+    ReportNA(c, "rapidjson", "save");
+    ReportNA(c, "rapidjson", "load");
+}
+
+// Both libraries accept the text as a single strict JSON document
+bool IsStrictJSON(const std::string& text) {
+    RapidDocument doc;
+    doc.Parse(text.c_str());
+    return !doc.HasParseError() && simcc::json::JSONParser::Load(text.data(), text.size());
+}
+
+// The JSON lines are joined into an array
+bool LoadCorpus(const std::string& path, Corpus& c) {
+    simcc::DataStream ds;
+    if (!ds.ReadFile(path)) {
+        return false;
+    }
+
+    c.name = simcc::FileUtil::GetFileName(path);
+    c.text.assign(ds.data(), ds.size());
+    if (IsStrictJSON(c.text)) {
+        return true;
+    }
+
+    std::string lines = "[";
+    size_t begin = 0;
+    while (begin < c.text.size()) {
+        size_t end = c.text.find('\n', begin);
+        if (end == std::string::npos) {
+            end = c.text.size();
+        }
+
+        std::string line = c.text.substr(begin, end - begin);
+        begin = end + 1;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+
+        if (!IsStrictJSON(line)) {
+            return false;
+        }
+
+        if (lines.size() > 1) {
+            lines += ',';
+        }
+        lines += line;
+    }
+
+    lines += ']';
+    c.name += "(lines)";
+    c.text.swap(lines);
+    return true;
+}
+
+// A deterministic pseudo random number generator
+class Random {
+public:
+    explicit Random(simcc::uint32 seed) : seed_(seed) {}
+    simcc::uint32 Next(simcc::uint32 n) {
+        seed_ = seed_ * 1103515245 + 12345;
+        return (seed_ >> 8) % n;
+    }
+private:
+    simcc::uint32 seed_;
+};
+
+std::string RandomText(Random& r, size_t len) {
+    static const char* parts[] = {
+        "simcc", "json", " ", "\\\"", "\\\\", "\\n", "\\t", "\\u4e2d\\u6587", "\xe4\xb8\xad\xe6\x96\x87", "http:\\/\\/www.360.cn\\/", "0123456789"
+    };
+
+    std::string s;
+    while (s.size() < len) {
+        s += parts[r.Next(H_ARRAYSIZE(parts))];
+    }
+    return s;
+}
+
+// A record like the ones of the online services
+void AppendRecord(Random& r, size_t id, std::string& s) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "{\"id\":%u,\"key\":\"%08x%08x\",\"score\":%u.%03u,\"enabled\":%s,\"parent\":null,",
+             static_cast<unsigned>(id), r.Next(0x7fffffff), r.Next(0x7fffffff), r.Next(100000), r.Next(1000),
+             r.Next(2) ? "true" : "false");
+    s += buf;
+    s += "\"title\":\"" + RandomText(r, 16 + r.Next(48)) + "\",";
+    s += "\"tags\":[";
+    for (simcc::uint32 i = 0, n = r.Next(6); i < n; ++i) {
+        s += (i ? ",\"" : "\"") + RandomText(r, 4 + r.Next(8)) + "\"";
+    }
+    snprintf(buf, sizeof(buf), "],\"location\":{\"lat\":%d.%06u,\"lng\":%d.%06u,\"level\":%u}}",
+             static_cast<int>(r.Next(180)) - 90, r.Next(1000000), static_cast<int>(r.Next(360)) - 180, r.Next(1000000), r.Next(20));
+    s += buf;
+}
+
+Corpus GenerateRecords(const char* name, size_t size) {
+    Random r(static_cast<simcc::uint32>(size));
+    Corpus c;
+    c.name = name;
+    c.text = "[";
+    for (size_t id = 0; c.text.size() < size; ++id) {
+        if (id > 0) {
+            c.text += ',';
+        }
+        AppendRecord(r, id, c.text);
+    }
+    c.text += ']';
+    return c;
+}
+
+Corpus GenerateObject(const char* name, size_t members) {
+    Random r(static_cast<simcc::uint32>(members));
+    Corpus c;
+    c.name = name;
+    c.text = "{";
+    for (size_t i = 0; i < members; ++i) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%s\"member_%u_%u\":", i ? "," : "", static_cast<unsigned>(i), r.Next(100000));
+        c.text += buf;
+        AppendRecord(r, i, c.text);
+    }
+    c.text += '}';
+    return c;
+}
+
+Corpus GenerateNumbers(const char* name, size_t size) {
+    Random r(static_cast<simcc::uint32>(size));
+    Corpus c;
+    c.name = name;
+    c.text = "[";
+    while (c.text.size() < size) {
+        char buf[64];
+        switch (r.Next(3)) {
+        case 0:
+            snprintf(buf, sizeof(buf), "%d,", static_cast<int>(r.Next(0x7fffffff)) - 0x3fffffff);
+            break;
+        case 1:
+            snprintf(buf, sizeof(buf), "%u.%u,", r.Next(100000), r.Next(100000));
+            break;
+        default:
+            snprintf(buf, sizeof(buf), "%u.%ue%d,", r.Next(10), r.Next(100000), static_cast<int>(r.Next(600)) - 300);
+            break;
+        }
+        c.text += buf;
+    }
+    c.text[c.text.size() - 1] = ']';
+    return c;
+}
+
+Corpus GenerateStrings(const char* name, size_t size) {
+    Random r(static_cast<simcc::uint32>(size));
+    Corpus c;
+    c.name = name;
+    c.text = "[";
+    while (c.text.size() < size) {
+        c.text += "\"" + RandomText(r, r.Next(256)) + "\",";
+    }
+    c.text[c.text.size() - 1] = ']';
+    return c;
+}
+}
+
+int main(int argc, char* argv[]) {
+    std::string dir = argc > 1 ? argv[1] : "../test/test_data/json";
+    if (argc > 2) {
+        g_seconds = atof(argv[2]);
+    }
+
+    std::vector<Corpus> corpora;
+    corpora.push_back(GenerateObject("small-generated", 1));
+    corpora.push_back(GenerateObject("small-generated-members", 32));
+
+    static const char* files[] = {
+        "unicode.json.txt", "mid_json.txt", "gbk-chinese.json.txt",
+        "browser_relative2.json", "common_conf.json",
+    };
+    for (size_t i = 0; i < H_ARRAYSIZE(files); ++i) {
+        Corpus c;
+        std::string path = dir + "/" + files[i];
+        if (LoadCorpus(path, c)) {
+            corpora.push_back(c);
+        } else {
+            fprintf(stderr, "skip %s: not found or not strict JSON\n", path.c_str());
+        }
+    }
+
+    corpora.push_back(GenerateObject("medium-generated-members", 2000));
+    corpora.push_back(GenerateRecords("large-generated-records", 4 << 20));
+    corpora.push_back(GenerateNumbers("large-generated-numbers", 2 << 20));
+    corpora.push_back(GenerateStrings("large-generated-strings", 2 << 20));
+
+    printf("%-30s %10s %-12s %-10s %15s %23s\n", "corpus", "bytes", "library", "operation", "throughput", "allocations");
+    for (size_t i = 0; i < corpora.size(); ++i) {
+        if (!IsStrictJSON(corpora[i].text)) {
+            fprintf(stderr, "skip %s: failed to parse\n", corpora[i].name.c_str());
+            continue;
+        }
+
+        BenchmarkSimcc(corpora[i]);
+        BenchmarkRapidJSON(corpora[i]);
+    }
+
+    return g_sink == 0 ? 1 : 0;
+}
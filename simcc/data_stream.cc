@@ -89,7 +89,7 @@ bool DataStream::ReadFile(/*const string& strFileName*/ const string& strPathNam
     fclose(pf);
 
     assert(remain == 0);
-    seekp((int32)capacity_);
+    write_index_ = capacity_;
 
     return true;
 }
@@ -139,13 +139,44 @@ bool DataStream::WriteFile(const string& filepath) {
     size_t writen = fwrite(buffer_, 1, write_index_, fp);
     fclose(fp);
 
-    if (writen < (uint32)write_index_) {
+    if (writen < write_index_) {
         return false;
     }
 
     return true;
 }
 
+bool DataStream::Reallocate(size_t new_capacity) {
+    uint8* new_buffer = NULL;
+    if (self_created_) {
+        // realloc may grow a huge buffer in place without copying the data
+        new_buffer = (uint8*)realloc(buffer_, new_capacity);
+    } else {
+        new_buffer = (uint8*)malloc(new_capacity);
+        if (new_buffer && buffer_) {
+            memcpy(new_buffer, buffer_, std::min(capacity_, new_capacity));
+        }
+    }
+
+    if (!new_buffer) {
+        return false;
+    }
+
+    buffer_ = new_buffer;
+    capacity_ = new_capacity;
+    self_created_ = true;
+    return true;
+}
+
+bool DataStream::ShrinkToFit() {
+    size_t new_capacity = write_index_ + 1;
+    if (!self_created_ || !buffer_ || new_capacity >= capacity_) {
+        return true;
+    }
+
+    return Reallocate(new_capacity);
+}
+
 bool DataStream::IsContentEquals(const DataStream& first, const DataStream& second) {
     size_t sz = first.size();
     if (sz != second.size()) {
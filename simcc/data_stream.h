@@ -119,6 +119,18 @@ public:
     //   and set the reading and writing flag as kReadBad and kWriteBad
     bool Reserve(size_t size);
 
+    // Sets how the buffer grows when it is not large enough to hold more data.
+    // The new capacity is the required size multiplied by growth_factor,
+    // but at most max_growth bytes more than the required size if max_growth is not 0.
+    // The default policy is 1.5 without limit, 1.0 allocates the required size only.
+    // @note A limit keeps a huge stream, e.g. a multi-GB snapshot, from wasting half of its size
+    void SetGrowthPolicy(double growth_factor, size_t max_growth = 0);
+
+    // Release the unused capacity of the buffer, a spare byte after the data is kept.
+    // @note The outside memory which is not created by this instance is kept
+    // @return false if failed to reallocate the buffer, the data is not changed
+    bool ShrinkToFit();
+
     // Get the total length of data in byte which has been written into this stream
     size_t size() const {
         return tellp();
@@ -127,6 +139,11 @@ public:
         return reinterpret_cast<const char*>(GetCache());
     }
 
+    // Get the size of the buffer which has been allocated
+    size_t capacity() const {
+        return capacity_;
+    }
+
     // get the buffer base address pointer, don't delete the returned pointer
     void* GetCache() const;
 
@@ -134,7 +151,7 @@ public:
     uint8 CharAt(size_t index) const;
 
     // Returns the number of bytes of the unread portion of the buffer
-    uint32 GetReadableSize() const;
+    size_t GetReadableSize() const;
 
     // Gets buffer pointer to the current read position.
     void* GetCurrentReadBuffer() const;
@@ -149,7 +166,7 @@ public:
 
     // Expand size of memory to the current stack.
     // if it failed we SetStatus(kReadBad | kWriteBad) and return false.
-    bool Expand(uint32 nSizeToAdd);
+    bool Expand(size_t nSizeToAdd);
 
     static bool IsContentEquals(const DataStream& first, const DataStream& second);
 
@@ -165,10 +182,10 @@ public:
     // or at the end of stream buffer if the result exceeded the end
     //
     // @param  offset: the offset to move
-    DataStream& seekg(int32 offset);
+    DataStream& seekg(int64 offset);
 
     // get current read position
-    uint32 tellg()const;
+    size_t tellg()const;
 
     // Move the stream pointer for write
     // @remark   after seek, the write pointer' position is at the stream buffer' base address + start + offset,
@@ -177,14 +194,21 @@ public:
     //
     // @param  offset: the offset to move
     //      if offset < 0, this function doesn't case about write_index_
-    DataStream& seekp(int32 offset);
+    DataStream& seekp(int64 offset);
 
     // get current write position
-    uint32 tellp()const;
+    size_t tellp()const;
     
     bool reserve(size_t size);
 
 private:
+    // Moves the data to a buffer of new_capacity bytes which is created by this instance
+    bool Reallocate(size_t new_capacity);
+
+    // The lengths are serialized as uint32,
+    // a longer one sets kWriteBad and writes nothing
+    bool WriteLength(size_t len);
+
     template< typename T>
     DataStream& InternalWriteType(const T& val, std::true_type);
 
@@ -254,10 +278,12 @@ public:
 private:
     uint8_t* buffer_;   // Buffer to hold all the data. It can expand when it is wrote and is not large enough to hold more data.
     bool self_created_;   // Whether the buffer is created by this instance itself.
-    uint32_t capacity_;   // Size of buffer_.
-    uint32_t write_index_;  // Current write data cursor in the buffer.
-    uint32_t read_index_;   // Current read data cursor in the buffer.
+    size_t capacity_;   // Size of buffer_.
+    size_t write_index_;  // Current write data cursor in the buffer.
+    size_t read_index_;   // Current read data cursor in the buffer.
     uint32_t status_;   // status of the file.
+    double growth_factor_; // See SetGrowthPolicy
+    size_t max_growth_;
 
 private:
     // Hide copy constructor
@@ -9,6 +9,8 @@ inline void DataStream::Swap(DataStream& r) {
     std::swap(write_index_ , r.write_index_);
     std::swap(read_index_ , r.read_index_);
     std::swap(status_ , r.status_);
+    std::swap(growth_factor_ , r.growth_factor_);
+    std::swap(max_growth_ , r.max_growth_);
 }
 
 #pragma pack(push,1)
@@ -98,7 +100,9 @@ inline DataStream::DataStream()
     , capacity_(0)
     , write_index_(0)
     , read_index_(0)
-    , status_(0) {
+    , status_(0)
+    , growth_factor_(1.5)
+    , max_growth_(0) {
 
 }
 
@@ -107,7 +111,9 @@ inline DataStream::DataStream(size_t nBufferSize)
     , capacity_(nBufferSize)
     , write_index_(0)
     , read_index_(0)
-    , status_(0) {
+    , status_(0)
+    , growth_factor_(1.5)
+    , max_growth_(0) {
     buffer_ = (uint8*)malloc(capacity_);
 
     if (!buffer_) {
@@ -121,7 +127,9 @@ inline DataStream::DataStream(void* pData, size_t nBufferSize, bool bDestroy)
     , capacity_(nBufferSize)
     , write_index_(0)
     , read_index_(0)
-    , status_(0) {
+    , status_(0)
+    , growth_factor_(1.5)
+    , max_growth_(0) {
 }
 
 inline DataStream::~DataStream() {
@@ -150,16 +158,14 @@ inline bool DataStream::Read(void* buf, size_t buf_len) {
         return false;
     }
 
-    uint32 nNewPos = read_index_ + buf_len;
-
-    if (nNewPos > (uint32)write_index_) {
+    if (buf_len > write_index_ - read_index_) {
         SetStatus(kReadBad);
         return false;
     }
 
     memcpy(buf, buffer_ + read_index_, buf_len);
 
-    read_index_ = nNewPos;
+    read_index_ += buf_len;
 
     return true;
 }
@@ -210,10 +216,10 @@ inline bool DataStream::Write(const void* buf, size_t buf_len) {
     return true;
 }
 
-inline DataStream& DataStream::seekg(int32 offset) {
-    int32 nNewPos = read_index_ + offset;
+inline DataStream& DataStream::seekg(int64 offset) {
+    int64 nNewPos = (int64)read_index_ + offset;
 
-    if (nNewPos > (int32)write_index_) {
+    if (nNewPos > (int64)write_index_) {
         read_index_ = write_index_;
         SetStatus(kReadBad);
 
@@ -228,19 +234,19 @@ inline DataStream& DataStream::seekg(int32 offset) {
     return *this;
 }
 
-inline uint32 DataStream::tellg() const {
+inline size_t DataStream::tellg() const {
     return read_index_;
 }
 
-inline DataStream& DataStream::seekp(int32 offset) {
-    int64 new_pos = (int32)write_index_ + offset;
+inline DataStream& DataStream::seekp(int64 offset) {
+    int64 new_pos = (int64)write_index_ + offset;
 
     if (new_pos < 0) {
         write_index_ = 0;
     } else {
         // pre-allocate size.
         if (new_pos > (simcc::int64)write_index_) {
-            if (!Expand((uint32)new_pos - write_index_)) {
+            if (!Expand((size_t)new_pos - write_index_)) {
                 return *this;
             }
         }
@@ -252,7 +258,7 @@ inline DataStream& DataStream::seekp(int32 offset) {
     return *this;
 }
 
-inline uint32 DataStream::tellp() const {
+inline size_t DataStream::tellp() const {
     return write_index_;
 }
 
@@ -280,8 +286,8 @@ inline uint8 DataStream::CharAt(size_t index) const {
     return *((int8*)GetCache() + index);
 }
 
-inline simcc::uint32 DataStream::GetReadableSize() const {
-    return size() - (uint32)tellg();
+inline size_t DataStream::GetReadableSize() const {
+    return size() - tellg();
 }
 
 inline void* DataStream::GetCurrentReadBuffer() const {
@@ -300,7 +306,7 @@ inline void DataStream::Reset() {
 inline bool DataStream::Resize(size_t nSize) {
     // check size and assure enough buffer.
     if (nSize > capacity_) {
-        if (!Expand(nSize + capacity_)) {
+        if (!Expand(nSize - write_index_)) {
             return false;
         }
     } else if (nSize == 0) {
@@ -318,32 +324,31 @@ inline bool DataStream::Resize(size_t nSize) {
 }
 
 
-inline bool DataStream::Expand(uint32 delta) {
-    uint32 new_size = write_index_ + delta + 1;
+inline bool DataStream::Expand(size_t delta) {
+    size_t new_size = write_index_ + delta + 1;
 
     // only if buffer is no sufficient, we reallocate it.
-    if (new_size > (uint32)capacity_) {
-        new_size = new_size + (new_size >> 1);
-
-        uint8* new_buffer = (uint8*)malloc(new_size);
-
-        if (!new_buffer) {
+    if (new_size > capacity_) {
+        if (new_size <= write_index_) {
+            // overflow
             SetStatus(kReadBad | kWriteBad);
             return false;
         }
 
-        if (buffer_) {
-            memcpy(new_buffer, buffer_, capacity_);
+        // grow by the policy, see SetGrowthPolicy
+        size_t extra = (size_t)(new_size * (growth_factor_ - 1));
+        if (max_growth_ > 0 && extra > max_growth_) {
+            extra = max_growth_;
         }
 
-
-        if (self_created_) {
-            free(buffer_);
+        if (new_size + extra > new_size) {
+            new_size += extra;
         }
 
-        buffer_ = new_buffer;
-        capacity_ = new_size;
-        self_created_ = true;
+        if (!Reallocate(new_size)) {
+            SetStatus(kReadBad | kWriteBad);
+            return false;
+        }
     }
 
     return true;
@@ -352,29 +357,28 @@ inline bool DataStream::Expand(uint32 delta) {
 
 inline bool DataStream::Reserve(size_t new_size) {
     if (new_size > capacity_) {
-        uint8* new_buf = (uint8*)malloc(new_size);
-
-        if (!new_buf) {
+        if (!Reallocate(new_size)) {
             SetStatus(kReadBad | kWriteBad);
             return false;
         }
+    }
 
-        capacity_ = new_size;
-
-        if (buffer_) {
-            memcpy(new_buf, buffer_, write_index_);
-        }
-
+    return true;
+}
 
-        if (self_created_) {
-            // the old buffer is created by myself, so free it
-            free(buffer_);
-        }
+inline void DataStream::SetGrowthPolicy(double growth_factor, size_t max_growth) {
+    assert(growth_factor >= 1.0);
+    growth_factor_ = growth_factor < 1.0 ? 1.0 : growth_factor;
+    max_growth_ = max_growth;
+}
 
-        buffer_ = new_buf;
-        self_created_ = true;
+inline bool DataStream::WriteLength(size_t len) {
+    if (len > 0xffffffffu) {
+        SetStatus(kWriteBad);
+        return false;
     }
 
+    *this << (uint32)len;
     return true;
 }
 
@@ -394,11 +398,13 @@ DataStream& simcc::DataStream::InternalReadType(T& val, std::true_type) {
 template< typename _Kt >
 DataStream& simcc::DataStream::InternalWriteVector(const std::vector< _Kt >& val, std::true_type) {
     // 1. write length
-    *this << uint32(val.size());
+    if (!WriteLength(val.size())) {
+        return *this;
+    }
 
     // 2. memory
     if (!val.empty()) {
-        this->write(&(val[0]), uint32(sizeof(_Kt) * val.size()));
+        this->write(&(val[0]), sizeof(_Kt) * val.size());
     }
     return *this;
 }
@@ -444,13 +450,13 @@ DataStream& simcc::DataStream::operator >> (T& val) {
 }
 
 inline simcc::DataStream& DataStream::operator<<(const string& val) {
-    uint32_t nStrLen = (uint32)val.length();
-
     // 1. write string length
-    *this << nStrLen;
+    if (!WriteLength(val.length())) {
+        return *this;
+    }
 
     // 2. write string
-    Write(val.c_str(), (uint32)nStrLen);
+    Write(val.c_str(), val.length());
 
     return *this;
 }
@@ -460,10 +466,12 @@ inline simcc::DataStream& DataStream::operator<<(const char* szVal) {
         return *this;
     }
 
-    uint32 nStrLen = (uint32)strlen(szVal);
+    size_t nStrLen = strlen(szVal);
 
     // 1. write string length
-    *this << (uint32&)nStrLen;
+    if (!WriteLength(nStrLen)) {
+        return *this;
+    }
 
     // 2. write string
     Write(szVal, nStrLen);
@@ -482,7 +490,7 @@ inline simcc::DataStream& DataStream::operator >> (string& val) {
     *this >> (uint32&)nSize;
 
     // 2. get file
-    if (nSize <= (uint32)GetReadableSize()) {
+    if (nSize <= GetReadableSize()) {
         val.resize(nSize);
 
         if (nSize) {
@@ -501,7 +509,9 @@ inline simcc::DataStream& DataStream::operator >> (string& val) {
 
 inline simcc::DataStream& DataStream::operator<<(const DataStream& val) {
     // 1. write string length
-    *this << (uint32)val.size();
+    if (!WriteLength(val.size())) {
+        return *this;
+    }
 
     // 2. write string
     if (val.size() > 0) {
@@ -526,7 +536,7 @@ inline simcc::DataStream& DataStream::operator >> (DataStream& val) {
         return *this;
     }
 
-    if (nSize <= (uint32)GetReadableSize()) {
+    if (nSize <= GetReadableSize()) {
         // 2. read string
         val.Write(((char*)GetCache() + tellg()), nSize);
 
@@ -555,7 +565,9 @@ inline DataStream& DataStream::operator<<(const std::vector< _Kt>& val) {
 
 template< typename _Kt >
 inline DataStream& DataStream::operator<<(const std::list< _Kt>& val) {
-    *this << (uint32)val.size();
+    if (!WriteLength(val.size())) {
+        return *this;
+    }
 
     auto it(val.begin()), ite(val.end());
     for (; it != ite; ++it) {
@@ -574,7 +586,9 @@ inline DataStream& DataStream::operator<<(const std::pair<_Kt, _Val>& val) {
 template<  typename _Kt, typename _Val >
 inline DataStream& DataStream::operator<<(const std::map< _Kt, _Val >& val) {
     // 1. write length
-    *this << (uint32)val.size();
+    if (!WriteLength(val.size())) {
+        return *this;
+    }
 
     // 2. elements.
     auto it(val.begin()), ite(val.end());
@@ -651,7 +665,9 @@ inline DataStream& DataStream::operator >> (std::list< _Kt>& val) {
 
 template< typename _Kt >
 inline DataStream& DataStream::operator<<(const list< _Kt>& val) {
-    *this << (uint32)val.size();
+    if (!WriteLength(val.size())) {
+        return *this;
+    }
 
     auto it(val.begin()), ite(val.end());
     for (; it != ite; ++it) {
@@ -701,7 +717,9 @@ inline DataStream& DataStream::operator >> (std::vector< _Kt>& val) {
 
 template<class T>
 inline DataStream& DataStream::operator<<(const std::set<T>& val) {
-    (*this) << (simcc::uint32)val.size();
+    if (!WriteLength(val.size())) {
+        return *this;
+    }
 
     typedef typename std::set<T>::const_iterator Iterator;
     Iterator end = val.end();
@@ -741,7 +759,9 @@ inline DataStream& DataStream::operator >> (std::set<T>& val) {
 template< typename _Kt, typename _Val >
 DataStream& DataStream::operator<<(const std::unordered_map<_Kt, _Val>& val) {
     // 1. write length
-    *this << (uint32)val.size();
+    if (!WriteLength(val.size())) {
+        return *this;
+    }
 
     // 2. elements.
     auto it(val.begin()), ite(val.end());
@@ -1,14 +1,23 @@
 #include "simcc/inner_pre.h"
 #include "simcc/file_util.h"
+#include "simcc/mapped_file.h"
+#include "simcc/timestamp.h"
+#include "simcc/misc/crc32.h"
 
 #include "inherited_conf_json.h"
 #include "json_cast.h"
 
+#include <algorithm>
+#include <sys/stat.h>
+
 namespace simcc {
 namespace json {
 
 static const string kInheritedFrom = "inherited_from";
 
+// The max granularity of the file timestamps, e.g. 2 seconds of FAT
+static const simcc::int64 kTimestampGranularity = 2 * 1000 * 1000 * 1000LL;
+
 // @brief õ·ʵ·
 // @param[in] - const string & inherited_from_file_path
 // @return - string
@@ -19,6 +28,9 @@ static string GetRealPath(const string& parent_file_path, const string& inherite
 
     string dir, filename;
     simcc::FileUtil::SplitFileName(parent_file_path, filename, dir);
+    if (dir.empty()) {
+        return inherited_from_file_path; // Join("", path) gives "/path"
+    }
     return simcc::FileUtil::Join(dir, inherited_from_file_path);
 }
 
@@ -38,5 +50,168 @@ JSONObjectPtr InheritedConfJSONObject::Parse(const string& json_file_path) {
     jconf->Merge(jconf_inherited.get(), false);
     return jconf;
 }
+
+// A copy of the whole tree, nothing is shared with <code>o</code>
+static ObjectPtr DeepCopy(const Object* o) {
+    switch (o->type()) {
+    case kJSONObject: {
+        const JSONObject* jo = static_cast<const JSONObject*>(o);
+        JSONObject* copy = new JSONObject;
+        for (auto it = jo->begin(), ite = jo->end(); it != ite; ++it) {
+            copy->GetObjects()[it->first] = DeepCopy(it->second.get());
+        }
+        return copy;
+    }
+    case kJSONArray: {
+        const JSONArray* ja = static_cast<const JSONArray*>(o);
+        JSONArray* copy = new JSONArray;
+        copy->reserve(ja->size());
+        for (auto it = ja->begin(), ite = ja->end(); it != ite; ++it) {
+            copy->Put(DeepCopy(it->get()));
+        }
+        return copy;
+    }
+    case kJSONString:
+        return new JSONString(static_cast<const JSONString*>(o)->value());
+    case kJSONStringView:
+        return new JSONString(static_cast<const JSONStringView*>(o)->slice().ToString());
+    case kJSONInteger:
+        return new JSONInteger(static_cast<const JSONInteger*>(o)->value());
+    case kJSONDouble:
+        return new JSONDouble(static_cast<const JSONDouble*>(o)->value());
+    case kJSONBoolean:
+        return new JSONBoolean(static_cast<const JSONBoolean*>(o)->value());
+    default:
+        return new JSONNull;
+    }
+}
+
+bool InheritedConfLoader::Stat(const string& path, FileStat& st) {
+    struct stat s;
+    if (::stat(path.c_str(), &s) != 0) {
+        return false;
+    }
+
+    const simcc::int64 kNanosecondsPerSecond = 1000 * 1000 * 1000;
+#if defined(H_OS_WINDOWS)
+    st.mtime = static_cast<simcc::int64>(s.st_mtime) * kNanosecondsPerSecond;
+    st.ctime = static_cast<simcc::int64>(s.st_ctime) * kNanosecondsPerSecond;
+#elif defined(__APPLE__)
+    st.mtime = static_cast<simcc::int64>(s.st_mtimespec.tv_sec) * kNanosecondsPerSecond + s.st_mtimespec.tv_nsec;
+    st.ctime = static_cast<simcc::int64>(s.st_ctimespec.tv_sec) * kNanosecondsPerSecond + s.st_ctimespec.tv_nsec;
+#else
+    st.mtime = static_cast<simcc::int64>(s.st_mtim.tv_sec) * kNanosecondsPerSecond + s.st_mtim.tv_nsec;
+    st.ctime = static_cast<simcc::int64>(s.st_ctim.tv_sec) * kNanosecondsPerSecond + s.st_ctim.tv_nsec;
+#endif
+    st.size = static_cast<simcc::int64>(s.st_size);
+    st.inode = static_cast<simcc::uint64>(s.st_ino);
+    return true;
+}
+
+// Like the racy git entries, a file modified again in the same timestamp
+// tick as the version which was read keeps its stat
+bool InheritedConfLoader::IsRewritten(const string& path, Entry& e) {
+    if (e.checked - std::max(e.stat.mtime, e.stat.ctime) >= kTimestampGranularity) {
+        return false;
+    }
+
+    simcc::int64 now = simcc::Timestamp::Now().UnixNano();
+    simcc::MappedFile f;
+    if (!f.Open(path, simcc::MappedFile::kSequential)
+            || CRC32::Sum(f.data(), f.size()) != e.crc) {
+        return true;
+    }
+
+    e.checked = now;
+    return false;
+}
+
+JSONObjectPtr InheritedConfLoader::Load(const string& json_file_path) {
+    JSONObjectPtr jconf;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<string> loading;
+        jconf = Get(json_file_path, loading);
+    }
+
+    if (!jconf) {
+        return JSONObjectPtr();
+    }
+
+    // The cached config is never changed, the caller gets a copy of the whole tree
+    ObjectPtr copy = DeepCopy(jconf.get());
+    return cast<JSONObject>(copy);
+}
+
+JSONObjectPtr InheritedConfLoader::Get(const string& path, std::vector<string>& loading) {
+    FileStat st;
+    if (!Stat(path, st)) {
+        cache_.erase(path);
+        return JSONObjectPtr();
+    }
+
+    if (std::find(loading.begin(), loading.end(), path) != loading.end()) {
+        return JSONObjectPtr();
+    }
+
+    loading.push_back(path);
+    JSONObjectPtr jconf = Resolve(path, st, loading);
+    loading.pop_back();
+    return jconf;
+}
+
+JSONObjectPtr InheritedConfLoader::Resolve(const string& path, const FileStat& st, std::vector<string>& loading) {
+    std::map<string, Entry>::iterator it = cache_.find(path);
+    if (it != cache_.end() && it->second.stat == st && !IsRewritten(path, it->second)) {
+        if (it->second.parent_path.empty()) {
+            return it->second.conf;
+        }
+
+        // Valid if the default config is not reloaded.
+        // The entry may be changed by Get, so the path is copied
+        string parent_path = it->second.parent_path;
+        JSONObjectPtr parent = Get(parent_path, loading);
+        it = cache_.find(path);
+        if (parent && it != cache_.end() && parent == it->second.parent) {
+            return it->second.conf;
+        }
+    }
+
+    Entry e;
+    e.stat = st;
+    e.checked = simcc::Timestamp::Now().UnixNano();
+    simcc::MappedFile f;
+    ObjectPtr jbase;
+    if (f.Open(path, simcc::MappedFile::kSequential)) {
+        e.crc = CRC32::Sum(f.data(), f.size());
+        jbase = JSONParser::Load(f.data(), f.size());
+    }
+
+    if (!jbase || !jbase->IsTypeOf(kJSONObject)) {
+        cache_.erase(path);
+        return JSONObjectPtr();
+    }
+
+    e.conf = cast<JSONObject>(jbase);
+    string inherited_from_file = e.conf->GetString(kInheritedFrom);
+    if (!inherited_from_file.empty()) {
+        e.parent_path = GetRealPath(path, inherited_from_file);
+        e.parent = Get(e.parent_path, loading);
+        e.conf->Merge(e.parent.get(), false);
+    }
+
+    cache_[path] = e;
+    return e.conf;
+}
+
+void InheritedConfLoader::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.clear();
+}
+
+size_t InheritedConfLoader::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cache_.size();
+}
 }
 }
\ No newline at end of file
@@ -14,6 +14,10 @@
 #include "json_array.h"
 #include "json_object.h"
 
+#include <map>
+#include <mutex>
+#include <vector>
+
 namespace simcc {
 namespace json {
 class SIMCC_EXPORT InheritedConfJSONObject {
@@ -24,8 +28,76 @@ public:
     // ǰļеḲĬͬkey
     // @param[in] - const string& json_file_path
     // @return - json::JSONObjectPtr ʧܻ᷵һն
+    // @note The inherited values are shared with the default config (see JSONObject::Merge),
+    //   use JSONObject::GetMutableJSONObject to modify a nested object.
     static json::JSONObjectPtr Parse(const string& json_file_path);
 };
 
+// A loader of the inherited configs which caches the parsed configs.
+// A cached config is reused by the later Load calls until its file or any
+// of its default configs is changed, so the default configs shared by many
+// configs are read and parsed only once.
+//   A file is taken as changed when its modification or change time (in
+// nanoseconds), size or inode is changed, e.g. it is rewritten or replaced
+// by a rename. A file read within 2 seconds of its modification may be
+// rewritten without changing them, so its content is compared then.
+//
+// It is thread-safe.
+//
+// Usage:
+//    InheritedConfLoader loader;
+//    for each config path:
+//        JSONObjectPtr conf = loader.Load(path);
+class SIMCC_EXPORT InheritedConfLoader {
+public:
+    // The same as InheritedConfJSONObject::Parse
+    // @note The returned object is a deep copy of the cached one, so it
+    //   can be modified freely.
+    json::JSONObjectPtr Load(const string& json_file_path);
+
+    // Drop all the cached configs
+    void Clear();
+
+    // The number of the cached configs
+    size_t size() const;
+
+private:
+    struct FileStat {
+        simcc::int64 mtime; // In nanoseconds
+        simcc::int64 ctime; // In nanoseconds
+        simcc::int64 size;
+        simcc::uint64 inode;
+
+        bool operator==(const FileStat& rhs) const {
+            return mtime == rhs.mtime && ctime == rhs.ctime && size == rhs.size && inode == rhs.inode;
+        }
+    };
+
+    struct Entry {
+        FileStat stat;
+        simcc::uint32 crc; // The CRC32 of the file content
+        simcc::int64 checked; // When the content was read or compared, in nanoseconds
+        string parent_path; // The resolved path of "inherited_from"
+        json::JSONObjectPtr parent; // The default config when it is merged
+        json::JSONObjectPtr conf;
+    };
+
+    static bool Stat(const string& path, FileStat& st);
+
+    // @return true if the file may be rewritten after it was read without
+    //   changing its stat, and its content is changed
+    static bool IsRewritten(const string& path, Entry& e);
+
+    // @param loading the configs being loaded, to stop an inheritance loop
+    json::JSONObjectPtr Get(const string& path, std::vector<string>& loading);
+
+    // Get the cached config if it is valid, or parse it
+    json::JSONObjectPtr Resolve(const string& path, const FileStat& st, std::vector<string>& loading);
+
+private:
+    mutable std::mutex mutex_;
+    std::map<string, Entry> cache_;
+};
+
 }
 }
\ No newline at end of file
@@ -9,3 +9,12 @@
 #include "json_array.h"
 #include "json_object.h"
 #include "inherited_conf_json.h"
+#include "json_sax.h"
+#include "json_key.h"
+#include "json_lazy.h"
+#include "json_pointer.h"
+#include "json_push_parser.h"
+#include "json_lines.h"
+#include "json_snapshot.h"
+#include "json_writer.h"
+#include "json_binding.h"
@@ -31,7 +31,7 @@ simcc::uint32 JSONArray::Parse(const string& source) {
 
 simcc::uint32 JSONArray::Parse(const char* source, const simcc::int64 len) {
     if (len == 0 || !source) {
-        set_error(kParameterWrong);
+        set_error(JSONParser::kParameterWrong);
         return 0;
     }
 
@@ -39,9 +39,45 @@ simcc::uint32 JSONArray::Parse(const char* source, const simcc::int64 len) {
     return Parse(&x);
 }
 
+simcc::uint32 JSONArray::ParseInSitu(const char* source, const simcc::int64 len) {
+    if (len == 0 || !source) {
+        set_error(JSONParser::kParameterWrong);
+        return 0;
+    }
+
+    JSONTokener x(source, len);
+    x.set_in_situ(true);
+    return Parse(&x);
+}
+
 simcc::uint32 JSONArray::Parse(JSONTokener* x) {
+    JSONParser parser;
+    simcc::uint32 n = Parse(x, &parser);
+    if (parser.ok()) {
+        parser_.reset();
+    } else {
+        set_error(parser.error(), parser.error_location());
+    }
+    return n;
+}
+
+void JSONArray::set_error(JSONParser::ErrorCode ec, size_t error_location) {
+    if (!parser_) {
+        parser_.reset(new JSONParser);
+    }
+    parser_->set_error(ec, error_location);
+}
+
+const char* JSONArray::strerror() const {
+    if (parser_) {
+        return parser_->strerror();
+    }
+    return JSONParser().strerror();
+}
+
+simcc::uint32 JSONArray::Parse(JSONTokener* x, JSONParser* parser) {
     if (!x->SkipComment()) {
-        set_error(kCommentFormatError, x);
+        parser->set_error(JSONParser::kCommentFormatError, x);
         return 0;
     }
 
@@ -52,12 +88,12 @@ simcc::uint32 JSONArray::Parse(JSONTokener* x) {
     } else if (c == '(') {
         q = ')';
     } else {
-        set_error(kJSONArrayNotBeginWithBrackets, x);
+        parser->set_error(JSONParser::kJSONArrayNotBeginWithBrackets, x);
         return 0;
     }
 
     if (!x->SkipComment()) {
-        set_error(kCommentFormatError, x);
+        parser->set_error(JSONParser::kCommentFormatError, x);
         return 0;
     }
 
@@ -70,17 +106,22 @@ simcc::uint32 JSONArray::Parse(JSONTokener* x) {
     Object* jo = NULL;
     for (;;) {
         if (!x->SkipComment()) {
-            set_error(kCommentFormatError, x);
+            parser->set_error(JSONParser::kCommentFormatError, x);
             return 0;
         }
 
         c = x->NextClean();
         if (c == ',') {
             x->Back();
-            list_.push_back(new JSONNull());
+            Object* jnull = Object::New<JSONNull>(x->pool());
+            if (!jnull) {
+                parser->set_error(JSONParser::kOutOfMemory, x->GetCurrentPosition());
+                return 0;
+            }
+            list_.push_back(jnull);
         } else {
             x->Back();
-            jo = x->NextValue(this);
+            jo = x->NextValue(parser);
             if (jo) {
                 list_.push_back(jo);
             } else {
@@ -89,7 +130,7 @@ simcc::uint32 JSONArray::Parse(JSONTokener* x) {
         }
 
         if (!x->SkipComment()) {
-            set_error(kCommentFormatError, x);
+            parser->set_error(JSONParser::kCommentFormatError, x);
             return 0;
         }
 
@@ -99,7 +140,7 @@ simcc::uint32 JSONArray::Parse(JSONTokener* x) {
         case ';':
         case ',':
             if (!x->SkipComment()) {
-                set_error(kCommentFormatError, x);
+                parser->set_error(JSONParser::kCommentFormatError, x);
                 return 0;
             }
 
@@ -113,12 +154,12 @@ simcc::uint32 JSONArray::Parse(JSONTokener* x) {
         case ']':
         case ')':
             if (q != c) {
-                set_error(kJSONArrayNotEndWithBrackets, x);
+                parser->set_error(JSONParser::kJSONArrayNotEndWithBrackets, x);
                 return 0;
             }
             return x->GetCurrentPosition();
         default:
-            set_error(kJSONArrayNotEndWithBrackets, x);
+            parser->set_error(JSONParser::kJSONArrayNotEndWithBrackets, x);
             return 0;
         }
     }
@@ -172,15 +213,8 @@ void JSONArray::ToStringBuf(simcc::DataStream& sb, size_t indent, bool utf8_to_u
 }
 
 void JSONArray::ToString(string& s, bool readable, bool utf8_to_unicode)const {
-    buf_.Reset();
-    size_t indent = 0;
-
-    if (readable) {
-        indent = 1;
-    }
-
-    ToStringBuf(buf_, indent, utf8_to_unicode);
-    s.assign(buf_.data(), buf_.size());
+    s.clear();
+    JSONWriter::Serialize(*this, s, readable, utf8_to_unicode);
 }
 
 bool JSONArray::Equals(const Object& rhs) {
@@ -255,6 +289,10 @@ JSONString* JSONArray::GetJSONString(int index) const {
     return GetObject<JSONString>(index);
 }
 
+JSONStringView* JSONArray::GetJSONStringView(int index) const {
+    return GetObject<JSONStringView>(index);
+}
+
 
 bool JSONArray::IsNull(int index) const {
     const_iterator it = begin(index);
@@ -301,6 +339,45 @@ JSONArray* JSONArray::Put(const ObjectPtr& value) {
     return Put(value.get());
 }
 
+template<class U, class T>
+JSONArray* JSONArray::PutElements(const T* value, simcc::uint32 count) {
+    typedef typename ToJSONType<U>::JSONClass JSONClass;
+
+    list_.reserve(list_.size() + count);
+    for (simcc::uint32 i = 0; i < count; ++i) {
+        list_.push_back(new JSONClass(static_cast<U>(value[i])));
+    }
+    return this;
+}
+
+JSONArray* JSONArray::PutByteArray(const simcc::int8* value, simcc::uint32 count) {
+    return PutElements<simcc::int64>(value, count);
+}
+
+JSONArray* JSONArray::PutInt32Array(const simcc::int32* value, simcc::uint32 count) {
+    return PutElements<simcc::int64>(value, count);
+}
+
+JSONArray* JSONArray::PutInt64Array(const simcc::int64* value, simcc::uint32 count) {
+    return PutElements<simcc::int64>(value, count);
+}
+
+JSONArray* JSONArray::PutFloat32Array(const simcc::float32* value, simcc::uint32 count) {
+    return PutElements<simcc::float64>(value, count);
+}
+
+JSONArray* JSONArray::PutFloat64Array(const simcc::float64* value, simcc::uint32 count) {
+    return PutElements<simcc::float64>(value, count);
+}
+
+JSONArray* JSONArray::PutBoolArray(const bool* value, simcc::uint32 count) {
+    return PutElements<bool>(value, count);
+}
+
+JSONArray* JSONArray::PutStringArray(const string* value, simcc::uint32 count) {
+    return PutElements<string>(value, count);
+}
+
 template<class T>
 const T& JSONArray::GetElement(int index , const T& default_value)const {
     typedef typename ToJSONType<T>::JSONClass JSONClass;
@@ -346,6 +423,20 @@ simcc::float64 JSONArray::GetDecimal(int index, float64 default_value) const {
     return default_value;
 }
 
+Slice JSONArray::GetSlice(int index, const Slice& default_value) const {
+    Object* o = Get(index);
+    if (o) {
+        if (o->IsTypeOf(kJSONStringView)) {
+            return ((JSONStringView*)o)->slice();
+        }
+
+        if (o->IsTypeOf(kJSONString)) {
+            return Slice(((JSONString*)o)->value());
+        }
+    }
+    return default_value;
+}
+
 template<class T, class U>
 void JSONArray::GetElement(T* array , uint32 count, const U& default_value)const {
     for (simcc::uint32 i = 0; i < count; ++ i) {
@@ -429,9 +520,7 @@ JSONArray::const_iterator JSONArray::begin(size_t index) const {
         return list_.end();
     }
 
-    const_iterator it = list_.begin();
-    std::advance(it, index);
-    return it;
+    return list_.begin() + index;
 }
 
 JSONArray::iterator JSONArray::begin(size_t index) {
@@ -439,9 +528,7 @@ JSONArray::iterator JSONArray::begin(size_t index) {
         return list_.end();
     }
 
-    iterator it = list_.begin();
-    std::advance(it, index);
-    return it;
+    return list_.begin() + index;
 }
 
 void JSONArray::SaveTo(simcc::DataStream& file) const {
@@ -449,8 +536,8 @@ void JSONArray::SaveTo(simcc::DataStream& file) const {
     file << (simcc::uint8)type()  //type
          << (simcc::uint32)nSize; //size
 
-    for (simcc::uint32 i = 0; i < nSize; i++) {
-        Get(i)->SaveTo(file);
+    for (const_iterator it(list_.begin()), ite(list_.end()); it != ite; ++it) {
+        (*it)->SaveTo(file);
     }
 }
 
@@ -458,6 +545,8 @@ bool JSONArray::LoadFrom(simcc::DataStream& file) {
     simcc::uint32 nSize = 0;
     file >> nSize;
 
+    // Every element takes one byte at least, so don't trust a broken nSize
+    list_.reserve(std::min<size_t>(nSize, file.GetReadableSize()));
     for (simcc::uint32 i = 0; i < nSize; i++) {
         Object* o = NULL;
         if (Object::DeserializeOneObject(file, o)) {
@@ -3,7 +3,9 @@
 #pragma once
 
 #include "simcc/inner_pre.h"
-#include "simcc/gcc_list.h"
+
+#include <vector>
+#include <memory>
 
 #include "json_common.h"
 #include "json_value.h"
@@ -15,12 +17,15 @@ namespace json {
 // A JSONArray is an ordered sequence of values. Its external text form is a
 // string wrapped in square brackets with commas separating the values. The
 // internal form is an object.
+//
+// The elements are stored in a std::vector, so the random access by index
+// is O(1).
 
 class JSONObject;
 class JSONTokener;
-class SIMCC_EXPORT JSONArray : public Object, public JSONParser {
+class SIMCC_EXPORT JSONArray : public Object, public JSONErrorCodes {
 public:
-    typedef simcc::list<ObjectPtr>                ObjectPtrList;
+    typedef std::vector<ObjectPtr>                ObjectPtrList;
     typedef ObjectPtrList::iterator               iterator;
     typedef ObjectPtrList::const_iterator         const_iterator;
     typedef ObjectPtrList::reverse_iterator       reverse_iterator;
@@ -49,6 +54,29 @@ public:
     // @return number of characters parsed. Return 0 if failed to parse.
     uint32 Parse(const char* source, const int64 source_len = -1);
 
+    // The same as Parse, but the strings without escapes are not copied,
+    // they are JSONStringView objects which refer to the source text.
+    // @note The source text MUST outlive this JSONArray
+    uint32 ParseInSitu(const char* source, const int64 source_len = -1);
+
+    // The error of the last Parse or ParseInSitu of this object.
+    //   The parse state lives in a JSONParser during parsing, and it is only
+    // kept here when the parsing failed, so the objects of a document
+    // don't carry it.
+    JSONParser::ErrorCode error() const {
+        return parser_ ? parser_->error() : JSONParser::kNoError;
+    }
+
+    const char* strerror() const;
+
+    bool ok() const {
+        return error() == JSONParser::kNoError;
+    }
+
+    size_t error_location() const {
+        return parser_ ? parser_->error_location() : 0;
+    }
+
     // Get the object value associated with an index.
     // @param index
     //  The index must be between 0 and length() - 1.
@@ -59,6 +87,7 @@ public:
     JSONDouble*  GetJSONDouble(int index) const;
     JSONInteger* GetJSONInteger(int index) const;
     JSONString*  GetJSONString(int index) const;
+    JSONStringView* GetJSONStringView(int index) const;
     JSONArray*   GetJSONArray(int index) const;
     JSONObject*  GetJSONObject(int index) const;
 
@@ -77,6 +106,10 @@ public:
     // Get a decimal number whether it is a JSONDouble or a JSONInteger
     float64 GetDecimal(int index, float64 default_value = 0.0)const;
 
+    // Get a string whether it is a JSONString or a JSONStringView, no copy is made.
+    // It is invalidated by any modification of the string.
+    Slice GetSlice(int index, const Slice& default_value = Slice())const;
+
     // Gets an array.
     // @param strKey, the key
     // @param array[out] the result is stored
@@ -116,6 +149,20 @@ public:
     JSONArray* Put(Object* value); // Do not delete this pointer, it will be managed by this JSONArray
     JSONArray* Put(const ObjectPtr& value);
 
+    // Append all the values of an array.
+    // The storage is reserved once for all the <code>count</code> elements.
+    //
+    // @param value the value array
+    // @param count Size of array
+    // @return this.
+    JSONArray* PutByteArray(const simcc::int8* value, simcc::uint32 count);
+    JSONArray* PutInt32Array(const simcc::int32* value, simcc::uint32 count);
+    JSONArray* PutInt64Array(const simcc::int64* value, simcc::uint32 count);
+    JSONArray* PutFloat32Array(const simcc::float32* value, simcc::uint32 count);
+    JSONArray* PutFloat64Array(const simcc::float64* value, simcc::uint32 count);
+    JSONArray* PutBoolArray(const bool* value, simcc::uint32 count);
+    JSONArray* PutStringArray(const string* value, simcc::uint32 count);
+
     // Remove a index and close the hole.
     // @param index The index of the element to be removed.
     // @return true if remove the element success
@@ -136,6 +183,11 @@ public:
         return list_.erase(it);
     }
 
+    // Requests that the capacity be at least enough to contain n elements.
+    void reserve(size_t n) {
+        list_.reserve(n);
+    }
+
     // Get the number of elements in the JSONArray, included nulls.
     // @return The length (or size).
     size_t size() const {
@@ -207,6 +259,9 @@ protected:
 
     // @return number of characters parsed. Return 0 if failed to parse.
     simcc::uint32 Parse(JSONTokener* token);
+
+    // Parse a (nested) array, the error is reported to <code>parser</code>
+    simcc::uint32 Parse(JSONTokener* token, JSONParser* parser);
     JSONArray(JSONTokener* token);
 
     // Construct a JSONArray from a source JSON text string.
@@ -227,13 +282,20 @@ protected:
     template<class T, class U>
     void GetElement(std::vector<T>& vec, const U& default_value)const;
 
+    // U is the value type of the json object, e.g. int64 for JSONInteger
+    template<class U, class T>
+    JSONArray* PutElements(const T* value, simcc::uint32 count);
+
 private:
     // override method from base class json::Object
     virtual bool LoadFrom(simcc::DataStream& file);
     virtual void SaveTo(simcc::DataStream& file) const;
 
+    void set_error(JSONParser::ErrorCode ec, size_t error_location = 0);
+
 private:
     ObjectPtrList list_; // The list where the JSONArray's properties are kept.
+    std::unique_ptr<JSONParser> parser_; // NULL unless the last parsing failed
 
     template<class T>
     T* GetObject(int index) const;
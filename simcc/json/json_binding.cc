@@ -0,0 +1,248 @@
+#include "simcc/inner_pre.h"
+
+#include "json.h"
+#include "json_binding.h"
+#include "json_tokener.h"
+#include "json_dtoa_inl.h"
+
+#include <cmath>
+
+namespace simcc {
+namespace json {
+
+simcc::uint32 JSONBinder::DoParse(const char* source, const simcc::int64 source_len, void* value, ReadFunc read) {
+    if (source_len == 0 || !source) {
+        set_error(kParameterWrong);
+        return 0;
+    }
+
+    JSONTokener x(source, source_len);
+    return DoParse(&x, value, read);
+}
+
+simcc::uint32 JSONBinder::DoParse(JSONTokener* x, void* value, ReadFunc read) {
+    set_error(kNoError, static_cast<size_t>(0));
+    if (!read(*this, x, value)) {
+        return 0;
+    }
+
+    return x->GetCurrentPosition();
+}
+
+bool JSONBinder::NextChar(JSONTokener* x, char& c) {
+    if (!x->SkipComment()) {
+        set_error(kCommentFormatError, x);
+        return false;
+    }
+
+    c = x->NextClean();
+    return true;
+}
+
+bool JSONBinder::ReadScalar(JSONTokener* x, char c, JSONScalar& v) {
+    Slice text;
+    return ReadScalar(x, c, v, text);
+}
+
+bool JSONBinder::ReadScalar(JSONTokener* x, char c, JSONScalar& v, Slice& text) {
+    switch (c) {
+    case '"':
+    case '\'':
+    case '{':
+    case '[':
+    case '(':
+        set_error(kTypeMismatch, x);
+        return false;
+    default:
+        break;
+    }
+
+    text = x->NextUnquotedText(c);
+    if (text.empty()) {
+        set_error(kBlankValue, x);
+        return false;
+    }
+
+    return JSONObject::ConvertToScalar(text.data(), text.size(), this, x, v);
+}
+
+bool JSONBinder::ParseUInteger(const Slice& text, simcc::uint64& u) {
+    const simcc::uint64 kMax = std::numeric_limits<simcc::uint64>::max();
+    if (text.empty() || (text[0] == '0' && text.size() > 1)) {
+        return false;
+    }
+
+    u = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+
+        simcc::uint64 d = static_cast<simcc::uint64>(text[i] - '0');
+        if (u > (kMax - d) / 10) {
+            return false; // overflow
+        }
+        u = u * 10 + d;
+    }
+    return true;
+}
+
+bool JSONBinder::ReadNull(JSONTokener* x, char c) {
+    JSONScalar v;
+    if (!ReadScalar(x, c, v)) {
+        return false;
+    }
+
+    if (v.type != kJSONNull) {
+        set_error(kTypeMismatch, x);
+        return false;
+    }
+    return true;
+}
+
+bool JSONBinder::ReadString(JSONTokener* x, char quote, Slice& s) {
+    if (!x->NextString(quote, false, s)) {
+        set_error(kJSONStringNotQuoted, x->GetCurrentPosition());
+        return false;
+    }
+    return true;
+}
+
+bool JSONBinder::NextMember(JSONTokener* x, bool first, Slice& key, bool& end) {
+    char c = 0;
+    if (!NextChar(x, c)) {
+        return false;
+    }
+
+    // pairs are separated by ',', and a ',' before the '}' is allowed
+    if (!first) {
+        if (c == ',') {
+            if (!NextChar(x, c)) {
+                return false;
+            }
+        } else if (c != '}' && c != 0) {
+            set_error(kInvalidCharacter, x);
+            return false;
+        }
+    }
+
+    switch (c) {
+    case 0:
+        set_error(kJSONObjectNotEndWithBraces, x);
+        return false;
+    case '}':
+        end = true;
+        return true;
+    case '"':   // a key must be a string
+        if (!x->NextString('"', false, key)) {
+            set_error(kJSONObjectKeyNotString, x);
+            return false;
+        }
+        break;
+    default:
+        set_error(kInvalidCharacter, x);
+        return false;
+    }
+
+    // The key is followed by ':'
+    if (!NextChar(x, c)) {
+        return false;
+    }
+
+    if (c != ':') {
+        set_error(kKeyValueSeperatorError, x);
+        return false;
+    }
+
+    end = false;
+    return true;
+}
+
+bool JSONBinder::NextElement(JSONTokener* x, char close, bool first, bool& end, bool& blank) {
+    char c = 0;
+    if (!NextChar(x, c)) {
+        return false;
+    }
+
+    // elements are separated by ',' or ';', and a separator before the close bracket is allowed
+    if (!first && c != close) {
+        if (c != ',' && c != ';') {
+            set_error(kJSONArrayNotEndWithBrackets, x);
+            return false;
+        }
+
+        if (!NextChar(x, c)) {
+            return false;
+        }
+    }
+
+    if (c == close) {
+        end = true;
+        return true;
+    }
+
+    if (c == 0) {
+        set_error(kJSONArrayNotEndWithBrackets, x);
+        return false;
+    }
+
+    x->Back();
+    end = false;
+    blank = (c == ',' || c == ';');
+    return true;
+}
+
+bool JSONBinder::SkipValue(JSONTokener* x) {
+    if (!x->SkipValue()) {
+        set_error(kInvalidCharacter, x);
+        return false;
+    }
+    return true;
+}
+
+void JSONBinder::SetTypeMismatch(JSONTokener* x) {
+    set_error(kTypeMismatch, x);
+}
+
+void JSONBinder::WriteBool(bool b, simcc::DataStream& ds) {
+    if (b) {
+        ds.Write("true", 4);
+    } else {
+        ds.Write("false", 5);
+    }
+}
+
+void JSONBinder::WriteInteger(simcc::int64 i, simcc::DataStream& ds) {
+    char buf[dtoa::kInt64MaxLen + 1];
+    ds.Write(buf, dtoa::i64toa(i, buf) - buf);
+}
+
+void JSONBinder::WriteUInteger(simcc::uint64 i, simcc::DataStream& ds) {
+    char buf[dtoa::kInt64MaxLen + 1];
+    ds.Write(buf, dtoa::u64toa(i, buf) - buf);
+}
+
+// The same as JSONDouble, NaN and Infinity are written as null
+void JSONBinder::WriteDouble(simcc::float64 d, simcc::DataStream& ds) {
+    if (!std::isfinite(d)) {
+        ds.Write("null", 4);
+        return;
+    }
+
+    char buf[dtoa::kDoubleMaxLen];
+    ds.Write(buf, dtoa::dtoa(d, buf) - buf);
+}
+
+void JSONBinder::WriteString(const char* s, size_t len, bool utf8_to_unicode, simcc::DataStream& ds) {
+    JSONObject::Quote(s, len, utf8_to_unicode, ds);
+}
+
+string JSONBinder::QuoteName(const char* name, size_t len, bool utf8_to_unicode) {
+    simcc::DataStream ds;
+    WriteString(name, len, utf8_to_unicode, ds);
+    ds.Write(':');
+    return string(ds.data(), ds.size());
+}
+
+}
+}
@@ -0,0 +1,514 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+#include "simcc/data_stream.h"
+
+#include "json_common.h"
+#include "json_parser.h"
+
+#include <limits>
+#include <map>
+#include <type_traits>
+#include <vector>
+
+namespace simcc {
+namespace json {
+
+// The conversion between the json text and a C++ type. It is specialized
+// for bool, the integers, the floating points, string, std::vector and
+// std::map<string, T>. The primary template handles the structs bound by
+// H_JSON_BIND.
+template<class T, class Enable = void>
+struct JSONCodec;
+
+// A parser which reads the json text into the C++ structs directly, and
+// a serializer which writes the structs into a DataStream directly.
+// No json object is created in both ways.
+//
+// The members of a struct are bound to the json keys by H_JSON_BIND, and
+// the struct is then used the same as the other types, e.g. as a member
+// of another struct or the element of a std::vector.
+//
+// It accepts the same json text as JSONSAXParser. When parsing:
+//   - the unknown keys are skipped
+//   - the members which are missing or null keep their values
+//   - a value which can't be stored in its member is an error (kTypeMismatch),
+//     e.g. a string for an integer, or 300 for a simcc::uint8
+//
+// Usage:
+//    namespace rpc {
+//    struct User {
+//        simcc::int64 id;
+//        string name;
+//        std::vector<string> tags;
+//    };
+//    H_JSON_BIND(User, H_JSON_FIELD(id), H_JSON_FIELD_AS("user_name", name), H_JSON_FIELD(tags))
+//    }
+//
+//    rpc::User u;
+//    JSONBinder b;
+//    if (!b.Parse(text, text_len, u)) {
+//        printf("%s\n", b.strerror());
+//    }
+//    simcc::DataStream ds;
+//    JSONBinder::Serialize(u, ds);
+class SIMCC_EXPORT JSONBinder : public JSONParser {
+public:
+    // Parse the source JSON text into <code>value</code>
+    // @param source A string of JSON format text
+    // @param source_len, the length of the source string.
+    // @return number of characters parsed. Return 0 if failed to parse.
+    template<class T>
+    simcc::uint32 Parse(const char* source, const simcc::int64 source_len, T& value);
+
+    template<class T>
+    simcc::uint32 Parse(JSONTokener* x, T& value);
+
+    // Append the compact json text of <code>value</code> to <code>ds</code>.
+    // The members of a struct are written in the order they are bound.
+    template<class T>
+    static void Serialize(const T& value, simcc::DataStream& ds, bool utf8_to_unicode = true);
+
+    template<class T>
+    static string ToString(const T& value, bool utf8_to_unicode = true);
+
+public:
+    // The building blocks of JSONCodec
+
+    // Get the next character after the spaces and comments
+    bool NextChar(JSONTokener* x, char& c);
+
+    // Read a number, boolean or null which starts with <code>c</code>
+    bool ReadScalar(JSONTokener* x, char c, JSONScalar& v);
+
+    // The same as ReadScalar, and <code>text</code> is the text of the scalar
+    bool ReadScalar(JSONTokener* x, char c, JSONScalar& v, Slice& text);
+
+    // Parse a decimal integer in [0, UINT64_MAX]. It is used for the
+    // integers above INT64_MAX, which ReadScalar reads as doubles.
+    static bool ParseUInteger(const Slice& text, simcc::uint64& u);
+
+    // Read a null which starts with <code>c</code>, any other value is a kTypeMismatch
+    bool ReadNull(JSONTokener* x, char c);
+
+    // Read a string after the open quote
+    // @note The slice is only valid before the next string is read
+    bool ReadString(JSONTokener* x, char quote, Slice& s);
+
+    // Move to the next member of an object whose '{' is read
+    // @param first true for the first member
+    // @param key[out] the key of the member, and the ':' is read
+    // @param end[out] true if the object is ended
+    bool NextMember(JSONTokener* x, bool first, Slice& key, bool& end);
+
+    // Move to the next element of an array whose '[' or '(' is read
+    // @param close the close bracket of the array
+    // @param end[out] true if the array is ended
+    // @param blank[out] true if the element is blank, e.g. [1,,2], which is taken as null
+    bool NextElement(JSONTokener* x, char close, bool first, bool& end, bool& blank);
+
+    // Skip the value of an unknown member
+    bool SkipValue(JSONTokener* x);
+
+    void SetTypeMismatch(JSONTokener* x);
+
+    static void WriteBool(bool b, simcc::DataStream& ds);
+    static void WriteInteger(simcc::int64 i, simcc::DataStream& ds);
+    static void WriteUInteger(simcc::uint64 i, simcc::DataStream& ds);
+    static void WriteDouble(simcc::float64 d, simcc::DataStream& ds);
+    static void WriteString(const char* s, size_t len, bool utf8_to_unicode, simcc::DataStream& ds);
+
+    // The text of <code>"name":</code>
+    static string QuoteName(const char* name, size_t len, bool utf8_to_unicode);
+
+private:
+    typedef bool (*ReadFunc)(JSONBinder& b, JSONTokener* x, void* value);
+
+    template<class T>
+    static bool ReadRoot(JSONBinder& b, JSONTokener* x, void* value) {
+        return JSONCodec<T>::Read(b, x, *static_cast<T*>(value));
+    }
+
+    simcc::uint32 DoParse(const char* source, const simcc::int64 source_len, void* value, ReadFunc read);
+    simcc::uint32 DoParse(JSONTokener* x, void* value, ReadFunc read);
+};
+
+// A bound member of the struct S, see H_JSON_BIND
+template<class S>
+struct JSONField {
+    const char* name;
+    size_t name_len;
+    bool (*read)(JSONBinder& b, JSONTokener* x, S& s);
+    void (*write)(const S& s, simcc::DataStream& ds, bool utf8_to_unicode);
+};
+
+template<class S, class T, T S::*M>
+bool ReadJSONField(JSONBinder& b, JSONTokener* x, S& s) {
+    return JSONCodec<T>::Read(b, x, s.*M);
+}
+
+template<class S, class T, T S::*M>
+void WriteJSONField(const S& s, simcc::DataStream& ds, bool utf8_to_unicode) {
+    JSONCodec<T>::Write(s.*M, ds, utf8_to_unicode);
+}
+
+// The bound members of the struct S, which is built once by H_JSON_BIND
+template<class S>
+class JSONFields {
+public:
+    JSONFields(const JSONField<S>* fields, size_t count)
+        : fields_(fields), count_(count) {
+        for (size_t i = 0; i < count; ++i) {
+            quoted_.push_back(JSONBinder::QuoteName(fields[i].name, fields[i].name_len, false));
+            quoted_.push_back(JSONBinder::QuoteName(fields[i].name, fields[i].name_len, true));
+        }
+    }
+
+    size_t size() const {
+        return count_;
+    }
+
+    const JSONField<S>& operator[](size_t i) const {
+        return fields_[i];
+    }
+
+    // The quoted name followed by the ':'
+    const string& quoted_name(size_t i, bool utf8_to_unicode) const {
+        return quoted_[i * 2 + (utf8_to_unicode ? 1 : 0)];
+    }
+
+    // Find the field of a key. The members usually come in the order they are
+    // bound, so the search starts from <code>hint</code>, the field after the
+    // last found one.
+    // @return the index of the field, or size() if it is not found
+    size_t Find(const char* key, size_t len, size_t hint) const {
+        for (size_t n = 0; n < count_; ++n) {
+            size_t i = (hint + n) % count_;
+            if (fields_[i].name_len == len && memcmp(fields_[i].name, key, len) == 0) {
+                return i;
+            }
+        }
+        return count_;
+    }
+
+private:
+    const JSONField<S>* fields_;
+    size_t count_;
+    std::vector<string> quoted_;
+};
+
+// Bind the members of a struct to the json keys. It is used in the namespace
+// of the struct, and the fields are given by H_JSON_FIELD or H_JSON_FIELD_AS.
+#define H_JSON_BIND(Type, ...) \
+    inline const ::simcc::json::JSONFields<Type>& SimccJSONFields(const Type*) { \
+        typedef Type JSONBindType; \
+        static const ::simcc::json::JSONField<Type> fields[] = { __VA_ARGS__ }; \
+        static const ::simcc::json::JSONFields<Type> table(fields, sizeof(fields) / sizeof(fields[0])); \
+        return table; \
+    }
+
+// A member bound to the key of the same name
+#define H_JSON_FIELD(member) H_JSON_FIELD_AS(#member, member)
+
+// A member bound to the key <code>name</code>, which is a string literal
+#define H_JSON_FIELD_AS(name, member) \
+    { name, sizeof(name) - 1, \
+      &::simcc::json::ReadJSONField<JSONBindType, decltype(JSONBindType::member), &JSONBindType::member>, \
+      &::simcc::json::WriteJSONField<JSONBindType, decltype(JSONBindType::member), &JSONBindType::member> }
+
+// The structs bound by H_JSON_BIND, the function SimccJSONFields is found
+// by the argument-dependent lookup.
+template<class T, class Enable>
+struct JSONCodec {
+    static bool Read(JSONBinder& b, JSONTokener* x, T& v) {
+        const JSONFields<T>& fields = SimccJSONFields(static_cast<const T*>(NULL));
+        char c = 0;
+        if (!b.NextChar(x, c)) {
+            return false;
+        }
+
+        if (c != '{') {
+            return b.ReadNull(x, c);
+        }
+
+        Slice key;
+        bool end = false;
+        size_t hint = 0;
+        for (bool first = true;; first = false) {
+            if (!b.NextMember(x, first, key, end)) {
+                return false;
+            }
+
+            if (end) {
+                return true;
+            }
+
+            size_t i = fields.Find(key.data(), key.size(), hint);
+            if (i == fields.size()) {
+                if (!b.SkipValue(x)) {
+                    return false;
+                }
+                continue;
+            }
+
+            if (!fields[i].read(b, x, v)) {
+                return false;
+            }
+            hint = i + 1;
+        }
+    }
+
+    static void Write(const T& v, simcc::DataStream& ds, bool utf8_to_unicode) {
+        const JSONFields<T>& fields = SimccJSONFields(static_cast<const T*>(NULL));
+        ds.Write('{');
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (i > 0) {
+                ds.Write(',');
+            }
+
+            const string& name = fields.quoted_name(i, utf8_to_unicode);
+            ds.Write(name.data(), name.size());
+            fields[i].write(v, ds, utf8_to_unicode);
+        }
+        ds.Write('}');
+    }
+};
+
+template<>
+struct JSONCodec<bool> {
+    static bool Read(JSONBinder& b, JSONTokener* x, bool& v) {
+        char c = 0;
+        JSONScalar s;
+        if (!b.NextChar(x, c) || !b.ReadScalar(x, c, s)) {
+            return false;
+        }
+
+        if (s.type == kJSONBoolean) {
+            v = s.b;
+        } else if (s.type != kJSONNull) {
+            b.SetTypeMismatch(x);
+            return false;
+        }
+        return true;
+    }
+
+    static void Write(bool v, simcc::DataStream& ds, bool /*utf8_to_unicode*/) {
+        JSONBinder::WriteBool(v, ds);
+    }
+};
+
+template<class T>
+struct JSONCodec<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+    static bool InRange(simcc::int64 i) {
+        if (std::numeric_limits<T>::is_signed) {
+            return i >= static_cast<simcc::int64>(std::numeric_limits<T>::min())
+                   && i <= static_cast<simcc::int64>(std::numeric_limits<T>::max());
+        }
+        return i >= 0 && static_cast<simcc::uint64>(i) <= static_cast<simcc::uint64>(std::numeric_limits<T>::max());
+    }
+
+    // An unsigned integer above INT64_MAX, e.g. written by WriteUInteger
+    static bool ReadBig(const JSONScalar& s, const Slice& text, T& v) {
+        simcc::uint64 u = 0;
+        if (std::numeric_limits<T>::is_signed || s.type != kJSONDouble
+                || !JSONBinder::ParseUInteger(text, u)
+                || u > static_cast<simcc::uint64>(std::numeric_limits<T>::max())) {
+            return false;
+        }
+        v = static_cast<T>(u);
+        return true;
+    }
+
+    static bool Read(JSONBinder& b, JSONTokener* x, T& v) {
+        char c = 0;
+        JSONScalar s;
+        Slice text;
+        if (!b.NextChar(x, c) || !b.ReadScalar(x, c, s, text)) {
+            return false;
+        }
+
+        if (s.type == kJSONInteger && InRange(s.i)) {
+            v = static_cast<T>(s.i);
+        } else if (!ReadBig(s, text, v) && s.type != kJSONNull) {
+            b.SetTypeMismatch(x);
+            return false;
+        }
+        return true;
+    }
+
+    static void Write(T v, simcc::DataStream& ds, bool /*utf8_to_unicode*/) {
+        if (std::numeric_limits<T>::is_signed) {
+            JSONBinder::WriteInteger(static_cast<simcc::int64>(v), ds);
+        } else {
+            JSONBinder::WriteUInteger(static_cast<simcc::uint64>(v), ds);
+        }
+    }
+};
+
+// An integer is also accepted by a floating point
+template<class T>
+struct JSONCodec<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static bool Read(JSONBinder& b, JSONTokener* x, T& v) {
+        char c = 0;
+        JSONScalar s;
+        if (!b.NextChar(x, c) || !b.ReadScalar(x, c, s)) {
+            return false;
+        }
+
+        if (s.type == kJSONDouble) {
+            v = static_cast<T>(s.d);
+        } else if (s.type == kJSONInteger) {
+            v = static_cast<T>(s.i);
+        } else if (s.type != kJSONNull) {
+            b.SetTypeMismatch(x);
+            return false;
+        }
+        return true;
+    }
+
+    static void Write(T v, simcc::DataStream& ds, bool /*utf8_to_unicode*/) {
+        JSONBinder::WriteDouble(static_cast<simcc::float64>(v), ds);
+    }
+};
+
+template<>
+struct JSONCodec<string> {
+    static bool Read(JSONBinder& b, JSONTokener* x, string& v) {
+        char c = 0;
+        if (!b.NextChar(x, c)) {
+            return false;
+        }
+
+        if (c != '"' && c != '\'') {
+            return b.ReadNull(x, c);
+        }
+
+        Slice s;
+        if (!b.ReadString(x, c, s)) {
+            return false;
+        }
+        v.assign(s.data(), s.size());
+        return true;
+    }
+
+    static void Write(const string& v, simcc::DataStream& ds, bool utf8_to_unicode) {
+        JSONBinder::WriteString(v.data(), v.size(), utf8_to_unicode, ds);
+    }
+};
+
+// The elements replace the original ones
+template<class T, class A>
+struct JSONCodec<std::vector<T, A> > {
+    static bool Read(JSONBinder& b, JSONTokener* x, std::vector<T, A>& v) {
+        char c = 0;
+        if (!b.NextChar(x, c)) {
+            return false;
+        }
+
+        if (c != '[' && c != '(') {
+            return b.ReadNull(x, c);
+        }
+
+        char close = (c == '[' ? ']' : ')');
+        bool end = false;
+        bool blank = false;
+        v.clear();
+        for (bool first = true;; first = false) {
+            if (!b.NextElement(x, close, first, end, blank)) {
+                return false;
+            }
+
+            if (end) {
+                return true;
+            }
+
+            // Not read in place, the elements of std::vector<bool> are not bool&
+            T e = T();
+            if (!blank && !JSONCodec<T>::Read(b, x, e)) {
+                return false;
+            }
+            v.push_back(std::move(e));
+        }
+    }
+
+    static void Write(const std::vector<T, A>& v, simcc::DataStream& ds, bool utf8_to_unicode) {
+        ds.Write('[');
+        for (typename std::vector<T, A>::const_iterator it = v.begin(), ite = v.end(); it != ite; ++it) {
+            if (it != v.begin()) {
+                ds.Write(',');
+            }
+            JSONCodec<T>::Write(*it, ds, utf8_to_unicode);
+        }
+        ds.Write(']');
+    }
+};
+
+// An object of any keys. The members replace the original ones
+template<class T, class C, class A>
+struct JSONCodec<std::map<string, T, C, A> > {
+    static bool Read(JSONBinder& b, JSONTokener* x, std::map<string, T, C, A>& v) {
+        char c = 0;
+        if (!b.NextChar(x, c)) {
+            return false;
+        }
+
+        if (c != '{') {
+            return b.ReadNull(x, c);
+        }
+
+        Slice key;
+        bool end = false;
+        v.clear();
+        for (bool first = true;; first = false) {
+            if (!b.NextMember(x, first, key, end)) {
+                return false;
+            }
+
+            if (end) {
+                return true;
+            }
+
+            if (!JSONCodec<T>::Read(b, x, v[key.ToString()])) {
+                return false;
+            }
+        }
+    }
+
+    static void Write(const std::map<string, T, C, A>& v, simcc::DataStream& ds, bool utf8_to_unicode) {
+        ds.Write('{');
+        for (typename std::map<string, T, C, A>::const_iterator it = v.begin(), ite = v.end(); it != ite; ++it) {
+            if (it != v.begin()) {
+                ds.Write(',');
+            }
+            JSONBinder::WriteString(it->first.data(), it->first.size(), utf8_to_unicode, ds);
+            ds.Write(':');
+            JSONCodec<T>::Write(it->second, ds, utf8_to_unicode);
+        }
+        ds.Write('}');
+    }
+};
+
+template<class T>
+simcc::uint32 JSONBinder::Parse(const char* source, const simcc::int64 source_len, T& value) {
+    return DoParse(source, source_len, &value, &JSONBinder::ReadRoot<T>);
+}
+
+template<class T>
+simcc::uint32 JSONBinder::Parse(JSONTokener* x, T& value) {
+    return DoParse(x, &value, &JSONBinder::ReadRoot<T>);
+}
+
+template<class T>
+void JSONBinder::Serialize(const T& value, simcc::DataStream& ds, bool utf8_to_unicode) {
+    JSONCodec<T>::Write(value, ds, utf8_to_unicode);
+}
+
+template<class T>
+string JSONBinder::ToString(const T& value, bool utf8_to_unicode) {
+    simcc::DataStream ds;
+    Serialize(value, ds, utf8_to_unicode);
+    return string(ds.data(), ds.size());
+}
+
+}
+}
@@ -1,6 +1,7 @@
 #include "simcc/string_util.h"
 #include "simcc/data_stream.h"
 #include "simcc/utility.h"
+#include "simcc/qh_palloc.h"
 
 #include "json.h"
 
@@ -44,6 +45,40 @@ bool Object::DeserializeOneObject(simcc::DataStream& file, Object*& o) {
     return false;
 }
 
+void Object::Release() const {
+    if (--ref_count_ <= 0) {
+        if (pooled_) {
+            this->~Object();
+        } else {
+            delete this;
+        }
+    }
+}
+
+void Object::Destroy(Object* o) {
+    if (o) {
+        assert(o->RefCount() == 0);
+        o->Ref();
+        o->Release();
+    }
+}
+
+void* Object::operator new(size_t size) {
+    return ::operator new(size);
+}
+
+void* Object::operator new(size_t size, simcc::qh::Pool* pool) throw() {
+    return pool->alloc(size);
+}
+
+void Object::operator delete(void* p) {
+    ::operator delete(p);
+}
+
+void Object::operator delete(void* /*p*/, simcc::qh::Pool* /*pool*/) {
+    // The memory will be reclaimed along with the pool
+}
+
 string Object::ToString(bool readable, bool utf8_to_unicode) const {
     string  retVal;
     this->ToString(retVal, readable, utf8_to_unicode);
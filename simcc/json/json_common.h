@@ -8,6 +8,10 @@
 #include "simcc/data_stream.h"
 
 namespace simcc {
+namespace qh {
+class Pool;
+}
+
 namespace json {
 
 enum JSONType {
@@ -19,6 +23,7 @@ enum JSONType {
     kJSONDouble,  // JSONDouble
     kJSONBoolean, // JSONBoolean
     kJSONNull,    // JSONNull
+    kJSONStringView, // JSONStringView, a string which refers to the source text
 
     kTypeForce = 0xFF // bitwise-and with mask of 0xFF can be optimized by compiler
 };
@@ -27,11 +32,23 @@ class JSONBoolean;
 class JSONInteger;
 class JSONDouble;
 class JSONString;
+class JSONStringView;
 class JSONArray;
 class JSONObject;
 
 class JSONTokener;
 
+// A simple json value which is written as an unquoted text :
+// null, true, false or a number
+struct JSONScalar {
+    JSONType type;
+    union {
+        bool b;
+        simcc::int64 i;
+        simcc::float64 d;
+    };
+};
+
 template<typename _Type> struct ToJSONType;
 
 template<>
@@ -76,16 +93,48 @@ class SIMCC_EXPORT Object : public simcc::RefObject {
 public:
     enum { Type = kUnknownType };
     Object(JSONType e)
-        : type_(e) {}
+        : type_(static_cast<simcc::uint8>(e)), pooled_(false), shared_(false) {}
 
     virtual ~Object() {}
 
     JSONType type() const {
-        return type_;
+        return static_cast<JSONType>(type_);
     }
 
+    // @return true if this object is allocated from a simcc::qh::Pool
+    bool pooled() const {
+        return pooled_;
+    }
+
+    // @return true if this object has been put into another json tree by
+    //   JSONObject::Merge. It is copied before it is modified by Merge or
+    //   returned by JSONObject::GetMutableJSONObject, see Unshare.
+    bool shared() const {
+        return shared_;
+    }
+
+    // Override RefObject::Release. When the object is allocated from a
+    // simcc::qh::Pool we only call the destructor here, the memory is
+    // reclaimed all at once when the pool is reset or destroyed.
+    virtual void Release() const;
+
+    // Create a json object from the memory pool.
+    // If pool is NULL, the object is allocated from the heap as usual.
+    // @return NULL if the memory can't be allocated from the pool,
+    //   the heap allocation throws std::bad_alloc as the operator new does
+    template<class T, class... Args>
+    static T* New(simcc::qh::Pool* pool, Args&&... args);
+
+    // Destroy an object which has not been taken over by any ObjectPtr.
+    static void Destroy(Object* o);
+
+    static void* operator new(size_t size);
+    static void* operator new(size_t size, simcc::qh::Pool* pool) throw();
+    static void operator delete(void* p);
+    static void operator delete(void* p, simcc::qh::Pool* pool);
+
     bool IsTypeOf(JSONType ot) const {
-        return (ot == type_);
+        return (ot == type());
     }
 
     // @brief
@@ -132,7 +181,9 @@ protected:
     static bool DeserializeOneObject(simcc::DataStream& file, Object*& pObject);
 
 private:
-    JSONType  type_;
+    simcc::uint8 type_; // JSONType
+    bool pooled_;
+    std::atomic<bool> shared_; // The trees sharing it may be merged by the different threads
 
 private:
     // we need to access SaveTo, LoadFrom
@@ -140,10 +191,28 @@ private:
     friend class JSONObject;
 
     Object();
+
+    // Replace the object or array <code>o</code> by its copy if it is shared
+    // and still referenced by the others (copy-on-write). The copy is shallow,
+    // its values are marked as shared in turn.
+    static void Unshare(simcc::RefPtr<Object>& o);
 };
 
 typedef simcc::RefPtr<Object> ObjectPtr;
 
+template<class T, class... Args>
+inline T* Object::New(simcc::qh::Pool* pool, Args&&... args) {
+    if (!pool) {
+        return new T(std::forward<Args>(args)...);
+    }
+
+    T* o = new (pool) T(std::forward<Args>(args)...);
+    if (o) {
+        static_cast<Object*>(o)->pooled_ = true;
+    }
+    return o;
+}
+
 }
 }
 
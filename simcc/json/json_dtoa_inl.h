@@ -0,0 +1,449 @@
+#pragma once
+
+/*
+ * Copyright (C) 2015 THL A29 Limited, a Tencent company, and Milo Yip.
+ *
+ * RapidJSON is licensed under the MIT License.
+ * See http://opensource.org/licenses/MIT for details.
+ */
+
+// Copy from rapidjson-1.1.0 include/rapidjson/internal/{diyfp.h,dtoa.h,itoa.h}
+//
+// It is a header-only implementation of Grisu2 algorithm from the publication:
+// Loitsch, Florian. "Printing floating-point numbers quickly and accurately with
+// integers." ACM Sigplan Notices 45.6 (2010): 233-243.
+//
+// Grisu2 always generates digits which can be converted back to the same double,
+// and they are the shortest ones in about 99.9% of the cases.
+
+#include <cmath>
+#include <string.h>
+
+#if defined(_MSC_VER) && defined(_M_AMD64)
+#include <intrin.h>
+#pragma intrinsic(_BitScanReverse64)
+#pragma intrinsic(_umul128)
+#endif
+
+#ifndef UINT64_C
+#define UINT64_C(c) c ## ULL
+#endif
+
+namespace simcc {
+namespace json {
+namespace dtoa {
+
+inline const char* GetDigitsLut() {
+    static const char cDigitsLut[200] = {
+        '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+        '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+        '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+        '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+        '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+        '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+        '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+        '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+        '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+        '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+    };
+    return cDigitsLut;
+}
+
+// The max length of the string generated by u64toa/i64toa
+enum { kInt64MaxLen = 20 };
+
+// Writes the decimal digits of an unsigned integer, two digits a time.
+// @param buffer it must has kInt64MaxLen bytes at least
+// @return the end of the written string, which is not null-terminated
+inline char* u64toa(simcc::uint64 value, char* buffer) {
+    char temp[kInt64MaxLen];
+    char* p = temp;
+    const char* lut = GetDigitsLut();
+    while (value >= 100) {
+        const unsigned i = static_cast<unsigned>(value % 100) << 1;
+        value /= 100;
+        *p++ = lut[i + 1];
+        *p++ = lut[i];
+    }
+
+    if (value < 10) {
+        *p++ = static_cast<char>('0' + value);
+    } else {
+        const unsigned i = static_cast<unsigned>(value) << 1;
+        *p++ = lut[i + 1];
+        *p++ = lut[i];
+    }
+
+    do {
+        *buffer++ = *--p;
+    } while (p != temp);
+
+    return buffer;
+}
+
+inline char* i64toa(simcc::int64 value, char* buffer) {
+    simcc::uint64 u = static_cast<simcc::uint64>(value);
+    if (value < 0) {
+        *buffer++ = '-';
+        u = ~u + 1; // It is right for INT64_MIN too
+    }
+    return u64toa(u, buffer);
+}
+
+struct DiyFp {
+    DiyFp() : f(0), e(0) {}
+
+    DiyFp(simcc::uint64 fp, int exp) : f(fp), e(exp) {}
+
+    explicit DiyFp(double d) {
+        simcc::uint64 u64;
+        memcpy(&u64, &d, sizeof(d));
+
+        int biased_e = static_cast<int>((u64 & kDpExponentMask) >> kDpSignificandSize);
+        simcc::uint64 significand = (u64 & kDpSignificandMask);
+        if (biased_e != 0) {
+            f = significand + kDpHiddenBit;
+            e = biased_e - kDpExponentBias;
+        } else {
+            f = significand;
+            e = kDpMinExponent + 1;
+        }
+    }
+
+    DiyFp operator-(const DiyFp& rhs) const {
+        return DiyFp(f - rhs.f, e);
+    }
+
+    DiyFp operator*(const DiyFp& rhs) const {
+#if defined(_MSC_VER) && defined(_M_AMD64)
+        simcc::uint64 h;
+        simcc::uint64 l = _umul128(f, rhs.f, &h);
+        if (l & (simcc::uint64(1) << 63)) { // rounding
+            h++;
+        }
+        return DiyFp(h, e + rhs.e + 64);
+#elif defined(__GNUC__) && defined(__x86_64__)
+        __extension__ typedef unsigned __int128 uint128;
+        uint128 p = static_cast<uint128>(f) * static_cast<uint128>(rhs.f);
+        simcc::uint64 h = static_cast<simcc::uint64>(p >> 64);
+        simcc::uint64 l = static_cast<simcc::uint64>(p);
+        if (l & (simcc::uint64(1) << 63)) { // rounding
+            h++;
+        }
+        return DiyFp(h, e + rhs.e + 64);
+#else
+        const simcc::uint64 M32 = 0xFFFFFFFF;
+        const simcc::uint64 a = f >> 32;
+        const simcc::uint64 b = f & M32;
+        const simcc::uint64 c = rhs.f >> 32;
+        const simcc::uint64 d = rhs.f & M32;
+        const simcc::uint64 ac = a * c;
+        const simcc::uint64 bc = b * c;
+        const simcc::uint64 ad = a * d;
+        const simcc::uint64 bd = b * d;
+        simcc::uint64 tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+        tmp += 1U << 31;  // mult_round
+        return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
+#endif
+    }
+
+    DiyFp Normalize() const {
+#if defined(_MSC_VER) && defined(_M_AMD64)
+        unsigned long index;
+        _BitScanReverse64(&index, f);
+        return DiyFp(f << (63 - index), e - (63 - index));
+#elif defined(__GNUC__) && __GNUC__ >= 4
+        int s = __builtin_clzll(f);
+        return DiyFp(f << s, e - s);
+#else
+        DiyFp res = *this;
+        while (!(res.f & (static_cast<simcc::uint64>(1) << 63))) {
+            res.f <<= 1;
+            res.e--;
+        }
+        return res;
+#endif
+    }
+
+    DiyFp NormalizeBoundary() const {
+        DiyFp res = *this;
+        while (!(res.f & (kDpHiddenBit << 1))) {
+            res.f <<= 1;
+            res.e--;
+        }
+        res.f <<= (kDiySignificandSize - kDpSignificandSize - 2);
+        res.e = res.e - (kDiySignificandSize - kDpSignificandSize - 2);
+        return res;
+    }
+
+    void NormalizedBoundaries(DiyFp* minus, DiyFp* plus) const {
+        DiyFp pl = DiyFp((f << 1) + 1, e - 1).NormalizeBoundary();
+        DiyFp mi = (f == kDpHiddenBit) ? DiyFp((f << 2) - 1, e - 2) : DiyFp((f << 1) - 1, e - 1);
+        mi.f <<= mi.e - pl.e;
+        mi.e = pl.e;
+        *plus = pl;
+        *minus = mi;
+    }
+
+    enum {
+        kDiySignificandSize = 64,
+        kDpSignificandSize = 52,
+        kDpExponentBias = 0x3FF + kDpSignificandSize,
+        kDpMinExponent = -kDpExponentBias
+    };
+
+    static const simcc::uint64 kDpExponentMask = UINT64_C(0x7FF0000000000000);
+    static const simcc::uint64 kDpSignificandMask = UINT64_C(0x000FFFFFFFFFFFFF);
+    static const simcc::uint64 kDpHiddenBit = UINT64_C(0x0010000000000000);
+
+    simcc::uint64 f;
+    int e;
+};
+
+inline DiyFp GetCachedPower(int e, int* K) {
+    // 10^-348, 10^-340, ..., 10^340
+    static const simcc::uint64 kCachedPowers_F[] = {
+        UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76),
+        UINT64_C(0x8b16fb203055ac76), UINT64_C(0xcf42894a5dce35ea),
+        UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df),
+        UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f),
+        UINT64_C(0xbe5691ef416bd60c), UINT64_C(0x8dd01fad907ffc3c),
+        UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+        UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d),
+        UINT64_C(0x823c12795db6ce57), UINT64_C(0xc21094364dfb5637),
+        UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7),
+        UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5),
+        UINT64_C(0xb23867fb2a35b28e), UINT64_C(0x84c8d4dfd2c63f3b),
+        UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+        UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6),
+        UINT64_C(0xf3e2f893dec3f126), UINT64_C(0xb5b5ada8aaff80b8),
+        UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053),
+        UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd),
+        UINT64_C(0xa6dfbd9fb8e5b88f), UINT64_C(0xf8a95fcf88747d94),
+        UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+        UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac),
+        UINT64_C(0xe45c10c42a2b3b06), UINT64_C(0xaa242499697392d3),
+        UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb),
+        UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c),
+        UINT64_C(0x9c40000000000000), UINT64_C(0xe8d4a51000000000),
+        UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+        UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70),
+        UINT64_C(0xd5d238a4abe98068), UINT64_C(0x9f4f2726179a2245),
+        UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8),
+        UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a),
+        UINT64_C(0x924d692ca61be758), UINT64_C(0xda01ee641a708dea),
+        UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+        UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2),
+        UINT64_C(0xc83553c5c8965d3d), UINT64_C(0x952ab45cfa97a0b3),
+        UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25),
+        UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece),
+        UINT64_C(0x88fcf317f22241e2), UINT64_C(0xcc20ce9bd35c78a5),
+        UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+        UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c),
+        UINT64_C(0xbb764c4ca7a44410), UINT64_C(0x8bab8eefb6409c1a),
+        UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129),
+        UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429),
+        UINT64_C(0x80444b5e7aa7cf85), UINT64_C(0xbf21e44003acdd2d),
+        UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+        UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9),
+        UINT64_C(0xaf87023b9bf0ee6b)
+    };
+    static const simcc::int16 kCachedPowers_E[] = {
+        -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007,  -980,
+         -954,  -927,  -901,  -874,  -847,  -821,  -794,  -768,  -741,  -715,
+         -688,  -661,  -635,  -608,  -582,  -555,  -529,  -502,  -475,  -449,
+         -422,  -396,  -369,  -343,  -316,  -289,  -263,  -236,  -210,  -183,
+         -157,  -130,  -103,   -77,   -50,   -24,     3,    30,    56,    83,
+          109,   136,   162,   189,   216,   242,   269,   295,   322,   348,
+          375,   402,   428,   455,   481,   508,   534,   561,   588,   614,
+          641,   667,   694,   720,   747,   774,   800,   827,   853,   880,
+          907,   933,   960,   986,  1013,  1039,  1066
+    };
+
+    //int k = static_cast<int>(ceil((-61 - e) * 0.30102999566398114)) + 374;
+    double dk = (-61 - e) * 0.30102999566398114 + 347;  // dk must be positive, so can do ceiling in positive
+    int k = static_cast<int>(dk);
+    if (dk - k > 0.0) {
+        k++;
+    }
+
+    unsigned index = static_cast<unsigned>((k >> 3) + 1);
+    *K = -(-348 + static_cast<int>(index << 3));    // decimal exponent no need lookup table
+
+    return DiyFp(kCachedPowers_F[index], kCachedPowers_E[index]);
+}
+
+inline void GrisuRound(char* buffer, int len, simcc::uint64 delta, simcc::uint64 rest, simcc::uint64 ten_kappa, simcc::uint64 wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+            (rest + ten_kappa < wp_w ||  // closer
+             wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+inline int CountDecimalDigit32(simcc::uint32 n) {
+    if (n < 10) return 1;
+    if (n < 100) return 2;
+    if (n < 1000) return 3;
+    if (n < 10000) return 4;
+    if (n < 100000) return 5;
+    if (n < 1000000) return 6;
+    if (n < 10000000) return 7;
+    if (n < 100000000) return 8;
+    // Will not reach 10 digits in DigitGen()
+    return 9;
+}
+
+inline void DigitGen(const DiyFp& W, const DiyFp& Mp, simcc::uint64 delta, char* buffer, int* len, int* K) {
+    static const simcc::uint32 kPow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+    const DiyFp one(simcc::uint64(1) << -Mp.e, Mp.e);
+    const DiyFp wp_w = Mp - W;
+    simcc::uint32 p1 = static_cast<simcc::uint32>(Mp.f >> -one.e);
+    simcc::uint64 p2 = Mp.f & (one.f - 1);
+    int kappa = CountDecimalDigit32(p1); // kappa in [0, 9]
+    *len = 0;
+
+    while (kappa > 0) {
+        simcc::uint32 d = p1 / kPow10[kappa - 1];
+        p1 %= kPow10[kappa - 1];
+        if (d || *len) {
+            buffer[(*len)++] = static_cast<char>('0' + static_cast<char>(d));
+        }
+        kappa--;
+        simcc::uint64 tmp = (static_cast<simcc::uint64>(p1) << -one.e) + p2;
+        if (tmp <= delta) {
+            *K += kappa;
+            GrisuRound(buffer, *len, delta, tmp, static_cast<simcc::uint64>(kPow10[kappa]) << -one.e, wp_w.f);
+            return;
+        }
+    }
+
+    // kappa = 0
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = static_cast<char>(p2 >> -one.e);
+        if (d || *len) {
+            buffer[(*len)++] = static_cast<char>('0' + d);
+        }
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *K += kappa;
+            GrisuRound(buffer, *len, delta, p2, one.f, wp_w.f * kPow10[-kappa]);
+            return;
+        }
+    }
+}
+
+inline void Grisu2(double value, char* buffer, int* length, int* K) {
+    const DiyFp v(value);
+    DiyFp w_m, w_p;
+    v.NormalizedBoundaries(&w_m, &w_p);
+
+    const DiyFp c_mk = GetCachedPower(w_p.e, K);
+    const DiyFp W = v.Normalize() * c_mk;
+    DiyFp Wp = w_p * c_mk;
+    DiyFp Wm = w_m * c_mk;
+    Wm.f++;
+    Wp.f--;
+    DigitGen(W, Wp, Wp.f - Wm.f, buffer, length, K);
+}
+
+inline char* WriteExponent(int K, char* buffer) {
+    if (K < 0) {
+        *buffer++ = '-';
+        K = -K;
+    }
+
+    if (K >= 100) {
+        *buffer++ = static_cast<char>('0' + static_cast<char>(K / 100));
+        K %= 100;
+        const char* d = GetDigitsLut() + K * 2;
+        *buffer++ = d[0];
+        *buffer++ = d[1];
+    } else if (K >= 10) {
+        const char* d = GetDigitsLut() + K * 2;
+        *buffer++ = d[0];
+        *buffer++ = d[1];
+    } else {
+        *buffer++ = static_cast<char>('0' + static_cast<char>(K));
+    }
+
+    return buffer;
+}
+
+inline char* Prettify(char* buffer, int length, int k) {
+    const int kk = length + k;  // 10^(kk-1) <= v < 10^kk
+
+    if (length <= kk && kk <= 21) {
+        // 1234e7 -> 12340000000.0
+        for (int i = length; i < kk; i++) {
+            buffer[i] = '0';
+        }
+        buffer[kk] = '.';
+        buffer[kk + 1] = '0';
+        return &buffer[kk + 2];
+    } else if (0 < kk && kk <= 21) {
+        // 1234e-2 -> 12.34
+        memmove(&buffer[kk + 1], &buffer[kk], length - kk);
+        buffer[kk] = '.';
+        return &buffer[length + 1];
+    } else if (-6 < kk && kk <= 0) {
+        // 1234e-6 -> 0.001234
+        const int offset = 2 - kk;
+        memmove(&buffer[offset], &buffer[0], length);
+        buffer[0] = '0';
+        buffer[1] = '.';
+        for (int i = 2; i < offset; i++) {
+            buffer[i] = '0';
+        }
+        return &buffer[length + offset];
+    } else if (length == 1) {
+        // 1e30
+        buffer[1] = 'e';
+        return WriteExponent(kk - 1, &buffer[2]);
+    } else {
+        // 1234e30 -> 1.234e33
+        memmove(&buffer[2], &buffer[1], length - 1);
+        buffer[1] = '.';
+        buffer[length + 1] = 'e';
+        return WriteExponent(kk - 1, &buffer[0 + length + 2]);
+    }
+}
+
+// The max length of the string generated by dtoa
+enum { kDoubleMaxLen = 32 };
+
+// Writes the shortest string of a finite double which can be converted back
+// to the same double. It always looks like a double, e.g. 1.0, 0.001, 1e30
+// @param buffer it must has kDoubleMaxLen bytes at least
+// @return the end of the written string, which is not null-terminated
+inline char* dtoa(double value, char* buffer) {
+    assert(std::isfinite(value));
+    simcc::uint64 u64;
+    memcpy(&u64, &value, sizeof(value));
+    if ((u64 & ~(simcc::uint64(1) << 63)) == 0) {
+        // 0.0 or -0.0
+        if (u64) {
+            *buffer++ = '-';
+        }
+        buffer[0] = '0';
+        buffer[1] = '.';
+        buffer[2] = '0';
+        return &buffer[3];
+    }
+
+    if (value < 0) {
+        *buffer++ = '-';
+        value = -value;
+    }
+    int length, K;
+    Grisu2(value, buffer, &length, &K);
+    return Prettify(buffer, length, K);
+}
+
+}
+}
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+
+#include <vector>
+#include <utility>
+#include <functional>
+
+namespace simcc {
+namespace json {
+
+// A cache-friendly associative container which keeps its elements in
+// insertion order in a contiguous vector.
+//
+// Small maps (no more than kLinearProbeLimit elements) are searched linearly,
+// which is faster than hashing for a few keys. Bigger maps build an
+// open-addressing (linear probing) hash index of the element positions,
+// so a lookup is O(1) and only touches two contiguous arrays.
+//
+// It provides the subset of the std::map interface used by JSONObject,
+// so it can be used as JSONObject::ObjectPtrMap when H_JSON_FLAT_MAP is defined.
+//
+// @note Unlike std::map :
+//   1. The iteration order is the insertion order, not the key order.
+//   2. Insertion may invalidate all the iterators and references.
+//   3. Erasing an element is O(n).
+//   4. Don't modify the key through an iterator.
+template<class Key, class Value, class Hash = std::hash<Key> >
+class FlatMap {
+public:
+    typedef Key                                         key_type;
+    typedef Value                                       mapped_type;
+    typedef std::pair<Key, Value>                       value_type;
+    typedef std::vector<value_type>                     container_type;
+    typedef typename container_type::iterator           iterator;
+    typedef typename container_type::const_iterator     const_iterator;
+    typedef typename container_type::reverse_iterator   reverse_iterator;
+    typedef typename container_type::const_reverse_iterator const_reverse_iterator;
+    typedef typename container_type::size_type          size_type;
+
+    enum { kLinearProbeLimit = 8 };
+
+public:
+    FlatMap() {}
+
+    size_type size() const {
+        return values_.size();
+    }
+
+    bool empty() const {
+        return values_.empty();
+    }
+
+    void clear() {
+        values_.clear();
+        index_.clear();
+    }
+
+    void reserve(size_type n) {
+        values_.reserve(n);
+        if (n > kLinearProbeLimit) {
+            Rehash(n);
+        }
+    }
+
+    void swap(FlatMap& rhs) {
+        values_.swap(rhs.values_);
+        index_.swap(rhs.index_);
+    }
+
+    iterator begin() {
+        return values_.begin();
+    }
+
+    const_iterator begin() const {
+        return values_.begin();
+    }
+
+    iterator end() {
+        return values_.end();
+    }
+
+    const_iterator end() const {
+        return values_.end();
+    }
+
+    reverse_iterator rbegin() {
+        return values_.rbegin();
+    }
+
+    const_reverse_iterator rbegin() const {
+        return values_.rbegin();
+    }
+
+    reverse_iterator rend() {
+        return values_.rend();
+    }
+
+    const_reverse_iterator rend() const {
+        return values_.rend();
+    }
+
+    iterator find(const Key& key) {
+        size_type pos = Lookup(key);
+        return pos == npos ? values_.end() : values_.begin() + pos;
+    }
+
+    const_iterator find(const Key& key) const {
+        size_type pos = Lookup(key);
+        return pos == npos ? values_.end() : values_.begin() + pos;
+    }
+
+    // Find the element whose key satisfies <code>equal</code>, so the map
+    // can be looked up by another type without constructing a Key.
+    // @param hash The value of Hash()(key) of the key to find
+    template<class Pred>
+    iterator find_by_hash(size_t hash, Pred equal) {
+        size_type pos = LookupIf(hash, equal);
+        return pos == npos ? values_.end() : values_.begin() + pos;
+    }
+
+    template<class Pred>
+    const_iterator find_by_hash(size_t hash, Pred equal) const {
+        size_type pos = LookupIf(hash, equal);
+        return pos == npos ? values_.end() : values_.begin() + pos;
+    }
+
+    size_type count(const Key& key) const {
+        return Lookup(key) == npos ? 0 : 1;
+    }
+
+    Value& operator[](const Key& key) {
+        size_type pos = Lookup(key);
+        if (pos == npos) {
+            pos = Append(value_type(key, Value()));
+        }
+        return values_[pos].second;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& v) {
+        size_type pos = Lookup(v.first);
+        if (pos != npos) {
+            return std::make_pair(values_.begin() + pos, false);
+        }
+        pos = Append(v);
+        return std::make_pair(values_.begin() + pos, true);
+    }
+
+    iterator erase(const_iterator it) {
+        size_type pos = it - values_.cbegin();
+        values_.erase(values_.begin() + pos);
+        if (!index_.empty()) {
+            // All the positions after the erased one have changed
+            Rehash(values_.size());
+        }
+        return values_.begin() + pos;
+    }
+
+    iterator erase(iterator it) {
+        return erase(const_iterator(it));
+    }
+
+    size_type erase(const Key& key) {
+        size_type pos = Lookup(key);
+        if (pos == npos) {
+            return 0;
+        }
+        erase(values_.begin() + pos);
+        return 1;
+    }
+
+private:
+    static const size_type npos = static_cast<size_type>(-1);
+
+    size_type Lookup(const Key& key) const {
+        if (index_.empty()) {
+            for (size_type i = 0; i < values_.size(); ++i) {
+                if (values_[i].first == key) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        size_type mask = index_.size() - 1;
+        for (size_type slot = Hash()(key) & mask;; slot = (slot + 1) & mask) {
+            simcc::uint32 i = index_[slot];
+            if (i == 0) {
+                return npos;
+            }
+            if (values_[i - 1].first == key) {
+                return i - 1;
+            }
+        }
+    }
+
+    template<class Pred>
+    size_type LookupIf(size_t hash, Pred& equal) const {
+        if (index_.empty()) {
+            for (size_type i = 0; i < values_.size(); ++i) {
+                if (equal(values_[i].first)) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        size_type mask = index_.size() - 1;
+        for (size_type slot = hash & mask;; slot = (slot + 1) & mask) {
+            simcc::uint32 i = index_[slot];
+            if (i == 0) {
+                return npos;
+            }
+            if (equal(values_[i - 1].first)) {
+                return i - 1;
+            }
+        }
+    }
+
+    // Appends a new element which is known not to exist and returns its position
+    size_type Append(const value_type& v) {
+        values_.push_back(v);
+        size_type pos = values_.size() - 1;
+        if (!index_.empty() || values_.size() > kLinearProbeLimit) {
+            // Keep the load factor no more than 0.5
+            if (index_.size() < values_.size() * 2) {
+                Rehash(values_.size());
+            } else {
+                Insert(pos);
+            }
+        }
+        return pos;
+    }
+
+    void Rehash(size_type n) {
+        if (n <= kLinearProbeLimit) {
+            index_.clear();
+            return;
+        }
+
+        size_type slots = 16;
+        while (slots < n * 2) {
+            slots <<= 1;
+        }
+
+        index_.assign(slots, 0);
+        for (size_type i = 0; i < values_.size(); ++i) {
+            Insert(i);
+        }
+    }
+
+    void Insert(size_type pos) {
+        size_type mask = index_.size() - 1;
+        size_type slot = Hash()(values_[pos].first) & mask;
+        while (index_[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        index_[slot] = static_cast<simcc::uint32>(pos + 1);
+    }
+
+private:
+    container_type values_;
+
+    // The hash index of the elements. 0 means an empty slot,
+    // otherwise it is the position of the element in values_ plus 1.
+    // It is empty when the map is small enough to be searched linearly.
+    std::vector<simcc::uint32> index_;
+};
+
+}
+}
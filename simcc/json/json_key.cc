@@ -0,0 +1,179 @@
+#include "simcc/inner_pre.h"
+
+#include "json_key.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace simcc {
+namespace json {
+
+// The global table of the interned keys. It is split into several shards
+// to reduce the lock contention when parsing in many threads.
+//
+// A key is removed from the table when its reference count drops to zero.
+// A key whose reference count is zero is never referenced again, a new one
+// replaces it in the table instead, so it is deleted exactly once.
+class KeyTable {
+public:
+    typedef JSONKey::Rep Rep;
+
+    Rep* Intern(const char* s, size_t len) {
+        size_t hash = JSONKey::Hash(s, len);
+        Shard& shard = shards_[hash % kShardCount];
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto it = shard.keys.find(Slice(s, len));
+        if (it != shard.keys.end()) {
+            if (TryRef(it->second)) {
+                return it->second;
+            }
+
+            // It is being removed
+            shard.keys.erase(it);
+        }
+
+        Rep* rep = new Rep;
+        rep->refcount.store(1, std::memory_order_relaxed);
+        rep->hash = hash;
+        rep->value.assign(s, len);
+        shard.keys[Slice(rep->value)] = rep;
+        return rep;
+    }
+
+    Rep* Find(const char* s, size_t len) {
+        Shard& shard = shards_[JSONKey::Hash(s, len) % kShardCount];
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto it = shard.keys.find(Slice(s, len));
+        if (it != shard.keys.end() && TryRef(it->second)) {
+            return it->second;
+        }
+        return NULL;
+    }
+
+    void Remove(Rep* rep) {
+        {
+            Shard& shard = shards_[rep->hash % kShardCount];
+            std::lock_guard<std::mutex> guard(shard.mutex);
+            auto it = shard.keys.find(Slice(rep->value));
+            if (it != shard.keys.end() && it->second == rep) {
+                shard.keys.erase(it);
+            }
+        }
+        delete rep;
+    }
+
+    size_t size() {
+        size_t n = 0;
+        for (size_t i = 0; i < kShardCount; ++i) {
+            std::lock_guard<std::mutex> guard(shards_[i].mutex);
+            n += shards_[i].keys.size();
+        }
+        return n;
+    }
+
+    static KeyTable& instance() {
+        // Never destroyed, since a JSONKey may be destroyed at exit
+        static KeyTable* table = new KeyTable;
+        return *table;
+    }
+
+private:
+    // Increase the reference count unless it is zero
+    static bool TryRef(Rep* rep) {
+        int n = rep->refcount.load(std::memory_order_relaxed);
+        while (n > 0) {
+            if (rep->refcount.compare_exchange_weak(n, n + 1, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    enum { kShardCount = 16 };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<Slice, Rep*, JSONKey::TextHasher> keys;
+    };
+
+    Shard shards_[kShardCount];
+};
+
+JSONKey::JSONKey(const string& s)
+    : rep_(s.empty() ? NULL : KeyTable::instance().Intern(s.data(), s.size())) {
+}
+
+JSONKey::JSONKey(const char* s)
+    : rep_(NULL) {
+    size_t len = strlen(s);
+    if (len > 0) {
+        rep_ = KeyTable::instance().Intern(s, len);
+    }
+}
+
+JSONKey::JSONKey(const char* s, size_t len)
+    : rep_(len == 0 ? NULL : KeyTable::instance().Intern(s, len)) {
+}
+
+bool JSONKey::Find(const char* s, size_t len, JSONKey& key) {
+    if (len == 0) {
+        key = JSONKey();
+        return true;
+    }
+
+    Rep* rep = KeyTable::instance().Find(s, len);
+    if (!rep) {
+        return false;
+    }
+
+    JSONKey k;
+    k.rep_ = rep; // It has been referenced by Find
+    key.swap(k);
+    return true;
+}
+
+size_t JSONKey::Hash(const char* s, size_t len) {
+    // FNV-1a
+    simcc::uint64 h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<unsigned char>(s[i]);
+        h *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(h ^ (h >> 32));
+}
+
+size_t JSONKey::table_size() {
+    return KeyTable::instance().size();
+}
+
+void JSONKey::Remove(Rep* rep) {
+    KeyTable::instance().Remove(rep);
+}
+
+const JSONKey& JSONKey::Probe(const char* s, size_t len) {
+    struct ProbeKey {
+        Rep rep;
+        JSONKey key;
+        ProbeKey() {
+            // It is never released, so it is never removed from the table
+            rep.refcount.store(1, std::memory_order_relaxed);
+            rep.hash = 0;
+            key.rep_ = &rep;
+        }
+        ~ProbeKey() {
+            key.rep_ = NULL;
+        }
+    };
+    static thread_local ProbeKey probe;
+    probe.rep.value.assign(s, len);
+    return probe.key;
+}
+
+const string& JSONKey::empty_string() {
+    static const string empty;
+    return empty;
+}
+
+}
+}
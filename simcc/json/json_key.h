@@ -0,0 +1,192 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+#include "simcc/slice.h"
+
+#include <atomic>
+
+namespace simcc {
+namespace json {
+
+// An interned and immutable key of JSONObject.
+//
+// All the JSONKey objects with the same text share one buffer which is kept
+// in a global thread-safe table, so a key of millions of homogeneous objects
+// is stored only once, and two keys are equal if and only if they point to
+// the same buffer. The buffer is freed with the last JSONKey referring to it.
+//
+// It is used as the key type of JSONObject::ObjectPtrMap when
+// H_JSON_INTERNED_KEY is defined.
+class SIMCC_EXPORT JSONKey {
+public:
+    // An empty key
+    JSONKey() : rep_(NULL) {}
+
+    // Intern the text
+    explicit JSONKey(const string& s);
+    explicit JSONKey(const char* s);
+    JSONKey(const char* s, size_t len);
+
+    JSONKey(const JSONKey& rhs) : rep_(rhs.rep_) {
+        Ref();
+    }
+
+    JSONKey(JSONKey&& rhs) noexcept : rep_(rhs.rep_) {
+        rhs.rep_ = NULL;
+    }
+
+    ~JSONKey() {
+        Unref();
+    }
+
+    JSONKey& operator=(const JSONKey& rhs) {
+        if (rep_ != rhs.rep_) {
+            JSONKey(rhs).swap(*this);
+        }
+        return *this;
+    }
+
+    JSONKey& operator=(JSONKey&& rhs) noexcept {
+        JSONKey(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    void swap(JSONKey& rhs) noexcept {
+        Rep* t = rep_;
+        rep_ = rhs.rep_;
+        rhs.rep_ = t;
+    }
+
+    // Find the key of the text in the table, no new key is interned.
+    // It is used to lookup a key which is given as a string.
+    // @return false if the key is not used by any object
+    static bool Find(const char* s, size_t len, JSONKey& key);
+
+    // The hash value of a text
+    static size_t Hash(const char* s, size_t len);
+
+    // The number of the keys in the table
+    static size_t table_size();
+
+    const string& str() const {
+        return rep_ ? rep_->value : empty_string();
+    }
+
+    operator const string& () const {
+        return str();
+    }
+
+    const char* c_str() const {
+        return str().c_str();
+    }
+
+    const char* data() const {
+        return str().data();
+    }
+
+    size_t size() const {
+        return str().size();
+    }
+
+    size_t length() const {
+        return size();
+    }
+
+    bool empty() const {
+        return rep_ == NULL;
+    }
+
+    // The hash value of the text, which is computed only once when interning
+    size_t hash() const {
+        return rep_ ? rep_->hash : 0;
+    }
+
+    bool operator==(const JSONKey& rhs) const {
+        return rep_ == rhs.rep_;
+    }
+
+    bool operator!=(const JSONKey& rhs) const {
+        return rep_ != rhs.rep_;
+    }
+
+    // The same order as the text
+    bool operator<(const JSONKey& rhs) const {
+        return rep_ != rhs.rep_ && str() < rhs.str();
+    }
+
+    // The hash functor for the hash tables, e.g. FlatMap
+    struct Hasher {
+        size_t operator()(const JSONKey& k) const {
+            return k.hash();
+        }
+    };
+
+    // The hash functor of the texts, which is the same as Hasher
+    struct TextHasher {
+        size_t operator()(const Slice& s) const {
+            return Hash(s.data(), s.size());
+        }
+    };
+
+private:
+    struct Rep {
+        std::atomic<int> refcount;
+        size_t hash;
+        string value;
+    };
+
+    void Ref() {
+        if (rep_) {
+            rep_->refcount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Unref() {
+        if (rep_ && rep_->refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Remove(rep_);
+        }
+    }
+
+    static void Remove(Rep* rep);
+    static const string& empty_string();
+
+    // A key of the text which is not interned. It orders the same as the
+    // interned key of the text by operator<, so it can lookup a std::map
+    // without touching the global table, but it is never equal to an
+    // interned key by operator==. It is reused by the next call in the
+    // same thread, so it MUST NOT be kept.
+    static const JSONKey& Probe(const char* s, size_t len);
+
+    friend class KeyTable;
+    friend class JSONObject;
+
+private:
+    Rep* rep_;
+};
+
+inline bool operator==(const JSONKey& k, const string& s) {
+    return k.str() == s;
+}
+
+inline bool operator==(const string& s, const JSONKey& k) {
+    return k.str() == s;
+}
+
+inline bool operator==(const JSONKey& k, const char* s) {
+    return k.str() == s;
+}
+
+inline bool operator==(const char* s, const JSONKey& k) {
+    return k.str() == s;
+}
+
+inline bool operator!=(const JSONKey& k, const string& s) {
+    return k.str() != s;
+}
+
+inline bool operator!=(const JSONKey& k, const char* s) {
+    return k.str() != s;
+}
+
+}
+}
@@ -0,0 +1,426 @@
+#include "simcc/inner_pre.h"
+
+#include "json.h"
+#include "json_lazy.h"
+#include "json_tokener.h"
+
+namespace simcc {
+namespace json {
+
+JSONType JSONLazyValue::type() const {
+    if (!doc_) {
+        return kUnknownType;
+    }
+
+    if (raw_.empty()) {
+        return kJSONNull; // A blank array element
+    }
+
+    switch (raw_[0]) {
+    case '{':
+        return kJSONObject;
+    case '[':
+    case '(':
+        return kJSONArray;
+    case '"':
+    case '\'':
+        return kJSONString;
+    default:
+        break;
+    }
+
+    JSONScalar v;
+    if (!doc_->ToScalar(raw_, v)) {
+        return kUnknownType;
+    }
+    return v.type;
+}
+
+JSONLazyValue JSONLazyValue::Get(const string& key) const {
+    if (!doc_ || raw_.empty() || raw_[0] != '{') {
+        return JSONLazyValue();
+    }
+
+    const JSONLazyDocument::Members* members = doc_->GetMembers(raw_);
+    if (members) {
+        for (auto& m : *members) {
+            if (m.key.size() == key.size() && memcmp(m.key.data(), key.data(), key.size()) == 0) {
+                return JSONLazyValue(doc_, m.value);
+            }
+        }
+    }
+    return JSONLazyValue();
+}
+
+JSONLazyValue JSONLazyValue::Get(size_t index) const {
+    if (!doc_ || raw_.empty() || (raw_[0] != '[' && raw_[0] != '(')) {
+        return JSONLazyValue();
+    }
+
+    const JSONLazyDocument::Members* members = doc_->GetMembers(raw_);
+    if (members && index < members->size()) {
+        return JSONLazyValue(doc_, (*members)[index].value);
+    }
+    return JSONLazyValue();
+}
+
+size_t JSONLazyValue::size() const {
+    if (!doc_ || raw_.empty()) {
+        return 0;
+    }
+
+    char c = raw_[0];
+    if (c != '{' && c != '[' && c != '(') {
+        return 0;
+    }
+
+    const JSONLazyDocument::Members* members = doc_->GetMembers(raw_);
+    return members ? members->size() : 0;
+}
+
+bool JSONLazyValue::GetBool(bool default_value) const {
+    JSONScalar v;
+    if (doc_ && doc_->ToScalar(raw_, v) && v.type == kJSONBoolean) {
+        return v.b;
+    }
+    return default_value;
+}
+
+simcc::int64 JSONLazyValue::GetInteger(simcc::int64 default_value) const {
+    JSONScalar v;
+    if (doc_ && doc_->ToScalar(raw_, v) && v.type == kJSONInteger) {
+        return v.i;
+    }
+    return default_value;
+}
+
+simcc::float64 JSONLazyValue::GetDouble(simcc::float64 default_value) const {
+    JSONScalar v;
+    if (doc_ && doc_->ToScalar(raw_, v) && v.type == kJSONDouble) {
+        return v.d;
+    }
+    return default_value;
+}
+
+simcc::float64 JSONLazyValue::GetDecimal(simcc::float64 default_value) const {
+    JSONScalar v;
+    if (doc_ && doc_->ToScalar(raw_, v)) {
+        if (v.type == kJSONDouble) {
+            return v.d;
+        }
+
+        if (v.type == kJSONInteger) {
+            return static_cast<simcc::float64>(v.i);
+        }
+    }
+    return default_value;
+}
+
+string JSONLazyValue::GetString(const string& default_value) const {
+    string s;
+    if (doc_ && doc_->DecodeString(raw_, s)) {
+        return s;
+    }
+    return default_value;
+}
+
+ObjectPtr JSONLazyValue::Materialize() const {
+    if (!doc_) {
+        return ObjectPtr();
+    }
+    return doc_->Materialize(raw_);
+}
+
+JSONLazyDocument::JSONLazyDocument() {
+}
+
+JSONLazyDocument::~JSONLazyDocument() {
+}
+
+simcc::uint32 JSONLazyDocument::Parse(const char* source, const simcc::int64 source_len) {
+    set_error(kNoError, static_cast<size_t>(0));
+    source_ = Slice();
+    root_ = Slice();
+    members_.clear();
+    keys_.clear();
+
+    if (source_len == 0 || !source) {
+        set_error(kParameterWrong);
+        return 0;
+    }
+
+    JSONTokener x(source, source_len);
+    source_ = Slice(x.data(), x.size());
+    if (!x.SkipComment()) {
+        set_error(kCommentFormatError, &x);
+        return 0;
+    }
+
+    char c = x.NextClean();
+    if (c != '{' && c != '[' && c != '(') {
+        set_error(kInvalidCharacter, &x);
+        return 0;
+    }
+
+    x.Back();
+    Slice root;
+    if (!NextValue(&x, root)) {
+        return 0;
+    }
+
+    root_ = root;
+    return x.GetCurrentPosition();
+}
+
+bool JSONLazyDocument::NextValue(JSONTokener* x, Slice& value) {
+    if (!x->SkipComment()) {
+        set_error(kCommentFormatError, x);
+        return false;
+    }
+
+    x->SkipSpaces();
+    const char* begin = x->GetCurrent();
+    if (!x->SkipValue()) {
+        // The brackets don't match or a string is not terminated
+        set_error(kInvalidCharacter, x->GetCurrentPosition());
+        return false;
+    }
+
+    // The spaces are allowed at the end of an unquoted text
+    const char* end = x->GetCurrent();
+    while (end > begin && static_cast<unsigned char>(*(end - 1)) <= ' ') {
+        --end;
+    }
+
+    value = Slice(begin, end - begin);
+    return true;
+}
+
+const JSONLazyDocument::Members* JSONLazyDocument::GetMembers(const Slice& raw) {
+    auto it = members_.find(raw.data());
+    if (it != members_.end()) {
+        return &it->second;
+    }
+
+    Members members;
+    JSONTokener x(raw.data(), static_cast<simcc::int32>(raw.size()));
+    bool ok = raw[0] == '{' ? IndexObject(&x, members) : IndexArray(&x, members);
+    if (!ok) {
+        Relocate(raw);
+        return NULL;
+    }
+
+    return &(members_[raw.data()] = std::move(members));
+}
+
+bool JSONLazyDocument::IndexObject(JSONTokener* x, Members& members) {
+    x->Next(); // skip '{'
+
+    Member m;
+    for (;;) {
+        if (!x->SkipComment()) {
+            set_error(kCommentFormatError, x);
+            return false;
+        }
+
+        char c = x->NextClean();
+        switch (c) {
+        case 0:
+            set_error(kJSONObjectNotEndWithBraces, x);
+            return false;
+        case '}':
+            return true;
+        case '"':   // a key must be a string
+            if (!x->NextString('"', false, m.key)) {
+                set_error(kJSONObjectKeyNotString, x);
+                return false;
+            }
+
+            if (!x->IsInSource(m.key)) {
+                // It has escapes, the decoded one is kept by the document
+                keys_.push_back(m.key.ToString());
+                m.key = Slice(keys_.back());
+            }
+            break;
+        default:
+            set_error(kInvalidCharacter, x);
+            return false;
+        }
+
+        // The key is followed by ':'
+        if (!x->SkipComment()) {
+            set_error(kCommentFormatError, x);
+            return false;
+        }
+
+        c = x->NextClean();
+        if (c != ':') {
+            set_error(kKeyValueSeperatorError, x);
+            return false;
+        }
+
+        if (!NextValue(x, m.value)) {
+            return false;
+        }
+
+        members.push_back(m);
+
+        if (!x->SkipComment()) {
+            set_error(kCommentFormatError, x);
+            return false;
+        }
+
+        c = x->NextClean();
+
+        // pairs are separated by ','
+        switch (c) {
+        case ',':
+            if (!x->SkipComment()) {
+                set_error(kCommentFormatError, x);
+                return false;
+            }
+
+            c = x->NextClean();
+            if (c == '}') {
+                return true;
+            }
+
+            x->Back();
+            break;
+        case '}':
+            return true;
+        default:
+            set_error(kInvalidCharacter, x);
+            return false;
+        }
+    }
+}
+
+bool JSONLazyDocument::IndexArray(JSONTokener* x, Members& members) {
+    char q = x->Next() == '[' ? ']' : ')';
+
+    if (!x->SkipComment()) {
+        set_error(kCommentFormatError, x);
+        return false;
+    }
+
+    char c = x->NextClean();
+    if (c == q) {
+        return true;
+    }
+
+    x->Back();
+    Member m;
+    for (;;) {
+        if (!x->SkipComment()) {
+            set_error(kCommentFormatError, x);
+            return false;
+        }
+
+        c = x->NextClean();
+        x->Back();
+        if (c == ',') {
+            m.value = Slice(); // A blank element is a null
+        } else if (!NextValue(x, m.value)) {
+            return false;
+        }
+
+        members.push_back(m);
+
+        if (!x->SkipComment()) {
+            set_error(kCommentFormatError, x);
+            return false;
+        }
+
+        c = x->NextClean();
+
+        switch (c) {
+        case ';':
+        case ',':
+            if (!x->SkipComment()) {
+                set_error(kCommentFormatError, x);
+                return false;
+            }
+
+            c = x->NextClean();
+            if (c == q) {
+                return true;
+            }
+
+            x->Back();
+            break;
+        case ']':
+        case ')':
+            if (q != c) {
+                set_error(kJSONArrayNotEndWithBrackets, x);
+                return false;
+            }
+            return true;
+        default:
+            set_error(kJSONArrayNotEndWithBrackets, x);
+            return false;
+        }
+    }
+}
+
+bool JSONLazyDocument::ToScalar(const Slice& raw, JSONScalar& v) {
+    if (raw.empty()) {
+        v.type = kJSONNull;
+        return true;
+    }
+
+    switch (raw[0]) {
+    case '{':
+    case '[':
+    case '(':
+    case '"':
+    case '\'':
+        return false;
+    default:
+        break;
+    }
+
+    if (!JSONObject::ConvertToScalar(raw.data(), raw.size(), this, NULL, v)) {
+        Relocate(raw);
+        return false;
+    }
+    return true;
+}
+
+bool JSONLazyDocument::DecodeString(const Slice& raw, string& s) {
+    if (raw.empty() || (raw[0] != '"' && raw[0] != '\'')) {
+        return false;
+    }
+
+    JSONTokener x(raw.data(), static_cast<simcc::int32>(raw.size()));
+    char quote = x.Next();
+    if (!x.NextString(quote, false, s)) {
+        set_error(kJSONStringNotQuoted, x.GetCurrentPosition());
+        Relocate(raw);
+        return false;
+    }
+    return true;
+}
+
+ObjectPtr JSONLazyDocument::Materialize(const Slice& raw) {
+    if (raw.empty()) {
+        return ObjectPtr(new JSONNull);
+    }
+
+    // A previous error of the document must not fail this parsing
+    JSONParser parser;
+    JSONTokener x(raw.data(), static_cast<simcc::int32>(raw.size()));
+    ObjectPtr o(x.NextValue(&parser));
+    if (!o) {
+        set_error(parser.error(), parser.error_location());
+        Relocate(raw);
+    }
+    return o;
+}
+
+void JSONLazyDocument::Relocate(const Slice& raw) {
+    set_error(error(), (raw.data() - source_.data()) + error_location());
+}
+
+}
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+#include "simcc/slice.h"
+
+#include "json_common.h"
+#include "json_parser.h"
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace simcc {
+namespace json {
+
+class JSONLazyDocument;
+
+// A value of a JSONLazyDocument. It refers to the source text of the value
+// and nothing is parsed until it is accessed.
+//
+// A JSONLazyValue is only valid during the lifetime of its document.
+class SIMCC_EXPORT JSONLazyValue {
+public:
+    // An invalid value
+    JSONLazyValue() : doc_(NULL) {}
+
+    // @return false if the value is not found
+    //   or there is a syntax error in it, see JSONLazyDocument::error()
+    bool valid() const {
+        return doc_ != NULL;
+    }
+
+    // The type of the value. Only the first character is checked unless
+    // it is a null, boolean or number value.
+    JSONType type() const;
+
+    // The source text of this value, e.g. <code>{"a":1}</code> or
+    // <code>"abc"</code> (including the quotes). It is empty for a blank
+    // array element, which is a null value.
+    const Slice& raw() const {
+        return raw_;
+    }
+
+    // Get the value associated with a key of an object.
+    // The members of the object are indexed on the first access.
+    // @return An invalid value if this is not an object or the key is not found
+    JSONLazyValue Get(const string& key) const;
+
+    // Get the element at an index of an array.
+    // The elements of the array are indexed on the first access.
+    // @return An invalid value if this is not an array or the index is out of range
+    JSONLazyValue Get(size_t index) const;
+
+    // The number of the members of an object or the elements of an array,
+    // 0 for the other values.
+    size_t size() const;
+
+    // Gets the scalar value. The text is only converted here.
+    // @return default_value, if the value is invalid or of the other type
+    bool GetBool(bool default_value = false) const;
+    simcc::int64 GetInteger(simcc::int64 default_value = 0) const;
+    simcc::float64 GetDouble(simcc::float64 default_value = 0.0) const;
+    string GetString(const string& default_value = StringUtil::kEmpty) const;
+
+    // Get a decimal number whether it is a double or an integer
+    simcc::float64 GetDecimal(simcc::float64 default_value = 0.0) const;
+
+    // Build the json objects of this value and all its children,
+    // e.g. a JSONObject for an object.
+    // @return NULL if the value is invalid or there is a syntax error in it
+    ObjectPtr Materialize() const;
+
+private:
+    friend class JSONLazyDocument;
+    JSONLazyValue(JSONLazyDocument* doc, const Slice& raw)
+        : doc_(doc), raw_(raw) {}
+
+private:
+    JSONLazyDocument* doc_;
+    Slice raw_;
+};
+
+// A json document which is parsed on demand.
+//
+// Parse only checks the structure of the text: the brackets are matched and
+// the strings are terminated, no json object is built and no string is
+// copied. The members of an object or an array are indexed when it is
+// accessed for the first time, and the json objects are only built for the
+// values which are materialized. So it is much cheaper than JSONObject::Parse
+// if only a few values of a big document are read.
+//
+// Usage:
+//    JSONLazyDocument doc;
+//    if (doc.Parse(body.data(), body.size())) {
+//        string uid = doc.Get("user").Get("id").GetString();
+//        int64 ts = doc.Get("ts").GetInteger();
+//    }
+//
+// @note The source text MUST outlive the document and its values.
+//   The syntax of a value is completely checked only when it is accessed,
+//   the errors are reported by error().
+//   A document and its values are not thread safe, since they are indexed
+//   on demand.
+class SIMCC_EXPORT JSONLazyDocument : public JSONParser {
+public:
+    JSONLazyDocument();
+    ~JSONLazyDocument();
+
+    // Check the structure of the source JSON text, a JSONObject or a JSONArray
+    // @param source A string of JSON format text
+    // @param source_len, the length of the source string.
+    //   if you use the default value(-1), we will use strlen(source) to
+    //   calculate the length.
+    // @return number of characters parsed. Return 0 if failed to parse.
+    simcc::uint32 Parse(const char* source, const simcc::int64 source_len = -1);
+
+    // The root object or array
+    JSONLazyValue root() {
+        return root_.empty() ? JSONLazyValue() : JSONLazyValue(this, root_);
+    }
+
+    JSONLazyValue Get(const string& key) {
+        return root().Get(key);
+    }
+
+    JSONLazyValue Get(size_t index) {
+        return root().Get(index);
+    }
+
+private:
+    friend class JSONLazyValue;
+
+    struct Member {
+        Slice key;   // Empty for the elements of an array
+        Slice value;
+    };
+    typedef std::vector<Member> Members;
+
+    // The members of an object or an array, which are indexed on the first call
+    // @return NULL if there is a syntax error
+    const Members* GetMembers(const Slice& raw);
+    bool IndexObject(JSONTokener* x, Members& members);
+    bool IndexArray(JSONTokener* x, Members& members);
+
+    // Read the next value of an object or an array
+    bool NextValue(JSONTokener* x, Slice& value);
+
+    bool ToScalar(const Slice& raw, JSONScalar& v);
+    bool DecodeString(const Slice& raw, string& s);
+    ObjectPtr Materialize(const Slice& raw);
+
+    // The errors of a value are located in the text of the value,
+    // move the location to the whole source text
+    void Relocate(const Slice& raw);
+
+private:
+    Slice source_;
+    Slice root_;
+    std::unordered_map<const char*, Members> members_;
+    std::list<string> keys_; // The decoded keys which have escapes
+};
+
+}
+}
@@ -0,0 +1,159 @@
+#include "simcc/inner_pre.h"
+
+#include "simcc/mapped_file.h"
+#include "simcc/simd_scan.h"
+
+#include "json.h"
+#include "json_lines.h"
+
+#include <thread>
+
+namespace simcc {
+namespace json {
+
+namespace {
+// A small text is not worth splitting
+const size_t kMinBytesPerThread = 64 * 1024;
+}
+
+struct JSONLinesLoader::Range {
+    const char* begin;
+    const char* end;
+    std::vector<ObjectPtr> records;
+    size_t lines;             // The number of the lines in this range
+    size_t failed_count;
+    size_t first_failed_line; // The line number in this range, from 1
+};
+
+JSONLinesLoader::JSONLinesLoader(size_t thread_count)
+    : thread_count_(thread_count), failed_count_(0), first_failed_line_(0) {
+    if (thread_count_ == 0) {
+        thread_count_ = std::thread::hardware_concurrency();
+    }
+
+    if (thread_count_ == 0) {
+        thread_count_ = 1;
+    }
+}
+
+bool JSONLinesLoader::Load(const char* data, size_t len, std::vector<ObjectPtr>& records) {
+    return Load(data, len, &records, NULL);
+}
+
+bool JSONLinesLoader::Load(const char* data, size_t len, const Handler& handler) {
+    return Load(data, len, NULL, &handler);
+}
+
+bool JSONLinesLoader::LoadFile(const string& path, std::vector<ObjectPtr>& records) {
+    MappedFile f;
+    if (!f.Open(path, MappedFile::kSequential)) {
+        failed_count_ = 0;
+        first_failed_line_ = 0;
+        return false;
+    }
+    return Load(f.data(), f.size(), &records, NULL);
+}
+
+bool JSONLinesLoader::LoadFile(const string& path, const Handler& handler) {
+    MappedFile f;
+    if (!f.Open(path, MappedFile::kSequential)) {
+        failed_count_ = 0;
+        first_failed_line_ = 0;
+        return false;
+    }
+    return Load(f.data(), f.size(), NULL, &handler);
+}
+
+bool JSONLinesLoader::Load(const char* data, size_t len, std::vector<ObjectPtr>* records, const Handler* handler) {
+    failed_count_ = 0;
+    first_failed_line_ = 0;
+
+    size_t n = std::min(thread_count_, len / kMinBytesPerThread);
+    if (n == 0) {
+        n = 1;
+    }
+
+    // Split the text at the line boundaries
+    std::vector<Range> ranges(n);
+    const char* end = data + len;
+    const char* p = data;
+    for (size_t i = 0; i < n; ++i) {
+        Range& r = ranges[i];
+        r.begin = p;
+        if (i + 1 == n) {
+            r.end = end;
+        } else {
+            const char* e = std::max(p, data + len / n * (i + 1));
+            const char* nl = static_cast<const char*>(memchr(e, '\n', end - e));
+            r.end = nl ? nl + 1 : end;
+        }
+        p = r.end;
+    }
+
+    // The first range is parsed by the calling thread
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < n; ++i) {
+        threads.push_back(std::thread(&JSONLinesLoader::ParseRange, this, &ranges[i], handler));
+    }
+    ParseRange(&ranges[0], handler);
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    size_t count = 0;
+    size_t lines = 0;
+    for (auto& r : ranges) {
+        count += r.records.size();
+        if (r.first_failed_line > 0 && first_failed_line_ == 0) {
+            first_failed_line_ = lines + r.first_failed_line;
+        }
+        failed_count_ += r.failed_count;
+        lines += r.lines;
+    }
+
+    if (records) {
+        records->clear();
+        records->reserve(count);
+        for (auto& r : ranges) {
+            records->insert(records->end(), r.records.begin(), r.records.end());
+        }
+    }
+
+    return failed_count_ == 0;
+}
+
+void JSONLinesLoader::ParseRange(Range* r, const Handler* handler) {
+    r->lines = 0;
+    r->failed_count = 0;
+    r->first_failed_line = 0;
+
+    const char* p = r->begin;
+    while (p < r->end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', r->end - p));
+        const char* eol = nl ? nl : r->end;
+        ++r->lines;
+
+        // Skip the blank lines
+        if (SIMDScan::SkipSpaces(p, eol) != eol) {
+            ObjectPtr o = JSONParser::Load(p, eol - p);
+            if (!o) {
+                ++r->failed_count;
+                if (r->first_failed_line == 0) {
+                    r->first_failed_line = r->lines;
+                }
+            }
+
+            if (handler) {
+                (*handler)(o, Slice(p, eol - p));
+            } else {
+                r->records.push_back(o);
+            }
+        }
+
+        p = eol + 1;
+    }
+}
+
+}
+}
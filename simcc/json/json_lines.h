@@ -0,0 +1,74 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+#include "simcc/slice.h"
+
+#include "json_common.h"
+
+#include <functional>
+#include <vector>
+
+namespace simcc {
+namespace json {
+
+// A loader of the newline-delimited json records (NDJSON or JSON lines),
+// which parses the records in parallel.
+//
+// The text is split into several ranges at the line boundaries, and every
+// range is parsed by a thread. Every non-blank line is a JSONObject or a
+// JSONArray record. A file is memory mapped instead of being read.
+//
+// Usage:
+//    JSONLinesLoader loader(8);
+//    std::vector<ObjectPtr> records;
+//    if (!loader.LoadFile("/data/dump.json", records)) {
+//        printf("%d bad records, the first is at line %d\n",
+//               (int)loader.failed_count(), (int)loader.first_failed_line());
+//    }
+class SIMCC_EXPORT JSONLinesLoader {
+public:
+    // The handler of a record. It is called by the loading threads concurrently.
+    // @param record the parsed record, NULL if failed to parse the line
+    // @param line the text of the record, which is only valid during this call
+    typedef std::function<void(const ObjectPtr& record, const Slice& line)> Handler;
+
+    // @param thread_count the max number of the threads to parse the records,
+    //   0 means the number of the CPU cores. A small text is parsed by fewer threads.
+    explicit JSONLinesLoader(size_t thread_count = 0);
+
+    // Load all the records in the input order, the blank lines are skipped.
+    // @param records[out] the records, the failed records are NULL
+    // @return false if any record failed to parse or failed to open the file
+    bool Load(const char* data, size_t len, std::vector<ObjectPtr>& records);
+    bool LoadFile(const string& path, std::vector<ObjectPtr>& records);
+
+    // The same as above, but every record is passed to <code>handler</code>
+    // instead of being kept, in no particular order.
+    bool Load(const char* data, size_t len, const Handler& handler);
+    bool LoadFile(const string& path, const Handler& handler);
+
+    // The number of the records which failed to parse in the last loading
+    size_t failed_count() const {
+        return failed_count_;
+    }
+
+    // The line number (from 1) of the first failed record in the last loading,
+    // 0 if there is none.
+    size_t first_failed_line() const {
+        return first_failed_line_;
+    }
+
+private:
+    struct Range;
+
+    bool Load(const char* data, size_t len, std::vector<ObjectPtr>* records, const Handler* handler);
+    void ParseRange(Range* r, const Handler* handler);
+
+private:
+    size_t thread_count_;
+    size_t failed_count_;
+    size_t first_failed_line_;
+};
+
+}
+}
@@ -1,6 +1,7 @@
 #include "simcc/string_util.h"
 #include "simcc/data_stream.h"
 #include "simcc/utility.h"
+#include "simcc/simd_scan.h"
 
 #include "json.h"
 #include "json_tokener.h"
@@ -28,66 +29,97 @@ JSONObject::~JSONObject() {
 }
 
 simcc::uint32 JSONObject::Parse(JSONTokener* x) {
+    JSONParser parser;
+    simcc::uint32 n = Parse(x, &parser);
+    if (parser.ok()) {
+        parser_.reset();
+    } else {
+        set_error(parser.error(), parser.error_location());
+    }
+    return n;
+}
+
+void JSONObject::set_error(JSONParser::ErrorCode ec, size_t error_location) {
+    if (!parser_) {
+        parser_.reset(new JSONParser);
+    }
+    parser_->set_error(ec, error_location);
+}
+
+const char* JSONObject::strerror() const {
+    if (parser_) {
+        return parser_->strerror();
+    }
+    return JSONParser().strerror();
+}
+
+simcc::uint32 JSONObject::Parse(JSONTokener* x, JSONParser* parser) {
     if (!x->SkipComment()) {
-        set_error(kCommentFormatError, x);
+        parser->set_error(JSONParser::kCommentFormatError, x);
         return 0;
     }
 
     char c = x->NextClean();
     if (c != '{') {
-        set_error(kJSONObjectNotBeginWithBraces, x);
+        parser->set_error(JSONParser::kJSONObjectNotBeginWithBraces, x);
         return 0;
     }
 
-    string key;
+    KeyType key;
+    Slice text;
     for (;;) {
         if (!x->SkipComment()) {
-            set_error(kCommentFormatError, x);
+            parser->set_error(JSONParser::kCommentFormatError, x);
             return 0;
         }
 
         c = x->NextClean();
         switch (c) {
         case 0:
-            set_error(kJSONObjectNotEndWithBraces, x);
+            parser->set_error(JSONParser::kJSONObjectNotEndWithBraces, x);
             return 0;
         case '}':
             return x->GetCurrentPosition();
         case '"':   // a key must be a string
-            if (!x->NextString('"', key)) {
-                set_error(kJSONObjectKeyNotString, x);
+            if (!x->NextString('"', false, text)) {
+                parser->set_error(JSONParser::kJSONObjectKeyNotString, x);
                 return 0;
             }
+#ifdef H_JSON_INTERNED_KEY
+            key = x->InternKey(text);
+#else
+            key.assign(text.data(), text.size());
+#endif
             break;
         default:
-            set_error(kInvalidCharacter, x);
+            parser->set_error(JSONParser::kInvalidCharacter, x);
             return 0;
         }
 
         // The key is followed by ':'
         if (!x->SkipComment()) {
-            set_error(kCommentFormatError, x);
+            parser->set_error(JSONParser::kCommentFormatError, x);
             return 0;
         }
 
         c = x->NextClean();
 
         if (c != ':') {
-            set_error(kKeyValueSeperatorError, x);
+            parser->set_error(JSONParser::kKeyValueSeperatorError, x);
             return 0;
         }
 
-        Object* po = x->NextValue(this);
+        Object* po = x->NextValue(parser);
 
         if (po) {
-            Put(key, po);
+            map_[key] = po;
         } else {
             // error code has been set by nextValue
             return 0;
         }
 
         if (!x->SkipComment()) {
-            set_error(kCommentFormatError, x);
+            parser->set_error(JSONParser::kCommentFormatError, x);
             return 0;
         }
 
@@ -97,7 +129,7 @@ simcc::uint32 JSONObject::Parse(JSONTokener* x) {
         switch (c) {
         case ',':
             if (!x->SkipComment()) {
-                set_error(kCommentFormatError, x);
+                parser->set_error(JSONParser::kCommentFormatError, x);
                 return 0;
             }
 
@@ -111,7 +143,7 @@ simcc::uint32 JSONObject::Parse(JSONTokener* x) {
         case '}':
             return x->GetCurrentPosition();
         default:
-            set_error(kInvalidCharacter, x);
+            parser->set_error(JSONParser::kInvalidCharacter, x);
             return 0;
         }
     }
@@ -119,7 +151,7 @@ simcc::uint32 JSONObject::Parse(JSONTokener* x) {
 
 simcc::uint32 JSONObject::Parse(const char* source, const simcc::int64 source_len) {
     if (source_len == 0 || !source) {
-        set_error(kParameterWrong);
+        set_error(JSONParser::kParameterWrong);
         return 0;
     }
 
@@ -128,6 +160,17 @@ simcc::uint32 JSONObject::Parse(const char* source, const simcc::int64 source_le
     return Parse(&x);
 }
 
+simcc::uint32 JSONObject::ParseInSitu(const char* source, const simcc::int64 source_len) {
+    if (source_len == 0 || !source) {
+        set_error(JSONParser::kParameterWrong);
+        return 0;
+    }
+
+    json::JSONTokener x(source, source_len);
+    x.set_in_situ(true);
+    return Parse(&x);
+}
+
 simcc::uint32 JSONObject::Parse(const string& source) {
     json::JSONTokener x(source);
 
@@ -136,11 +179,11 @@ simcc::uint32 JSONObject::Parse(const string& source) {
 
 bool JSONObject::Put(const string& key, Object* value) {
     if (!value) {
-        map_.erase(key);
+        erase(key);
         return true;
     }
 
-    map_[key] = value;
+    map_[KeyType(key)] = value;
     return true;
 }
 
@@ -181,27 +224,203 @@ inline bool is_float_number(const char* s , size_t len) {
     }
     return false;
 }
+
+// Converts a decimal number string with the slow but always correct strtod.
+// The string is not null-terminated, so it is copied into a stack buffer
+// which is big enough for almost all the numbers.
+inline simcc::float64 slow_strtod(const char* s, size_t len) {
+    char buf[128];
+    if (len < sizeof(buf)) {
+        memcpy(buf, s, len);
+        buf[len] = '\0';
+        return std::strtod(buf, NULL);
+    }
+
+    string tmp(s, len);
+    return std::strtod(tmp.c_str(), NULL);
+}
+
+// Scans a decimal number in place : [+-]digits[.digits][(e|E)[+-]digits]
+// The integer part or the fraction part can be omitted, but not both.
+//
+// A number without fraction and exponent is a JSONInteger, or a JSONDouble
+// if it overflows int64. The double value is calculated exactly by the
+// fast path when the significand is no more than 2^53 and the
+// power of 10 is no more than 22, or by strtod for the rare cases.
+//
+// @return false if s is not a valid number string
+bool scan_number(const char* s, size_t len, JSONScalar& v) {
+    static const simcc::float64 kPow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    enum { kMaxSignificantDigits = 19 }; // 10^19 - 1 < 2^64
+    const simcc::uint64 kMaxExactInteger = simcc::uint64(1) << 53;
+
+    const char* p = s;
+    const char* end = s + len;
+
+    bool negative = false;
+    if (*p == '-' || *p == '+') {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    simcc::uint64 significand = 0;
+    int significant_digits = 0;
+    int exp10 = 0;
+    bool has_digit = false;
+    bool truncated = false; // some digits are dropped from significand
+    bool is_float = false;
+
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+        has_digit = true;
+        if (significant_digits < kMaxSignificantDigits) {
+            significand = significand * 10 + (*p - '0');
+            if (significand) {
+                ++significant_digits;
+            }
+        } else {
+            ++exp10;
+            truncated = true;
+        }
+    }
+
+    if (p != end && *p == '.') {
+        is_float = true;
+        for (++p; p != end && *p >= '0' && *p <= '9'; ++p) {
+            has_digit = true;
+            if (significant_digits < kMaxSignificantDigits) {
+                significand = significand * 10 + (*p - '0');
+                if (significand) {
+                    ++significant_digits;
+                }
+                --exp10;
+            } else {
+                truncated = true;
+            }
+        }
+    }
+
+    if (!has_digit) {
+        return false;
+    }
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        is_float = true;
+        ++p;
+        bool negative_exp = false;
+        if (p != end && (*p == '-' || *p == '+')) {
+            negative_exp = (*p == '-');
+            ++p;
+        }
+
+        if (p == end || *p < '0' || *p > '9') {
+            return false;
+        }
+
+        int e = 0;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+            if (e < 100000) {
+                e = e * 10 + (*p - '0');
+            }
+        }
+        exp10 += negative_exp ? -e : e;
+    }
+
+    if (p != end) {
+        return false;
+    }
+
+    if (!is_float && !truncated) {
+        if (negative && significand <= simcc::uint64(1) << 63) {
+            v.type = kJSONInteger;
+            v.i = static_cast<simcc::int64>(~significand + 1);
+            return true;
+        }
+
+        if (!negative && significand <= simcc::uint64(INT64_MAX)) {
+            v.type = kJSONInteger;
+            v.i = static_cast<simcc::int64>(significand);
+            return true;
+        }
+
+        // int64 overflow, promote to a double
+    }
+
+    v.type = kJSONDouble;
+    if (!truncated && significand <= kMaxExactInteger && exp10 >= -22 && exp10 <= 22) {
+        simcc::float64 d = static_cast<simcc::float64>(significand);
+        if (exp10 < 0) {
+            d /= kPow10[-exp10];
+        } else {
+            d *= kPow10[exp10];
+        }
+        v.d = negative ? -d : d;
+    } else {
+        v.d = slow_strtod(s, len);
+    }
+
+    return true;
+}
 }
 
 Object* JSONObject::ConvertToObject(const char* s, size_t len, JSONParser* parser, JSONTokener* x) {
+    JSONScalar v;
+    if (!ConvertToScalar(s, len, parser, x, v)) {
+        return NULL;
+    }
+
+    simcc::qh::Pool* pool = x ? x->pool() : NULL;
+    Object* o = NULL;
+    switch (v.type) {
+    case kJSONNull:
+        o = Object::New<JSONNull>(pool);
+        break;
+    case kJSONBoolean:
+        o = Object::New<JSONBoolean>(pool, v.b);
+        break;
+    case kJSONInteger:
+        o = Object::New<JSONInteger>(pool, v.i);
+        break;
+    case kJSONDouble:
+        o = Object::New<JSONDouble>(pool, v.d);
+        break;
+    default:
+        assert(false);
+        return NULL;
+    }
+
+    if (!o && parser) {
+        parser->set_error(JSONParser::kOutOfMemory, x ? x->GetCurrentPosition() : 0);
+    }
+    return o;
+}
+
+bool JSONObject::ConvertToScalar(const char* s, size_t len, JSONParser* parser, JSONTokener* x, JSONScalar& v) {
     assert(len > 0);
 
     char b = s[0]; //beginning char
 #if 1
     switch (b) {
     case 'n':
-        if (strncmp(s + 1, "ull", 3) == 0) {
-            return new JSONNull();
+        if (len == 4 && memcmp(s + 1, "ull", 3) == 0) {
+            v.type = kJSONNull;
+            return true;
         }
         break;
     case 't':
-        if (strncmp(s + 1, "rue", 3) == 0) {
-            return new JSONBoolean(true);
+        if (len == 4 && memcmp(s + 1, "rue", 3) == 0) {
+            v.type = kJSONBoolean;
+            v.b = true;
+            return true;
         }
         break;
     case 'f':
-        if (strncmp(s + 1, "alse", 4) == 0) {
-            return new JSONBoolean(false);
+        if (len == 5 && memcmp(s + 1, "alse", 4) == 0) {
+            v.type = kJSONBoolean;
+            v.b = false;
+            return true;
         }
         break;
     default:
@@ -209,11 +428,16 @@ Object* JSONObject::ConvertToObject(const char* s, size_t len, JSONParser* parse
     }
 #else
     if (b == 'n' && strncmp(s + 1, "ull", 3) == 0) {
-        return new JSONNull();
+        v.type = kJSONNull;
+        return true;
     } else if (b == 't' && strncmp(s + 1, "rue", 3) == 0) {
-        return new JSONBoolean(true);
+        v.type = kJSONBoolean;
+        v.b = true;
+        return true;
     } else if (b == 'f' && strncmp(s + 1, "alse", 4) == 0) {
-        return new JSONBoolean(false);
+        v.type = kJSONBoolean;
+        v.b = false;
+        return true;
     }
 #endif
 
@@ -228,16 +452,18 @@ Object* JSONObject::ConvertToObject(const char* s, size_t len, JSONParser* parse
         if (parser) {
             parser->set_error(JSONParser::kInvalidIntegerOrDoubleString, x);
         }
-        return NULL;
+        return false;
     }
 
     /* a normal number string */
-    if (b != '0') {
-        if (is_float_number(s, len)) {
-            return new JSONDouble(std::atof(s));
-        } else {
-            return new JSONInteger(std::atoll(s));
+    if (b != '0' || len == 1 || is_float_number(s, len)) {
+        if (!scan_number(s, len, v)) {
+            if (parser) {
+                parser->set_error(JSONParser::kInvalidIntegerOrDoubleString, x);
+            }
+            return false;
         }
+        return true;
     }
 
     /* hexadecimal number */
@@ -254,46 +480,61 @@ Object* JSONObject::ConvertToObject(const char* s, size_t len, JSONParser* parse
                 if (parser) {
                     parser->set_error(JSONParser::kInvalidHexadecimalCharacter, x);
                 }
-                return NULL;
+                return false;
             }
         }
 
-        return new JSONInteger(result);
+        v.type = kJSONInteger;
+        v.i = result;
+        return true;
     } else {
-        if (is_float_number(s, len)) {
-            return new JSONDouble(std::atof(s));
-        } else {
-            /* it is a octal number string */
-            simcc::int64 result = 0;
-            int curval = 0;
+        /* it is a octal number string */
+        simcc::int64 result = 0;
+        int curval = 0;
 
-            for (size_t i = 1; i < len; i++) {
-                curval = JSONTokener::DehexChar(s[i]);
+        for (size_t i = 1; i < len; i++) {
+            curval = JSONTokener::DehexChar(s[i]);
 
-                if (curval != -1) {
-                    result = (result << 3) + curval;
-                } else {
-                    if (parser) {
-                        parser->set_error(JSONParser::kInvalidHexadecimalCharacter, x);
-                    }
-                    return NULL;
+            if (curval != -1) {
+                result = (result << 3) + curval;
+            } else {
+                if (parser) {
+                    parser->set_error(JSONParser::kInvalidHexadecimalCharacter, x);
                 }
+                return false;
             }
-
-            return new JSONInteger(result);
         }
+
+        v.type = kJSONInteger;
+        v.i = result;
+        return true;
     }
 }
 
 void JSONObject::Quote(const string& source, bool utf8_to_unicode, simcc::DataStream& sb) {
-    sb.Expand(source.size() << 2);
+    Quote(source.data(), source.size(), utf8_to_unicode, sb);
+}
+
+void JSONObject::Quote(const char* source, size_t source_len, bool utf8_to_unicode, simcc::DataStream& sb) {
+    sb.Expand(source_len << 2);
 
     sb.Write('"');
 
-    const char* readp = source.data();
-    const char* readend = readp + source.size();
+    const char* readp = source;
+    const char* readend = readp + source_len;
     char c = 0;
     while (readp < readend) {
+        // Copy the run of the characters which are written as is at once,
+        // and only the others are handled one by one
+        const char* e = SIMDScan::FindQuoteCandidate(readp, readend, utf8_to_unicode);
+        if (e != readp) {
+            sb.Write(readp, e - readp);
+            readp = e;
+            if (readp == readend) {
+                break;
+            }
+        }
+
         c = *readp++;
         switch (c) {
         case '\\':
@@ -310,7 +551,7 @@ void JSONObject::Quote(const string& source, bool utf8_to_unicode, simcc::DataSt
             // So I add a flag to allow this compatibility mode and prevent this
             // sequence from occurring.
 #if 1
-            if (readp > source.data() && *(readp - 1) == '<') {
+            if (readp > source && *(readp - 1) == '<') {
                 sb.Write('\\');
             }
             sb.Write(c);
@@ -336,8 +577,12 @@ void JSONObject::Quote(const string& source, bool utf8_to_unicode, simcc::DataSt
         default:
             if (utf8_to_unicode) {
                 //Reference of jansson-2.0.1 http://www.digip.org/jansson/
+                // The source may not be NUL-terminated, don't read past its end
                 int32_t codepoint = 0;
-                const char* end = utf8_iterate(readp - 1, &codepoint);
+                const char* end = NULL;
+                if (utf8_check_first(c) <= readend - readp + 1) {
+                    end = utf8_iterate(readp - 1, &codepoint);
+                }
                 if (!end) {
                     //This is not a ASCII code and also NOT an UTF8 code,
                     //Maybe it is GBK Chinese code, so we just write it
@@ -348,7 +593,10 @@ void JSONObject::Quote(const string& source, bool utf8_to_unicode, simcc::DataSt
                 if (codepoint <= 0x7F) {
                     sb.Write(static_cast<char>(codepoint));
                 } else {
-                    JSONTokener::EncodeUnicodeNumber(codepoint, sb);
+                    char encbuf[12];
+                    simcc::uint32 encbuf_len = 0;
+                    JSONTokener::EncodeUnicodeNumber(codepoint, encbuf, encbuf_len);
+                    sb.Write(encbuf, encbuf_len);
                     readp = end;
                 }
                 break;
@@ -362,7 +610,28 @@ void JSONObject::Quote(const string& source, bool utf8_to_unicode, simcc::DataSt
     sb.Write('"');
 }
 
-Object* JSONObject::Get(const string& key)const {
+JSONObject::iterator JSONObject::FindKey(const string& key) {
+#if defined(H_JSON_INTERNED_KEY) && defined(H_JSON_FLAT_MAP)
+    // Compare the text with the keys of this object, the global key table
+    // is not touched, so no lock or reference count is needed
+    size_t hash = key.empty() ? 0 : JSONKey::Hash(key.data(), key.size());
+    return map_.find_by_hash(hash, [hash, &key](const JSONKey& k) {
+        return k.hash() == hash && k.str() == key;
+    });
+#elif defined(H_JSON_INTERNED_KEY)
+    // The std::map is ordered by the text, see JSONKey::Probe
+    return map_.find(JSONKey::Probe(key.data(), key.size()));
+#else
+    return map_.find(key);
+#endif
+}
+
+JSONObject::const_iterator JSONObject::FindKey(const string& key) const {
+    return const_cast<JSONObject*>(this)->FindKey(key);
+}
+
+#ifdef H_JSON_INTERNED_KEY
+Object* JSONObject::Get(const JSONKey& key) const {
     const_iterator it = map_.find(key);
     if (it != map_.end()) {
         return (it->second);
@@ -370,9 +639,19 @@ Object* JSONObject::Get(const string& key)const {
 
     return NULL;
 }
+#endif
+
+Object* JSONObject::Get(const string& key)const {
+    const_iterator it = FindKey(key);
+    if (it != map_.end()) {
+        return (it->second);
+    }
+
+    return NULL;
+}
 
 JSONBoolean* JSONObject::GetJSONBoolean(const string& key) const {
-    const_iterator it = map_.find(key);
+    const_iterator it = FindKey(key);
     if (it != map_.end()) {
         return cast<JSONBoolean>(it->second.get());
     }
@@ -381,7 +660,7 @@ JSONBoolean* JSONObject::GetJSONBoolean(const string& key) const {
 }
 
 JSONDouble* JSONObject::GetJSONDouble(const string& key)const {
-    const_iterator it = map_.find(key);
+    const_iterator it = FindKey(key);
     if (it != map_.end()) {
         return cast<JSONDouble>((it->second).get());
     }
@@ -390,7 +669,7 @@ JSONDouble* JSONObject::GetJSONDouble(const string& key)const {
 }
 
 JSONInteger* JSONObject::GetJSONInteger(const string& key)const {
-    const_iterator it = map_.find(key);
+    const_iterator it = FindKey(key);
     if (it != map_.end()) {
         return cast<JSONInteger>((it->second).get());
     }
@@ -399,7 +678,7 @@ JSONInteger* JSONObject::GetJSONInteger(const string& key)const {
 }
 
 JSONArray* JSONObject::GetJSONArray(const string& key)const {
-    const_iterator it = map_.find(key);
+    const_iterator it = FindKey(key);
     if (it != map_.end()) {
         return cast<JSONArray>((it->second).get());
     }
@@ -408,7 +687,7 @@ JSONArray* JSONObject::GetJSONArray(const string& key)const {
 }
 
 JSONObject* JSONObject::GetJSONObject(const string& key)const {
-    const_iterator it = map_.find(key);
+    const_iterator it = FindKey(key);
     if (it != map_.end()) {
         return cast<JSONObject>((it->second).get());
     }
@@ -416,8 +695,52 @@ JSONObject* JSONObject::GetJSONObject(const string& key)const {
     return NULL;
 }
 
+void Object::Unshare(ObjectPtr& o) {
+    if (!o->shared_ || o->RefCount() <= 1) {
+        return;
+    }
+
+    if (o->IsTypeOf(kJSONObject)) {
+        JSONObject* copy = new JSONObject;
+        copy->GetObjects() = static_cast<JSONObject*>(o.get())->GetObjects();
+        for (auto it = copy->begin(), ite = copy->end(); it != ite; ++it) {
+            it->second->shared_ = true;
+        }
+        o = copy;
+    } else if (o->IsTypeOf(kJSONArray)) {
+        const JSONArray* ja = static_cast<JSONArray*>(o.get());
+        JSONArray* copy = new JSONArray;
+        copy->reserve(ja->size());
+        for (auto it = ja->begin(), ite = ja->end(); it != ite; ++it) {
+            (*it)->shared_ = true;
+            copy->Put(*it);
+        }
+        o = copy;
+    }
+}
+
+JSONArray* JSONObject::GetMutableJSONArray(const string& key) {
+    iterator it = FindKey(key);
+    if (it == map_.end() || !it->second->IsTypeOf(kJSONArray)) {
+        return NULL;
+    }
+
+    Object::Unshare(it->second);
+    return static_cast<JSONArray*>(it->second.get());
+}
+
+JSONObject* JSONObject::GetMutableJSONObject(const string& key) {
+    iterator it = FindKey(key);
+    if (it == map_.end() || !it->second->IsTypeOf(kJSONObject)) {
+        return NULL;
+    }
+
+    Object::Unshare(it->second);
+    return static_cast<JSONObject*>(it->second.get());
+}
+
 JSONString* JSONObject::GetJSONString(const string& key)const {
-    const_iterator it = map_.find(key);
+    const_iterator it = FindKey(key);
     if (it != map_.end()) {
         return cast<JSONString>((it->second).get());
     }
@@ -425,17 +748,20 @@ JSONString* JSONObject::GetJSONString(const string& key)const {
     return NULL;
 }
 
+JSONStringView* JSONObject::GetJSONStringView(const string& key)const {
+    const_iterator it = FindKey(key);
+    if (it != map_.end()) {
+        return cast<JSONStringView>((it->second).get());
+    }
+
+    return NULL;
+}
 
 
-void JSONObject::ToString(string& s, bool readable, bool utf8_to_unicode) const {
-    size_t indent = 0;
-    if (readable) {
-        indent = 1;
-    }
 
-    buf_.Reset();
-    ToStringBuf(buf_, indent, utf8_to_unicode);
-    s.assign(buf_.data(), buf_.size());
+void JSONObject::ToString(string& s, bool readable, bool utf8_to_unicode) const {
+    s.clear();
+    JSONWriter::Serialize(*this, s, readable, utf8_to_unicode);
 }
 
 void JSONObject::ToStringBuf(simcc::DataStream& sb, size_t indent, bool utf8_to_unicode) const {
@@ -539,6 +865,20 @@ simcc::float64 JSONObject::GetDecimal(const string& strKey, simcc::float64 defau
     return default_value;
 }
 
+Slice JSONObject::GetSlice(const string& strKey, const Slice& default_value)const {
+    Object* o = Get(strKey);
+    if (o) {
+        if (o->IsTypeOf(kJSONStringView)) {
+            return ((JSONStringView*)o)->slice();
+        }
+
+        if (o->IsTypeOf(kJSONString)) {
+            return Slice(((JSONString*)o)->value());
+        }
+    }
+    return default_value;
+}
+
 simcc::int64 JSONObject::GetInteger(const string& strKey, simcc::int64 default_value)const {
     JSONInteger* v = GetJSONInteger(strKey);
     if (v) {
@@ -558,60 +898,39 @@ const string&  JSONObject::GetString(const string& strKey, const string& default
     return default_value;
 }
 
-template<class T>
-bool JSONObject::PutIntegerArray(const string& key, const T* value, simcc::uint32 count) {
-    JSONArray* array = new JSONArray();
-    for (simcc::uint32 i = 0; i < count; ++i) {
-        array->Put(new JSONInteger(static_cast<simcc::int64>(value[i])));
-    }
-    return Put(key, array);
-}
-
 bool JSONObject::PutByteArray(const string& key, const simcc::int8* value, simcc::uint32 count) {
-    return PutIntegerArray<simcc::int8>(key, value, count);
+    JSONArray* array = new JSONArray();
+    return Put(key, array->PutByteArray(value, count));
 }
 
 bool JSONObject::PutInt32Array(const string& key, const simcc::int32* value, simcc::uint32 count) {
-    return PutIntegerArray<simcc::int32>(key, value, count);
+    JSONArray* array = new JSONArray();
+    return Put(key, array->PutInt32Array(value, count));
 }
 
 bool JSONObject::PutInt64Array(const string& key, const simcc::int64* value, simcc::uint32 count) {
-    return PutIntegerArray<simcc::int64>(key, value, count);
+    JSONArray* array = new JSONArray();
+    return Put(key, array->PutInt64Array(value, count));
 }
 
 bool JSONObject::PutFloat32Array(const string& key, const simcc::float32* value, simcc::uint32 count) {
     JSONArray* array = new JSONArray();
-    for (simcc::uint32 i = 0; i < count; ++i) {
-        array->Put(new JSONDouble(simcc::float64(value[i])));
-    }
-
-    return Put(key, array);
+    return Put(key, array->PutFloat32Array(value, count));
 }
 
 bool JSONObject::PutFloat64Array(const string& key, const simcc::float64* value, simcc::uint32 count) {
     JSONArray* array = new JSONArray();
-    for (simcc::uint32 i = 0; i < count; ++i) {
-        array->Put(new JSONDouble(simcc::float64(value[i])));
-    }
-    return Put(key, array);
+    return Put(key, array->PutFloat64Array(value, count));
 }
 
-
 bool JSONObject::PutBoolArray(const string& key, const bool* value, simcc::uint32 count) {
     JSONArray* array = new JSONArray();
-    for (simcc::uint32 i = 0; i < count; ++i) {
-        array->Put(new JSONBoolean(value[i]));
-    }
-    return Put(key, array);
+    return Put(key, array->PutBoolArray(value, count));
 }
 
-
 bool JSONObject::PutStringArray(const string& key, const string* value, simcc::uint32 count) {
     JSONArray* array = new JSONArray();
-    for (simcc::uint32 i = 0; i < count; ++i) {
-        array->Put(new JSONString(value[i]));
-    }
-    return Put(key, array);
+    return Put(key, array->PutStringArray(value, count));
 }
 
 void JSONObject::Merge(const JSONObject* rhs, bool override) {
@@ -621,21 +940,28 @@ void JSONObject::Merge(const JSONObject* rhs, bool override) {
 
     const_iterator itrhs(rhs->map_.begin()), iterhs(rhs->map_.end());
     for (; itrhs != iterhs; ++itrhs) {
-        iterator iterthis = map_.find(itrhs->first);
-        if (iterthis == map_.end()) {
-            map_[itrhs->first] = itrhs->second;
+        // The value of rhs is shared if the key is new
+        std::pair<iterator, bool> r = map_.insert(*itrhs);
+        if (r.second) {
+            itrhs->second->shared_ = true;
             continue;
         }
 
-        // recursive Merge
-        json::ObjectPtr& joriginal = map_[itrhs->first];
+        json::ObjectPtr& joriginal = r.first->second;
+        if (joriginal == itrhs->second) {
+            continue; // Shared by an earlier Merge
+        }
+
+        // recursive Merge, into a copy if the object is shared
         if (joriginal->IsTypeOf(kJSONObject) && itrhs->second->IsTypeOf(kJSONObject)) {
+            Object::Unshare(joriginal);
             static_cast<json::JSONObject*>(joriginal.get())->Merge(static_cast<json::JSONObject*>(itrhs->second.get()), override);
             continue;
         }
 
         if (override) {
             joriginal = itrhs->second;
+            joriginal->shared_ = true;
         }
     }
 }
@@ -652,7 +978,7 @@ bool JSONObject::LoadFrom(simcc::DataStream& file) {
             Put(key, o);
             o = NULL;
         } else {
-            set_error(kDeserializeBinaryDataError);
+            set_error(JSONParser::kDeserializeBinaryDataError);
             return false;
         }
     }
@@ -665,7 +991,7 @@ void JSONObject::SaveTo(simcc::DataStream& file) const {
          << (simcc::uint32)map_.size();
     auto it(map_.begin()), ite(map_.end());
     for (; it != ite; it++) {
-        file << it->first;
+        file << static_cast<const string&>(it->first);
         it->second->SaveTo(file);
     }
 }
@@ -681,12 +1007,12 @@ bool JSONObject::Equals(const Object& rhs) {
         return false;
     }
 
+    // Lookup every key in rhs, so it does not depend on the iteration order
     auto itthis(map_.begin());
     auto itethis(map_.end());
-    auto itrhs(rhsJSONOBject.begin());
-    auto iterhs(rhsJSONOBject.end());
-    for (; itthis != itethis && itrhs != iterhs; ++itthis, ++itrhs) {
-        if (itthis->first != itrhs->first) {
+    for (; itthis != itethis; ++itthis) {
+        auto itrhs = rhsJSONOBject.map_.find(itthis->first);
+        if (itrhs == rhsJSONOBject.map_.end()) {
             return false;
         }
 
@@ -700,13 +1026,13 @@ bool JSONObject::Equals(const Object& rhs) {
 
 void JSONObject::Remove(const Object* pobj) {
     iterator it(map_.begin());
-    iterator ite(map_.end());
-    for (; it != ite; ++it) {
+    while (it != map_.end()) {
         if (it->second == pobj) {
-            map_.erase(it);
+            it = map_.erase(it);
+        } else {
+            ++it;
         }
     }
-
 }
 
 // Save, Serializer. Save the object into a memory data stream
@@ -721,7 +1047,7 @@ simcc::DataStream& operator >> (simcc::DataStream& file, JSONObject& val) {
     file >> type;
     assert(type == kJSONObject);
     if (!val.LoadFrom(file)) {
-        val.set_error(JSONObject::kLoadBinaryDataError);
+        val.set_error(JSONParser::kLoadBinaryDataError);
     }
     return file;
 }
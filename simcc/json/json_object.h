@@ -7,13 +7,39 @@
 #include "json_value.h"
 #include "json_parser.h"
 
+#include <memory>
+
+#ifdef H_JSON_FLAT_MAP
+#include "json_flat_map.h"
+#endif
+
+#ifdef H_JSON_INTERNED_KEY
+#include "json_key.h"
+#endif
+
 namespace simcc {
 namespace json {
 class JSONArray;
 class JSONTokener;
-class SIMCC_EXPORT JSONObject : public Object, public JSONParser {
+class SIMCC_EXPORT JSONObject : public Object, public JSONErrorCodes {
 public:
-    typedef std::map<string, ObjectPtr>             ObjectPtrMap;
+#ifdef H_JSON_INTERNED_KEY
+    // The keys are interned, so the same key of many objects is stored
+    // only once and compared by pointer. See JSONKey for more details.
+    typedef JSONKey                                 KeyType;
+    typedef JSONKey::Hasher                         KeyHasher;
+#else
+    typedef string                                  KeyType;
+    typedef std::hash<string>                       KeyHasher;
+#endif
+
+#ifdef H_JSON_FLAT_MAP
+    // An insertion-ordered flat hash map, which is much faster to lookup
+    // than std::map for big objects. See FlatMap for more details.
+    typedef FlatMap<KeyType, ObjectPtr, KeyHasher>  ObjectPtrMap;
+#else
+    typedef std::map<KeyType, ObjectPtr>            ObjectPtrMap;
+#endif
     typedef ObjectPtrMap                            Map;
     typedef ObjectPtrMap::iterator                  Iterator;
     typedef ObjectPtrMap::const_iterator            ConstIterator;
@@ -59,6 +85,30 @@ public:
     // @return number of characters parsed. Return 0 if failed to parse.
     simcc::uint32 Parse(const char* source, const simcc::int64 source_len = -1);
 
+    // The same as Parse, but the strings without escapes are not copied,
+    // they are JSONStringView objects which refer to the source text.
+    // Read them by GetSlice. The keys are copied as usual.
+    // @note The source text MUST outlive this JSONObject
+    simcc::uint32 ParseInSitu(const char* source, const simcc::int64 source_len = -1);
+
+    // The error of the last Parse or ParseInSitu of this object.
+    //   The parse state lives in a JSONParser during parsing, and it is only
+    // kept here when the parsing failed, so the objects of a document
+    // don't carry it.
+    JSONParser::ErrorCode error() const {
+        return parser_ ? parser_->error() : JSONParser::kNoError;
+    }
+
+    const char* strerror() const;
+
+    bool ok() const {
+        return error() == JSONParser::kNoError;
+    }
+
+    size_t error_location() const {
+        return parser_ ? parser_->error_location() : 0;
+    }
+
     using Object::ToString; // string ToString(bool readable = false, bool utf8_to_unicode = true) const;
     virtual void ToString(string& s, bool readable = false, bool utf8_to_unicode = true) const;
     virtual void ToStringBuf(simcc::DataStream& sb, size_t indent = 0, bool utf8_to_unicode = true) const;
@@ -86,19 +136,38 @@ public:
     // @return A simple JSON value.
     static Object* ConvertToObject(const char* s, size_t len, JSONParser* parser, JSONTokener* x);
 
+    // The same as ConvertToObject, but the value is stored in <code>v</code>
+    // and no json object is created.
+    // @return false if the string can't be converted
+    static bool ConvertToScalar(const char* s, size_t len, JSONParser* parser, JSONTokener* x, JSONScalar& v);
+
 public:
     // Get the object value associated with key value.
     // @param key  the key value
     // @return An object value.
     //   NULL, If there is no value for the index.
     Object*      Get(const string& key) const;
+#ifdef H_JSON_INTERNED_KEY
+    // The faster lookup without hashing the key text
+    Object*      Get(const JSONKey& key) const;
+#endif
     JSONBoolean* GetJSONBoolean(const string& key) const;
     JSONDouble*  GetJSONDouble(const string& key) const;
     JSONInteger* GetJSONInteger(const string& key) const;
     JSONString*  GetJSONString(const string& key) const;
+    JSONStringView* GetJSONStringView(const string& key) const;
     JSONArray*   GetJSONArray(const string& key) const;
     JSONObject*  GetJSONObject(const string& key) const;
 
+    // The same as GetJSONArray and GetJSONObject, but the value can be modified.
+    // A value may be shared with the other objects by Merge, so a shared
+    // value is replaced by its copy before it is returned (copy-on-write).
+    // The copy is shallow, and its own values are still shared.
+    // @note Copy-on-write is opt-in. The other getters return the shared
+    //   values as they are, so modifying them changes the other objects too.
+    JSONArray*   GetMutableJSONArray(const string& key);
+    JSONObject*  GetMutableJSONObject(const string& key);
+
     // Gets a value
     // @param strKey, the key
     // @param default_value, the default value.
@@ -112,6 +181,10 @@ public:
     // Get a decimal number whether it is a JSONDouble or a JSONInteger
     simcc::float64 GetDecimal(const string& strKey, float64 default_value = 0.0) const;
 
+    // Get a string whether it is a JSONString or a JSONStringView, no copy is made.
+    // It is invalidated by any modification of the string.
+    Slice GetSlice(const string& strKey, const Slice& default_value = Slice()) const;
+
     //   Put a key/value pair into the JSONObject.
     //   If a item which is associated with key is exist,
     // the old value is deleted, and the new value is inserted.
@@ -153,7 +226,10 @@ public:
     }
 
     void erase(const string& key) {
-        map_.erase(key);
+        iterator it = FindKey(key);
+        if (it != map_.end()) {
+            map_.erase(it);
+        }
     }
 
     // Returns the number of elements in the this JSON object
@@ -182,6 +258,11 @@ public:
     //   this new value from <code>rhs</code> will override the original value
     //   when <code>override</code> is true; or the value of the key in this
     //   JSONObject will has no change.
+    // @note The values of <code>rhs</code> are shared instead of being copied,
+    //   and marked as shared. A JSONObject is merged in place, as a holder
+    //   of it expects, unless it is shared by an earlier Merge: then it is
+    //   copied first, so the object it came from is never changed.
+    //   See GetMutableJSONObject to modify a shared value.
     // @param rhs
     // @param override -
     void Merge(const JSONObject* rhs, bool override);
@@ -239,13 +320,14 @@ protected:
     // @param rs the produced string by this function
     // @return  true, if success, or false
     static void Quote(const string& source, bool utf8_to_unicode, simcc::DataStream& sb);
-
-    template<class T>
-    bool PutIntegerArray(const string& key, const T* value, simcc::uint32 count);
+    static void Quote(const char* source, size_t source_len, bool utf8_to_unicode, simcc::DataStream& sb);
 
     friend class JSONTokener;
+    friend class JSONWriter;
+    friend class JSONBinder;
     friend class JSONArray;
     friend class JSONString;
+    friend class JSONStringView;
     friend class JSONDouble;
     friend class JSONInteger;
     friend class JSONBoolean;
@@ -254,6 +336,9 @@ protected:
     // Return number of characters parsed.
     simcc::uint32 Parse(JSONTokener* token);
 
+    // Parse a (nested) object, the error is reported to <code>parser</code>
+    simcc::uint32 Parse(JSONTokener* token, JSONParser* parser);
+
     JSONObject(JSONTokener* token);
 
 private:
@@ -263,8 +348,15 @@ private:
     virtual bool LoadFrom(simcc::DataStream& file);
     virtual void SaveTo(simcc::DataStream& file) const;
 
+    void set_error(JSONParser::ErrorCode ec, size_t error_location = 0);
+
+    // Lookup a key given as a string
+    iterator FindKey(const string& key);
+    const_iterator FindKey(const string& key) const;
+
 private:
     ObjectPtrMap map_;
+    std::unique_ptr<JSONParser> parser_; // NULL unless the last parsing failed
 };
 
 typedef simcc::RefPtr<JSONObject>  JSONObjectPtr;
@@ -1,6 +1,8 @@
 #include "simcc/string_util.h"
 #include "simcc/data_stream.h"
+#include "simcc/mapped_file.h"
 #include "simcc/utility.h"
+#include "simcc/qh_palloc.h"
 #include "json.h"
 #include "json_tokener.h"
 
@@ -8,8 +10,7 @@ namespace simcc {
 namespace json {
 
 JSONParser::JSONParser()
-    : buf_(1024)
-    , error_code_(kNoError)
+    : error_code_(kNoError)
     , error_location_(0) {
 }
 
@@ -47,46 +48,151 @@ const char* JSONParser::strerror() const {
     H_CASE_STRING(kInvalidOctalCharacter);
     H_CASE_STRING(kDeserializeBinaryDataError);
     H_CASE_STRING(kLoadBinaryDataError);
+    H_CASE_STRING(kTerminatedByHandler);
+    H_CASE_STRING(kTypeMismatch);
+    H_CASE_STRING(kOutOfMemory);
     H_CASE_STRING_END();
 }
 
-ObjectPtr JSONParser::LoadFile(const string& json_file_path) {
-    simcc::DataStream ds;
-    if (!ds.ReadFile(json_file_path)) {
+ObjectPtr JSONParser::LoadFile(const string& json_file_path, simcc::qh::Pool* pool) {
+    simcc::MappedFile f;
+    if (!f.Open(json_file_path, simcc::MappedFile::kSequential)) {
         return nullptr;
     }
 
-    return Load(ds.data(), ds.size());
+    return Load(f.data(), f.size(), pool);
+}
+
+ObjectPtr JSONParser::LoadFileInSitu(const string& json_file_path, simcc::MappedFile& file, simcc::qh::Pool* pool) {
+    if (!file.Open(json_file_path, simcc::MappedFile::kSequential)) {
+        return nullptr;
+    }
+
+    return LoadInSitu(file.data(), file.size(), pool);
 }
 
 ObjectPtr JSONParser::Load(const char* source, const simcc::int64 source_len /*= -1 */) {
+    return Load(source, source_len, NULL);
+}
+
+namespace {
+void ReleasePooledObject(void* data) {
+    static_cast<Object*>(data)->Release();
+}
+
+void DestroyPooledObject(void* data) {
+    Object::Destroy(static_cast<Object*>(data));
+}
+}
+
+void JSONParser::Abandon(Object* o, simcc::qh::Pool* pool) {
+    if (pool) {
+        qh_pool_cleanup_t* cln = qh_pool_cleanup_add(pool->pool(), 0);
+        if (cln) {
+            cln->handler = &DestroyPooledObject;
+            cln->data = o;
+            return;
+        }
+    }
+
+    Object::Destroy(o);
+}
+
+simcc::uint32 JSONParser::Validate(const char* source, const simcc::int64 source_len) {
+    if (source_len == 0 || !source) {
+        set_error(kParameterWrong);
+        return 0;
+    }
+
+    // The same root as Load
+    json::JSONTokener x(source, source_len);
+    if (!x.SkipComment()) {
+        set_error(kCommentFormatError, &x);
+        return 0;
+    }
+
+    char c = x.NextClean();
+    if (c != '{' && c != '[') {
+        set_error(kInvalidCharacter, &x);
+        return 0;
+    }
+    x.Back();
+
+    // The default handler ignores every value
+    JSONSAXHandler ignored;
+    JSONSAXParser p;
+    simcc::uint32 n = p.Parse(&x, &ignored);
+    set_error(p.error(), p.error_location());
+    return n;
+}
+
+ObjectPtr JSONParser::Load(const char* source, const simcc::int64 source_len, simcc::qh::Pool* pool) {
+    if (source_len == 0 || !source) {
+        return nullptr;
+    }
+
+    json::JSONTokener x(source, source_len);
+    return Load(x, pool);
+}
+
+ObjectPtr JSONParser::LoadInSitu(const char* source, const simcc::int64 source_len, simcc::qh::Pool* pool) {
     if (source_len == 0 || !source) {
         return nullptr;
     }
 
     json::JSONTokener x(source, source_len);
+    x.set_in_situ(true);
+    return Load(x, pool);
+}
+
+ObjectPtr JSONParser::Load(JSONTokener& x, simcc::qh::Pool* pool) {
+    x.set_pool(pool);
     if (!x.SkipComment()) {
         return nullptr;
     }
 
+    JSONParser parser;
     char c = x.NextClean();
+    Object* root = NULL;
+    bool ok = false;
     if (c == '{') {
-        JSONObjectPtr jo = new JSONObject();
-        x.Back();
-        if (jo->Parse(&x) && jo->error() == kNoError) {
-            return jo.get();
+        JSONObject* jo = Object::New<JSONObject>(pool);
+        if (!jo) {
+            return nullptr;
         }
-        return nullptr;
-    } else if (c == '[') {
-        JSONArrayPtr ja = new JSONArray();
         x.Back();
-        if (ja->Parse(&x) && ja->error() == kNoError) {
-            return ja.get();
+        root = jo;
+        ok = jo->Parse(&x, &parser) && parser.ok();
+    } else if (c == '[') {
+        JSONArray* ja = Object::New<JSONArray>(pool);
+        if (!ja) {
+            return nullptr;
         }
+        x.Back();
+        root = ja;
+        ok = ja->Parse(&x, &parser) && parser.ok();
+    } else {
         return nullptr;
     }
 
-    return nullptr;
+    if (!ok) {
+        Abandon(root, pool);
+        return nullptr;
+    }
+
+    ObjectPtr o(root);
+    if (pool) {
+        // The pool holds a reference, the document will be released when the pool is reset or destroyed
+        qh_pool_cleanup_t* cln = qh_pool_cleanup_add(pool->pool(), 0);
+        if (!cln) {
+            return nullptr;
+        }
+        o->Ref();
+        cln->handler = &ReleasePooledObject;
+        cln->data = o.get();
+    }
+
+    return o;
 }
 
 }
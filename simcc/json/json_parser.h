@@ -6,10 +6,13 @@
 #include "json_common.h"
 
 namespace simcc {
+class MappedFile;
+
 namespace json {
 
-class SIMCC_EXPORT JSONParser {
-public:
+// The error codes of the parsing. JSONObject and JSONArray derive from it
+// as well, so the codes can be spelled as JSONObject::kXxx too.
+struct JSONErrorCodes {
     enum ErrorCode {
         kNoError = 0,
         kParameterWrong,
@@ -34,7 +37,14 @@ public:
 
         kDeserializeBinaryDataError,
         kLoadBinaryDataError,
+
+        kTerminatedByHandler, //The parsing is stopped by the JSONSAXHandler
+        kTypeMismatch, //A value can't be stored in the member bound by JSONBinder
+        kOutOfMemory, //A json object can't be allocated from the memory pool
     };
+};
+
+class SIMCC_EXPORT JSONParser : public JSONErrorCodes {
 public:
     JSONParser();
 
@@ -65,7 +75,43 @@ public:
     //         use error() to get the error code
     static ObjectPtr Load(const char* source, const simcc::int64 source_len = -1);
 
-    static ObjectPtr LoadFile(const string& json_file_path);
+    // Construct a JSONArray or JSONObject from the source JSON text,
+    // all the json objects of the document are allocated from <code>pool</code>.
+    //   The pool holds a reference of the document, so the whole document
+    // is released at once by qh_reset_pool/qh_destroy_pool.
+    // @note The returned ObjectPtr MUST NOT be used after the pool is reset or destroyed.
+    // @param pool The memory pool. If it is NULL, it is the same as Load(source, source_len)
+    static ObjectPtr Load(const char* source, const simcc::int64 source_len, simcc::qh::Pool* pool);
+
+    // The same as Load, but the strings without escapes are JSONStringView
+    // objects which refer to the source text instead of copying it.
+    // @note The source text MUST outlive the returned document
+    static ObjectPtr LoadInSitu(const char* source, const simcc::int64 source_len, simcc::qh::Pool* pool = NULL);
+
+    // Construct a JSONArray or JSONObject from a file. The file is memory mapped
+    // and parsed directly, instead of being read into a buffer.
+    static ObjectPtr LoadFile(const string& json_file_path, simcc::qh::Pool* pool = NULL);
+
+    // The same as LoadFile, but the strings without escapes refer to the
+    // mapped file (see LoadInSitu).
+    // @param file[out] The mapped file, which MUST outlive the returned document
+    static ObjectPtr LoadFileInSitu(const string& json_file_path, simcc::MappedFile& file, simcc::qh::Pool* pool = NULL);
+
+    // Check whether <code>source</code> is a JSONObject or JSONArray text which
+    // can be loaded by Load, without creating any json object. The strings
+    // and spaces are scanned by SIMDScan, so a malformed text is rejected
+    // without paying for the objects Load would build before the error.
+    // @return number of characters checked. Return 0 if the text is malformed,
+    //   and the error is set as Load does.
+    simcc::uint32 Validate(const char* source, const simcc::int64 source_len = -1);
+
+private:
+    static ObjectPtr Load(JSONTokener& x, simcc::qh::Pool* pool);
+
+    // Give up a partial document which failed to parse. When it is allocated
+    // from <code>pool</code>, it is destroyed along with the pool instead of
+    // being torn down node by node now.
+    static void Abandon(Object* o, simcc::qh::Pool* pool);
 
 protected:
     void set_error(ErrorCode ec, JSONTokener* x = NULL);
@@ -76,7 +122,6 @@ protected:
     friend class JSONObject;
     friend class JSONTokener;
 
-    mutable simcc::DataStream buf_;// The data cache buffer for the sake of improve performance
 private:
     ErrorCode error_code_;
     size_t error_location_;//the offset of the <code>source</code>
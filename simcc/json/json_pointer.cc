@@ -0,0 +1,233 @@
+#include "simcc/inner_pre.h"
+
+#include "json.h"
+#include "json_pointer.h"
+#include "json_tokener.h"
+
+namespace simcc {
+namespace json {
+
+namespace {
+// @return npos if the token is not an array index,
+//   which is "0" or a decimal number without the leading zeros
+size_t ToIndex(const string& s, size_t npos) {
+    if (s.empty() || s.size() > 18 || (s[0] == '0' && s.size() > 1)) {
+        return npos;
+    }
+
+    size_t n = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') {
+            return npos;
+        }
+        n = n * 10 + (c - '0');
+    }
+    return n;
+}
+}
+
+JSONPointer::JSONPointer() : ok_(true) {
+}
+
+JSONPointer::JSONPointer(const string& path) : ok_(true) {
+    Compile(path);
+}
+
+bool JSONPointer::Compile(const string& path) {
+    path_ = path;
+    tokens_.clear();
+    ok_ = false;
+
+    if (!path.empty() && path[0] != '/') {
+        return false;
+    }
+
+    string s;
+    for (size_t i = 0; i < path.size();) {
+        // path[i] is '/'
+        s.clear();
+        for (++i; i < path.size() && path[i] != '/'; ++i) {
+            char c = path[i];
+            if (c == '~') {
+                if (i + 1 == path.size() || (path[i + 1] != '0' && path[i + 1] != '1')) {
+                    tokens_.clear();
+                    return false;
+                }
+                c = path[++i] == '0' ? '~' : '/';
+            }
+            s.push_back(c);
+        }
+
+        Token t;
+        t.key = JSONObject::KeyType(s);
+        t.index = ToIndex(s, npos);
+        tokens_.push_back(t);
+    }
+
+    ok_ = true;
+    return true;
+}
+
+Object* JSONPointer::Find(const Object* root) const {
+    if (!ok_) {
+        return NULL;
+    }
+
+    const Object* o = root;
+    for (auto& t : tokens_) {
+        if (!o) {
+            return NULL;
+        }
+
+        switch (o->type()) {
+        case kJSONObject:
+            o = static_cast<const JSONObject*>(o)->Get(t.key);
+            break;
+        case kJSONArray: {
+            const JSONArray::ObjectPtrList& list = static_cast<const JSONArray*>(o)->GetObjects();
+            if (t.index >= list.size()) {
+                return NULL;
+            }
+            o = list[t.index].get();
+            break;
+        }
+        default:
+            return NULL;
+        }
+    }
+
+    return const_cast<Object*>(o);
+}
+
+JSONLazyValue JSONPointer::Find(const JSONLazyValue& root) const {
+    if (!ok_) {
+        return JSONLazyValue();
+    }
+
+    JSONLazyValue v = root;
+    for (auto& t : tokens_) {
+        if (!v.valid()) {
+            break;
+        }
+
+        if (v.type() == kJSONArray) {
+            v = t.index == npos ? JSONLazyValue() : v.Get(t.index);
+        } else {
+            v = v.Get(static_cast<const string&>(t.key));
+        }
+    }
+
+    return v;
+}
+
+bool JSONPointer::Find(const char* source, size_t source_len, Slice& value) const {
+    if (!ok_ || !source || source_len == 0) {
+        return false;
+    }
+
+    JSONTokener x(source, static_cast<simcc::int32>(source_len));
+    for (auto& t : tokens_) {
+        if (!x.SkipComment()) {
+            return false;
+        }
+
+        char c = x.NextClean();
+        if (c == '{') {
+            if (!FindMember(&x, t)) {
+                return false;
+            }
+        } else if (c == '[' || c == '(') {
+            if (t.index == npos || !FindElement(&x, t.index, c == '[' ? ']' : ')')) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    // x is at the referred value now
+    if (!x.SkipComment()) {
+        return false;
+    }
+
+    x.SkipSpaces();
+    const char* begin = x.GetCurrent();
+    if (!x.SkipValue()) {
+        return false;
+    }
+
+    // The spaces are allowed at the end of an unquoted text
+    const char* end = x.GetCurrent();
+    while (end > begin && static_cast<unsigned char>(*(end - 1)) <= ' ') {
+        --end;
+    }
+
+    value = Slice(begin, end - begin);
+    return true;
+}
+
+bool JSONPointer::FindMember(JSONTokener* x, const Token& t) const {
+    Slice key;
+    for (;;) {
+        if (!x->SkipComment()) {
+            return false;
+        }
+
+        // a key must be a string
+        if (x->NextClean() != '"' || !x->NextString('"', false, key)) {
+            return false;
+        }
+
+        if (!x->SkipComment() || x->NextClean() != ':') {
+            return false;
+        }
+
+        if (key.size() == t.key.size() && memcmp(key.data(), t.key.data(), key.size()) == 0) {
+            return true;
+        }
+
+        if (!x->SkipValue() || !x->SkipComment()) {
+            return false;
+        }
+
+        // pairs are separated by ','
+        if (x->NextClean() != ',') {
+            return false; // '}' or a syntax error
+        }
+    }
+}
+
+bool JSONPointer::FindElement(JSONTokener* x, size_t index, char close) const {
+    for (size_t i = 0;; ++i) {
+        if (!x->SkipComment()) {
+            return false;
+        }
+
+        char c = x->NextClean();
+        if (c == close || c == 0) {
+            return false;
+        }
+
+        x->Back();
+        if (i == index) {
+            // A blank element is a null, but it has no text
+            return c != ',';
+        }
+
+        if (c != ',' && !x->SkipValue()) {
+            return false;
+        }
+
+        if (!x->SkipComment()) {
+            return false;
+        }
+
+        c = x->NextClean();
+        if (c != ',' && c != ';') {
+            return false; // the close bracket or a syntax error
+        }
+    }
+}
+
+}
+}
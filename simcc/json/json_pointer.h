@@ -0,0 +1,91 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+#include "simcc/slice.h"
+
+#include "json_common.h"
+#include "json_object.h"
+#include "json_lazy.h"
+
+#include <vector>
+
+namespace simcc {
+namespace json {
+
+// A compiled JSON Pointer (RFC 6901), e.g. "/user/tags/3".
+//
+// The path is parsed only once by Compile, and the pointer can be evaluated
+// again and again against the json object trees, a JSONLazyDocument or
+// the raw json text directly, without any allocation.
+//
+// A reference token is used as a key of an object, or as an index of an
+// array if it is a decimal number. "~1" and "~0" are unescaped to '/'
+// and '~'. The empty path "" refers to the whole document.
+//
+// Usage:
+//    JSONPointer p("/user/tags/3");
+//    Object* tag = p.Find(jo);
+//    Slice raw;
+//    if (p.Find(text.data(), text.size(), raw)) { ... }
+//
+// @note A compiled JSONPointer is immutable, so it can be shared by threads
+class SIMCC_EXPORT JSONPointer {
+public:
+    JSONPointer();
+
+    // The same as Compile, use ok() to check whether the path is valid
+    explicit JSONPointer(const string& path);
+
+    // @return false if the path is not empty and doesn't begin with '/'
+    //   or there is an invalid escape sequence in it.
+    bool Compile(const string& path);
+
+    bool ok() const {
+        return ok_;
+    }
+
+    const string& path() const {
+        return path_;
+    }
+
+    // The number of the reference tokens
+    size_t size() const {
+        return tokens_.size();
+    }
+
+    // Evaluate the pointer against a json object tree
+    // @return the object referred by the pointer or NULL if it is not found
+    Object* Find(const Object* root) const;
+
+    // Evaluate the pointer against a JSONLazyDocument, only the objects
+    // and arrays on the path are indexed.
+    // @return An invalid value if it is not found
+    JSONLazyValue Find(const JSONLazyValue& root) const;
+
+    // Evaluate the pointer against the raw json text. The members of the
+    // objects and the arrays are skipped until the referred value,
+    // no json object is built.
+    // @param value the source text of the referred value
+    //   (see JSONLazyValue::raw), which is valid until the source is changed
+    // @return false if it is not found or there is a syntax error on the path
+    bool Find(const char* source, size_t source_len, Slice& value) const;
+
+private:
+    struct Token {
+        JSONObject::KeyType key;
+        size_t index; // npos if the token is not an array index
+    };
+
+    static const size_t npos = static_cast<size_t>(-1);
+
+    bool FindMember(JSONTokener* x, const Token& t) const;
+    bool FindElement(JSONTokener* x, size_t index, char close) const;
+
+private:
+    string path_;
+    std::vector<Token> tokens_;
+    bool ok_;
+};
+
+}
+}
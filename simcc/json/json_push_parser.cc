@@ -0,0 +1,413 @@
+#include "simcc/inner_pre.h"
+
+#include "json.h"
+#include "json_push_parser.h"
+#include "json_tokener.h"
+
+namespace simcc {
+namespace json {
+
+JSONPushParser::JSONPushParser(JSONSAXHandler* handler)
+    : handler_(handler) {
+    Reset();
+}
+
+void JSONPushParser::Reset() {
+    set_error(kNoError, static_cast<size_t>(0));
+    status_ = kNeedMoreData;
+    lexer_ = kNoToken;
+    expect_ = kRoot;
+    stack_.clear();
+    token_begin_ = NULL;
+    token_.clear();
+    quote_ = 0;
+    key_ = false;
+    pending_ = false;
+    chunk_ = NULL;
+    position_ = 0;
+}
+
+JSONPushParser::Status JSONPushParser::Feed(const char* data, size_t len) {
+    if (status_ != kNeedMoreData) {
+        return status_;
+    }
+
+    chunk_ = data;
+    if (!handler_ || (!data && len > 0)) {
+        Fail(kParameterWrong, data);
+        return status_;
+    }
+
+    // The token of the previous chunks continues here
+    token_begin_ = data;
+
+    const char* p = data;
+    const char* end = data + len;
+    while (p < end && status_ == kNeedMoreData) {
+        switch (lexer_) {
+        case kNoToken:
+            p = ScanToken(p, end);
+            break;
+        case kString:
+            p = ScanString(p, end);
+            break;
+        case kText:
+            p = ScanText(p, end);
+            break;
+        default:
+            p = ScanComment(p, end);
+            break;
+        }
+
+        if (!p) {
+            return status_;
+        }
+    }
+
+    position_ += p - data;
+    return status_;
+}
+
+JSONPushParser::Status JSONPushParser::Finish() {
+    if (status_ != kNeedMoreData) {
+        return status_;
+    }
+
+    ErrorCode ec = kInvalidCharacter;
+    if (lexer_ == kString) {
+        ec = key_ ? kJSONObjectKeyNotString : kJSONStringNotQuoted;
+    } else if (lexer_ == kCommentBegin || lexer_ == kCStyleComment) {
+        ec = kCommentFormatError;
+    } else if (!stack_.empty()) {
+        ec = stack_.back().close == '}' ? kJSONObjectNotEndWithBraces : kJSONArrayNotEndWithBrackets;
+    }
+
+    set_error(ec, position_);
+    status_ = kFailed;
+    return status_;
+}
+
+const char* JSONPushParser::ScanToken(const char* p, const char* end) {
+    p = SIMDScan::SkipSpaces(p, end);
+    if (p == end) {
+        return end;
+    }
+
+    char c = *p;
+    if (c == '/') {
+        lexer_ = kCommentBegin;
+        return p + 1;
+    }
+
+    switch (expect_) {
+    case kRoot:
+        if (c == '{') {
+            return StartObject() ? p + 1 : Fail(kTerminatedByHandler, p);
+        }
+
+        if (c == '[' || c == '(') {
+            return StartArray(c) ? p + 1 : Fail(kTerminatedByHandler, p);
+        }
+        return Fail(kInvalidCharacter, p);
+    case kObjectKeyOrEnd:
+        if (c == '}') {
+            return EndContainer() ? p + 1 : Fail(kTerminatedByHandler, p);
+        }
+
+        if (c == '"') {  // a key must be a string
+            lexer_ = kString;
+            quote_ = c;
+            key_ = true;
+            token_.clear();
+            token_begin_ = p + 1;
+            return p + 1;
+        }
+        return Fail(c == 0 ? kJSONObjectNotEndWithBraces : kInvalidCharacter, p);
+    case kColon:
+        if (c != ':') {
+            return Fail(kKeyValueSeperatorError, p);
+        }
+        expect_ = kObjectValue;
+        return p + 1;
+    case kObjectValue:
+    case kArrayValueOrEnd:
+        return ScanValue(p);
+    case kObjectCommaOrEnd:
+        // pairs are separated by ','
+        if (c == ',') {
+            expect_ = kObjectKeyOrEnd;
+            return p + 1;
+        }
+
+        if (c == '}') {
+            return EndContainer() ? p + 1 : Fail(kTerminatedByHandler, p);
+        }
+        return Fail(kInvalidCharacter, p);
+    case kArrayCommaOrEnd:
+        if (c == ',' || c == ';') {
+            expect_ = kArrayValueOrEnd;
+            return p + 1;
+        }
+
+        if (c == stack_.back().close) {
+            return EndContainer() ? p + 1 : Fail(kTerminatedByHandler, p);
+        }
+        return Fail(kJSONArrayNotEndWithBrackets, p);
+    }
+
+    assert(false);
+    return Fail(kInvalidCharacter, p);
+}
+
+const char* JSONPushParser::ScanValue(const char* p) {
+    char c = *p;
+    switch (c) {
+    case '"':
+    case '\'':
+        lexer_ = kString;
+        quote_ = c;
+        key_ = false;
+        token_.clear();
+        token_begin_ = p + 1;
+        return p + 1;
+    case '{':
+        return StartObject() ? p + 1 : Fail(kTerminatedByHandler, p);
+    case '[':
+    case '(':
+        return StartArray(c) ? p + 1 : Fail(kTerminatedByHandler, p);
+    default:
+        break;
+    }
+
+    if (expect_ == kArrayValueOrEnd) {
+        if (c == stack_.back().close) {
+            return EndContainer() ? p + 1 : Fail(kTerminatedByHandler, p);
+        }
+
+        if (c == ',') {
+            // A blank element is a null, the ',' is parsed as the separator
+            if (!handler_->Null()) {
+                return Fail(kTerminatedByHandler, p);
+            }
+            EndValue();
+            return p;
+        }
+    }
+
+    //Handle unquoted text like: true, false, or null, or it can be a number.
+    if (!JSONTokener::IsUnquotedTextChar(c)) {
+        return Fail(kBlankValue, p);
+    }
+
+    lexer_ = kText;
+    token_.clear();
+    token_begin_ = p;
+    return p;
+}
+
+const char* JSONPushParser::ScanString(const char* p, const char* end) {
+    for (;;) {
+        if (pending_) {
+            // Skip the escaped character, it is checked when decoding the string
+            if (p == end) {
+                break;
+            }
+            pending_ = false;
+            ++p;
+        }
+
+        const char* e = SIMDScan::FindQuoteOrEscape(p, end, quote_);
+        if (e == end) {
+            break;
+        }
+
+        if (*e == quote_) {
+            lexer_ = kNoToken;
+            if (token_.empty()) {
+                return EndString(token_begin_, e + 1 - token_begin_, e);
+            }
+
+            token_.append(token_begin_, e + 1 - token_begin_);
+            return EndString(token_.data(), token_.size(), e);
+        }
+
+        if (*e == 0) {
+            return Fail(key_ ? kJSONObjectKeyNotString : kJSONStringNotQuoted, e);
+        }
+
+        // A backslash or a control character which is kept as it is
+        pending_ = (*e == '\\');
+        p = e + 1;
+    }
+
+    token_.append(token_begin_, end - token_begin_);
+    return end;
+}
+
+const char* JSONPushParser::ScanText(const char* p, const char* end) {
+    while (p < end && JSONTokener::IsUnquotedTextChar(*p)) {
+        ++p;
+    }
+
+    if (p == end) {
+        token_.append(token_begin_, end - token_begin_);
+        return end;
+    }
+
+    lexer_ = kNoToken;
+    if (token_.empty()) {
+        return EndText(token_begin_, p - token_begin_, p);
+    }
+
+    token_.append(token_begin_, p - token_begin_);
+    return EndText(token_.data(), token_.size(), p);
+}
+
+const char* JSONPushParser::ScanComment(const char* p, const char* end) {
+    switch (lexer_) {
+    case kCommentBegin:
+        if (*p == '*') {
+            lexer_ = kCStyleComment;
+            pending_ = false;
+            return p + 1;
+        }
+
+        if (*p == '/') {
+            lexer_ = kCppStyleComment;
+            return p + 1;
+        }
+        return Fail(kCommentFormatError, p);
+    case kCStyleComment:
+        for (; p < end; ++p) {
+            if (pending_ && *p == '/') {
+                pending_ = false;
+                lexer_ = kNoToken;
+                return p + 1;
+            }
+            pending_ = (*p == '*');
+        }
+        return end;
+    default: {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!nl) {
+            return end;
+        }
+        lexer_ = kNoToken;
+        return nl + 1;
+    }
+    }
+}
+
+const char* JSONPushParser::EndString(const char* s, size_t len, const char* p) {
+    // s is the text after the open quote, including the close quote
+    JSONTokener x(s, static_cast<simcc::int32>(len));
+    Slice str;
+    if (!x.NextString(quote_, false, str)) {
+        return Fail(key_ ? kJSONObjectKeyNotString : kJSONStringNotQuoted, p);
+    }
+
+    if (key_) {
+        if (!handler_->Key(str.data(), str.size())) {
+            return Fail(kTerminatedByHandler, p);
+        }
+        expect_ = kColon;
+    } else {
+        if (!handler_->String(str.data(), str.size())) {
+            return Fail(kTerminatedByHandler, p);
+        }
+        EndValue();
+    }
+
+    return p + 1;
+}
+
+const char* JSONPushParser::EndText(const char* s, size_t len, const char* p) {
+    // Spaces are allowed inside the text, but not at the end of it
+    while (len > 0 && s[len - 1] == ' ') {
+        --len;
+    }
+
+    JSONScalar v;
+    if (!JSONObject::ConvertToScalar(s, len, this, NULL, v)) {
+        return Fail(error(), p);
+    }
+
+    bool ok = false;
+    switch (v.type) {
+    case kJSONNull:
+        ok = handler_->Null();
+        break;
+    case kJSONBoolean:
+        ok = handler_->Bool(v.b);
+        break;
+    case kJSONInteger:
+        ok = handler_->Int64(v.i);
+        break;
+    case kJSONDouble:
+        ok = handler_->Double(v.d);
+        break;
+    default:
+        assert(false);
+        break;
+    }
+
+    if (!ok) {
+        return Fail(kTerminatedByHandler, p);
+    }
+
+    EndValue();
+    return p;
+}
+
+bool JSONPushParser::StartObject() {
+    if (!handler_->StartObject()) {
+        return false;
+    }
+
+    Frame f = { '}', 0 };
+    stack_.push_back(f);
+    expect_ = kObjectKeyOrEnd;
+    return true;
+}
+
+bool JSONPushParser::StartArray(char open) {
+    if (!handler_->StartArray()) {
+        return false;
+    }
+
+    Frame f = { open == '[' ? ']' : ')', 0 };
+    stack_.push_back(f);
+    expect_ = kArrayValueOrEnd;
+    return true;
+}
+
+bool JSONPushParser::EndContainer() {
+    Frame f = stack_.back();
+    stack_.pop_back();
+    bool ok = f.close == '}' ? handler_->EndObject(f.count) : handler_->EndArray(f.count);
+    if (!ok) {
+        return false;
+    }
+
+    if (stack_.empty()) {
+        status_ = kDone;
+    } else {
+        EndValue();
+    }
+    return true;
+}
+
+void JSONPushParser::EndValue() {
+    Frame& f = stack_.back();
+    ++f.count;
+    expect_ = f.close == '}' ? kObjectCommaOrEnd : kArrayCommaOrEnd;
+}
+
+const char* JSONPushParser::Fail(ErrorCode ec, const char* p) {
+    set_error(ec, position_ + (p - chunk_));
+    status_ = kFailed;
+    return NULL;
+}
+
+}
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+
+#include "json_common.h"
+#include "json_parser.h"
+#include "json_sax.h"
+
+#include <vector>
+
+namespace simcc {
+namespace json {
+
+// A resumable SAX-style json parser which is fed with the successive chunks
+// of the json text, e.g. the data read from a socket.
+//
+// Every byte is scanned only once, the events are reported to the
+// JSONSAXHandler as soon as the values are completed. Only a string or an
+// unquoted text which is split by the chunks is kept by the parser until
+// the rest of it arrives, so the memory usage doesn't depend on the size of
+// the whole text. Use a JSONDOMBuilder as the handler to build the document.
+//
+// It accepts the same json text as JSONSAXParser.
+//
+// Usage:
+//    JSONDOMBuilder builder;
+//    JSONPushParser p(&builder);
+//    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+//        if (p.Feed(buf, n) != JSONPushParser::kNeedMoreData) {
+//            break;
+//        }
+//    }
+//    if (p.Finish() == JSONPushParser::kDone) {
+//        ObjectPtr doc = builder.root();
+//    } else {
+//        printf("%s at %d\n", p.strerror(), (int)p.error_location());
+//    }
+class SIMCC_EXPORT JSONPushParser : public JSONParser {
+public:
+    enum Status {
+        kNeedMoreData = 0,
+        kDone,   // The root object or array is completed
+        kFailed, // Use error() to get the error code
+    };
+
+    explicit JSONPushParser(JSONSAXHandler* handler);
+
+    // Parse the next chunk of the json text.
+    // The chunk is not referred after this call.
+    // @return kNeedMoreData if the document is not completed yet.
+    //   kDone if the root object or array is completed, the rest of the
+    //   chunk is not parsed, see position().
+    //   kFailed if there is an error.
+    Status Feed(const char* data, size_t len);
+
+    // All the text has been fed.
+    // @return kDone if the document is completed, or kFailed
+    Status Finish();
+
+    // Parse a new document
+    void Reset();
+
+    Status status() const {
+        return status_;
+    }
+
+    // The number of the bytes which have been parsed
+    size_t position() const {
+        return position_;
+    }
+
+private:
+    // The lexical state, which is kept between the chunks
+    enum Lexer {
+        kNoToken = 0,
+        kString,
+        kText,          // An unquoted text, e.g. a number
+        kCommentBegin,  // After a '/'
+        kCStyleComment,
+        kCppStyleComment,
+    };
+
+    // The expected token
+    enum Expect {
+        kRoot = 0,
+        kObjectKeyOrEnd,
+        kColon,
+        kObjectValue,
+        kObjectCommaOrEnd,
+        kArrayValueOrEnd,
+        kArrayCommaOrEnd,
+    };
+
+    struct Frame {
+        char close;   // '}' for an object, or the close bracket of an array
+        size_t count; // The number of the members or the elements
+    };
+
+    const char* ScanToken(const char* p, const char* end);
+    const char* ScanValue(const char* p);
+    const char* ScanString(const char* p, const char* end);
+    const char* ScanText(const char* p, const char* end);
+    const char* ScanComment(const char* p, const char* end);
+
+    // The token <code>s</code> ends at <code>p</code> in the current chunk
+    const char* EndString(const char* s, size_t len, const char* p);
+    const char* EndText(const char* s, size_t len, const char* p);
+
+    bool StartObject();
+    bool StartArray(char open);
+    bool EndContainer();
+    void EndValue();
+
+    // @return NULL to stop the scanning
+    const char* Fail(ErrorCode ec, const char* p);
+
+private:
+    JSONSAXHandler* handler_;
+    Status status_;
+
+    Lexer lexer_;
+    Expect expect_;
+    std::vector<Frame> stack_;
+
+    // The current token
+    const char* token_begin_;   // The beginning of the token in the current chunk
+    string token_;              // The part of the token in the previous chunks
+    char quote_;
+    bool key_;                  // The string is a key
+    bool pending_;              // The last character is a backslash in a string, or a '*' in a comment
+
+    const char* chunk_;         // The current chunk
+    size_t position_;           // The position of the current chunk in the text
+};
+
+}
+}
@@ -0,0 +1,379 @@
+#include "simcc/inner_pre.h"
+
+#include "json.h"
+#include "json_sax.h"
+#include "json_tokener.h"
+
+namespace simcc {
+namespace json {
+
+simcc::uint32 JSONSAXParser::Parse(const char* source, const simcc::int64 source_len, JSONSAXHandler* handler) {
+    if (source_len == 0 || !source || !handler) {
+        set_error(kParameterWrong);
+        return 0;
+    }
+
+    JSONTokener x(source, source_len);
+    return Parse(&x, handler);
+}
+
+simcc::uint32 JSONSAXParser::Parse(JSONTokener* x, JSONSAXHandler* handler) {
+    set_error(kNoError, static_cast<size_t>(0));
+
+    if (!SkipComment(x)) {
+        return 0;
+    }
+
+    bool ok = false;
+    char c = x->NextClean();
+    if (c == '{') {
+        x->Back();
+        ok = ParseObject(x, handler);
+    } else if (c == '[' || c == '(') {
+        x->Back();
+        ok = ParseArray(x, handler);
+    } else {
+        set_error(kInvalidCharacter, x);
+    }
+
+    if (!ok) {
+        return 0;
+    }
+
+    return x->GetCurrentPosition();
+}
+
+#define H_SAX_EVENT(event) \
+    if (!(event)) { \
+        set_error(kTerminatedByHandler, x->GetCurrentPosition()); \
+        return false; \
+    }
+
+bool JSONSAXParser::SkipComment(JSONTokener* x) {
+    if (!x->SkipComment()) {
+        set_error(kCommentFormatError, x);
+        return false;
+    }
+    return true;
+}
+
+bool JSONSAXParser::ParseValue(JSONTokener* x, JSONSAXHandler* handler) {
+    if (!SkipComment(x)) {
+        return false;
+    }
+
+    char c = x->NextClean();
+    switch (c) {
+    case '"':
+    case '\'': {
+        // No copy is made unless the string has escapes
+        Slice s;
+        if (!x->NextString(c, false, s)) {
+            set_error(kJSONStringNotQuoted, x->GetCurrentPosition());
+            return false;
+        }
+        H_SAX_EVENT(handler->String(s.data(), s.size()));
+        return true;
+    }
+    case '{':
+        x->Back();
+        return ParseObject(x, handler);
+    case '[':
+    case '(':
+        x->Back();
+        return ParseArray(x, handler);
+    default:
+        //Handle unquoted text like: true, false, or null, or it can be a number.
+        break;
+    }
+
+    Slice text = x->NextUnquotedText(c);
+    if (text.empty()) {
+        set_error(kBlankValue, x);
+        return false;
+    }
+
+    JSONScalar v;
+    if (!JSONObject::ConvertToScalar(text.data(), text.size(), this, x, v)) {
+        return false;
+    }
+
+    switch (v.type) {
+    case kJSONNull:
+        H_SAX_EVENT(handler->Null());
+        break;
+    case kJSONBoolean:
+        H_SAX_EVENT(handler->Bool(v.b));
+        break;
+    case kJSONInteger:
+        H_SAX_EVENT(handler->Int64(v.i));
+        break;
+    case kJSONDouble:
+        H_SAX_EVENT(handler->Double(v.d));
+        break;
+    default:
+        assert(false);
+        return false;
+    }
+
+    return true;
+}
+
+bool JSONSAXParser::ParseObject(JSONTokener* x, JSONSAXHandler* handler) {
+    if (!SkipComment(x)) {
+        return false;
+    }
+
+    char c = x->NextClean();
+    if (c != '{') {
+        set_error(kJSONObjectNotBeginWithBraces, x);
+        return false;
+    }
+
+    H_SAX_EVENT(handler->StartObject());
+
+    size_t member_count = 0;
+    Slice key;
+    for (;;) {
+        if (!SkipComment(x)) {
+            return false;
+        }
+
+        c = x->NextClean();
+        switch (c) {
+        case 0:
+            set_error(kJSONObjectNotEndWithBraces, x);
+            return false;
+        case '}':
+            H_SAX_EVENT(handler->EndObject(member_count));
+            return true;
+        case '"':   // a key must be a string
+            if (!x->NextString('"', false, key)) {
+                set_error(kJSONObjectKeyNotString, x);
+                return false;
+            }
+            break;
+        default:
+            set_error(kInvalidCharacter, x);
+            return false;
+        }
+
+        H_SAX_EVENT(handler->Key(key.data(), key.size()));
+
+        // The key is followed by ':'
+        if (!SkipComment(x)) {
+            return false;
+        }
+
+        c = x->NextClean();
+        if (c != ':') {
+            set_error(kKeyValueSeperatorError, x);
+            return false;
+        }
+
+        if (!ParseValue(x, handler)) {
+            return false;
+        }
+
+        ++member_count;
+
+        if (!SkipComment(x)) {
+            return false;
+        }
+
+        c = x->NextClean();
+
+        // pairs are separated by ','
+        switch (c) {
+        case ',':
+            if (!SkipComment(x)) {
+                return false;
+            }
+
+            c = x->NextClean();
+            if (c == '}') {
+                H_SAX_EVENT(handler->EndObject(member_count));
+                return true;
+            }
+
+            x->Back();
+            break;
+        case '}':
+            H_SAX_EVENT(handler->EndObject(member_count));
+            return true;
+        default:
+            set_error(kInvalidCharacter, x);
+            return false;
+        }
+    }
+}
+
+bool JSONSAXParser::ParseArray(JSONTokener* x, JSONSAXHandler* handler) {
+    if (!SkipComment(x)) {
+        return false;
+    }
+
+    char c = x->NextClean();
+    char q = 0;
+    if (c == '[') {
+        q = ']';
+    } else if (c == '(') {
+        q = ')';
+    } else {
+        set_error(kJSONArrayNotBeginWithBrackets, x);
+        return false;
+    }
+
+    H_SAX_EVENT(handler->StartArray());
+
+    if (!SkipComment(x)) {
+        return false;
+    }
+
+    size_t element_count = 0;
+    c = x->NextClean();
+    if (c == q) {
+        H_SAX_EVENT(handler->EndArray(element_count));
+        return true;
+    }
+
+    x->Back();
+    for (;;) {
+        if (!SkipComment(x)) {
+            return false;
+        }
+
+        c = x->NextClean();
+        x->Back();
+        if (c == ',') {
+            H_SAX_EVENT(handler->Null());
+        } else if (!ParseValue(x, handler)) {
+            return false;
+        }
+
+        ++element_count;
+
+        if (!SkipComment(x)) {
+            return false;
+        }
+
+        c = x->NextClean();
+
+        switch (c) {
+        case ';':
+        case ',':
+            if (!SkipComment(x)) {
+                return false;
+            }
+
+            c = x->NextClean();
+            if (c == q) {
+                H_SAX_EVENT(handler->EndArray(element_count));
+                return true;
+            }
+
+            x->Back();
+            break;
+        case ']':
+        case ')':
+            if (q != c) {
+                set_error(kJSONArrayNotEndWithBrackets, x);
+                return false;
+            }
+            H_SAX_EVENT(handler->EndArray(element_count));
+            return true;
+        default:
+            set_error(kJSONArrayNotEndWithBrackets, x);
+            return false;
+        }
+    }
+}
+
+#undef H_SAX_EVENT
+
+JSONDOMBuilder::JSONDOMBuilder() {
+}
+
+void JSONDOMBuilder::Reset() {
+    root_ = NULL;
+    stack_.clear();
+    key_.clear();
+}
+
+bool JSONDOMBuilder::Add(Object* o) {
+    if (stack_.empty()) {
+        if (root_) {
+            // Only one document is built
+            Object::Destroy(o);
+            return false;
+        }
+        root_ = o;
+        return true;
+    }
+
+    Object* parent = stack_.back();
+    if (parent->type() == kJSONObject) {
+        static_cast<JSONObject*>(parent)->Put(key_, o);
+    } else {
+        static_cast<JSONArray*>(parent)->Put(o);
+    }
+    return true;
+}
+
+bool JSONDOMBuilder::Null() {
+    return Add(new JSONNull);
+}
+
+bool JSONDOMBuilder::Bool(bool b) {
+    return Add(new JSONBoolean(b));
+}
+
+bool JSONDOMBuilder::Int64(simcc::int64 i) {
+    return Add(new JSONInteger(i));
+}
+
+bool JSONDOMBuilder::Double(simcc::float64 d) {
+    return Add(new JSONDouble(d));
+}
+
+bool JSONDOMBuilder::String(const char* s, size_t len) {
+    JSONString* js = new JSONString;
+    js->value().assign(s, len);
+    return Add(js);
+}
+
+bool JSONDOMBuilder::StartObject() {
+    JSONObject* o = new JSONObject;
+    if (!Add(o)) {
+        return false;
+    }
+    stack_.push_back(o);
+    return true;
+}
+
+bool JSONDOMBuilder::Key(const char* s, size_t len) {
+    key_.assign(s, len);
+    return true;
+}
+
+bool JSONDOMBuilder::EndObject(size_t /*member_count*/) {
+    stack_.pop_back();
+    return true;
+}
+
+bool JSONDOMBuilder::StartArray() {
+    JSONArray* a = new JSONArray;
+    if (!Add(a)) {
+        return false;
+    }
+    stack_.push_back(a);
+    return true;
+}
+
+bool JSONDOMBuilder::EndArray(size_t /*element_count*/) {
+    stack_.pop_back();
+    return true;
+}
+
+}
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+
+#include "json_common.h"
+#include "json_parser.h"
+
+#include <vector>
+
+namespace simcc {
+namespace json {
+
+// The handler of the events which are generated by JSONSAXParser.
+// The default implementation of every event does nothing but continues parsing,
+// so you only need to override the events you are interested in.
+//
+// Every event returns true to continue parsing or false to stop it.
+class SIMCC_EXPORT JSONSAXHandler {
+public:
+    virtual ~JSONSAXHandler() {}
+
+    virtual bool Null() {
+        return true;
+    }
+
+    virtual bool Bool(bool /*b*/) {
+        return true;
+    }
+
+    virtual bool Int64(simcc::int64 /*i*/) {
+        return true;
+    }
+
+    virtual bool Double(simcc::float64 /*d*/) {
+        return true;
+    }
+
+    // @note The string is only valid during this call
+    virtual bool String(const char* /*s*/, size_t /*len*/) {
+        return true;
+    }
+
+    virtual bool StartObject() {
+        return true;
+    }
+
+    // @note The key is only valid during this call
+    virtual bool Key(const char* /*s*/, size_t /*len*/) {
+        return true;
+    }
+
+    // @param member_count the number of key/value pairs of this object
+    virtual bool EndObject(size_t /*member_count*/) {
+        return true;
+    }
+
+    virtual bool StartArray() {
+        return true;
+    }
+
+    // @param element_count the number of elements of this array
+    virtual bool EndArray(size_t /*element_count*/) {
+        return true;
+    }
+};
+
+// A JSONSAXHandler which builds the json objects from the events,
+// e.g. to build a document with JSONPushParser.
+//
+// Usage:
+//    JSONDOMBuilder builder;
+//    JSONPushParser p(&builder);
+//    ... p.Feed(chunk, chunk_len) ...
+//    ObjectPtr doc = builder.root();
+class SIMCC_EXPORT JSONDOMBuilder : public JSONSAXHandler {
+public:
+    JSONDOMBuilder();
+
+    // The built JSONObject or JSONArray.
+    // It is not NULL once the first object or array is started.
+    const ObjectPtr& root() const {
+        return root_;
+    }
+
+    // @return true if the root object or array is ended
+    bool done() const {
+        return root_ && stack_.empty();
+    }
+
+    // Clear the built document to build a new one
+    void Reset();
+
+    virtual bool Null();
+    virtual bool Bool(bool b);
+    virtual bool Int64(simcc::int64 i);
+    virtual bool Double(simcc::float64 d);
+    virtual bool String(const char* s, size_t len);
+    virtual bool StartObject();
+    virtual bool Key(const char* s, size_t len);
+    virtual bool EndObject(size_t member_count);
+    virtual bool StartArray();
+    virtual bool EndArray(size_t element_count);
+
+private:
+    // Add a value to the current object or array
+    bool Add(Object* o);
+
+private:
+    ObjectPtr root_;
+    std::vector<Object*> stack_; // The objects and arrays being built
+    string key_;
+};
+
+// A SAX-style json parser. It walks through the json text and reports
+// every value to a JSONSAXHandler without building any json object,
+// so the memory usage is only proportional to the depth of the document.
+//
+// It accepts the same json text as JSONParser::Load, e.g. comments,
+// single quoted strings and blank array elements.
+//
+// Usage:
+//    class MyHandler : public JSONSAXHandler {
+//        virtual bool Key(const char* s, size_t len) { ... }
+//        virtual bool String(const char* s, size_t len) { ... }
+//    };
+//    MyHandler h;
+//    JSONSAXParser p;
+//    if (!p.Parse(text, text_len, &h)) {
+//        printf("%s\n", p.strerror());
+//    }
+class SIMCC_EXPORT JSONSAXParser : public JSONParser {
+public:
+    // Parse a JSONArray or JSONObject from the source JSON text
+    // @param source A string of JSON format text
+    // @param source_len, the length of the source string.
+    //   if you use the default value(-1), we will use strlen(source) to
+    //   calculate the length.
+    // @return number of characters parsed. Return 0 if failed to parse
+    //   or the handler stopped the parsing (error() == kTerminatedByHandler).
+    simcc::uint32 Parse(const char* source, const simcc::int64 source_len, JSONSAXHandler* handler);
+
+    simcc::uint32 Parse(JSONTokener* x, JSONSAXHandler* handler);
+
+private:
+    bool ParseValue(JSONTokener* x, JSONSAXHandler* handler);
+    bool ParseObject(JSONTokener* x, JSONSAXHandler* handler);
+    bool ParseArray(JSONTokener* x, JSONSAXHandler* handler);
+    bool SkipComment(JSONTokener* x);
+};
+
+}
+}
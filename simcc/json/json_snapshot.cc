@@ -0,0 +1,368 @@
+#include "simcc/inner_pre.h"
+
+#include "json.h"
+#include "json_snapshot.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace simcc {
+namespace json {
+
+namespace {
+const char kMagic[4] = { 'S', 'J', 'S', 'N' };
+const simcc::uint16 kVersion = 1;
+const simcc::uint16 kByteOrderMark = 0x0102;
+const size_t kHeaderSize = 16;
+
+// The data may be unaligned
+template<typename T>
+T ReadAt(const char* p) {
+    T v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+void WriteAt(simcc::DataStream& ds, size_t pos, simcc::uint32 v) {
+    memcpy(static_cast<char*>(ds.GetCache()) + pos, &v, sizeof(v));
+}
+
+// The payload of a string, which is followed by a '\0'
+void WriteString(const Slice& s, simcc::DataStream& ds) {
+    ds << (simcc::uint32)s.size();
+    ds.Write(s.data(), s.size());
+    ds << (simcc::uint8)0;
+}
+
+typedef std::pair<Slice, const Object*> Member;
+
+bool MemberLess(const Member& x, const Member& y) {
+    return x.first.compare(y.first) < 0;
+}
+}
+
+JSONSnapshotValue::JSONSnapshotValue(const char* data, size_t size, simcc::uint32 offset)
+    : data_(data), size_(size), offset_(offset) {
+}
+
+const char* JSONSnapshotValue::Payload(JSONType t, size_t len) const {
+    if (!data_ || offset_ + 1 + len > size_ || static_cast<simcc::uint8>(data_[offset_]) != t) {
+        return NULL;
+    }
+    return data_ + offset_ + 1;
+}
+
+JSONSnapshotValue JSONSnapshotValue::At(simcc::uint32 offset) const {
+    // A child is always after its parent, so a corrupted snapshot can't make a loop
+    if (offset <= offset_ || offset >= size_) {
+        return JSONSnapshotValue();
+    }
+    return JSONSnapshotValue(data_, size_, offset);
+}
+
+JSONType JSONSnapshotValue::type() const {
+    if (!data_) {
+        return kUnknownType;
+    }
+
+    simcc::uint8 t = static_cast<simcc::uint8>(data_[offset_]);
+    if (t < kJSONObject || t > kJSONNull) {
+        return kUnknownType;
+    }
+    return static_cast<JSONType>(t);
+}
+
+size_t JSONSnapshotValue::size() const {
+    JSONType t = type();
+    if (t != kJSONObject && t != kJSONArray) {
+        return 0;
+    }
+
+    const char* p = Payload(t, 4);
+    if (!p) {
+        return 0;
+    }
+
+    // Check the whole table once, then the entries are accessed without checking
+    size_t count = ReadAt<simcc::uint32>(p);
+    size_t entry_size = (t == kJSONObject ? 8 : 4);
+    if (count > (size_ - offset_ - 5) / entry_size) {
+        return 0;
+    }
+    return count;
+}
+
+JSONSnapshotValue JSONSnapshotValue::KeyAt(size_t index) const {
+    if (type() != kJSONObject || index >= size()) {
+        return JSONSnapshotValue();
+    }
+
+    const char* table = data_ + offset_ + 5;
+    return At(ReadAt<simcc::uint32>(table + index * 8));
+}
+
+Slice JSONSnapshotValue::key(size_t index) const {
+    return KeyAt(index).GetString();
+}
+
+JSONSnapshotValue JSONSnapshotValue::Get(size_t index) const {
+    if (index >= size()) {
+        return JSONSnapshotValue();
+    }
+
+    const char* table = data_ + offset_ + 5;
+    if (type() == kJSONObject) {
+        return At(ReadAt<simcc::uint32>(table + index * 8 + 4));
+    }
+    return At(ReadAt<simcc::uint32>(table + index * 4));
+}
+
+JSONSnapshotValue JSONSnapshotValue::Get(const Slice& k) const {
+    if (type() != kJSONObject) {
+        return JSONSnapshotValue();
+    }
+
+    // A binary search in the sorted keys
+    size_t lo = 0;
+    size_t hi = size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int r = key(mid).compare(k);
+        if (r == 0) {
+            return Get(mid);
+        } else if (r < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return JSONSnapshotValue();
+}
+
+bool JSONSnapshotValue::GetBool(bool default_value) const {
+    const char* p = Payload(kJSONBoolean, 1);
+    return p ? *p != 0 : default_value;
+}
+
+simcc::int64 JSONSnapshotValue::GetInteger(simcc::int64 default_value) const {
+    const char* p = Payload(kJSONInteger, sizeof(simcc::int64));
+    return p ? ReadAt<simcc::int64>(p) : default_value;
+}
+
+simcc::float64 JSONSnapshotValue::GetDouble(simcc::float64 default_value) const {
+    const char* p = Payload(kJSONDouble, sizeof(simcc::float64));
+    return p ? ReadAt<simcc::float64>(p) : default_value;
+}
+
+bool JSONSnapshotValue::ReadString(Slice& s) const {
+    const char* p = Payload(kJSONString, 4);
+    if (!p) {
+        return false;
+    }
+
+    size_t len = ReadAt<simcc::uint32>(p);
+    if (len >= size_ - offset_ - 5) {
+        return false; // Truncated, the '\0' is not there
+    }
+
+    s = Slice(p + 4, len);
+    return true;
+}
+
+Slice JSONSnapshotValue::GetString(const Slice& default_value) const {
+    Slice s;
+    return ReadString(s) ? s : default_value;
+}
+
+simcc::float64 JSONSnapshotValue::GetDecimal(simcc::float64 default_value) const {
+    if (type() == kJSONInteger) {
+        return static_cast<simcc::float64>(GetInteger());
+    }
+    return GetDouble(default_value);
+}
+
+ObjectPtr JSONSnapshotValue::Materialize() const {
+    switch (type()) {
+    case kJSONObject: {
+        JSONObject* jo = new JSONObject;
+        ObjectPtr o(jo);
+        for (size_t i = 0, n = size(); i < n; ++i) {
+            Slice k;
+            ObjectPtr v = Get(i).Materialize();
+            if (!v || !KeyAt(i).ReadString(k)) {
+                return ObjectPtr();
+            }
+            jo->Put(k.ToString(), v);
+        }
+        return o;
+    }
+    case kJSONArray: {
+        JSONArray* ja = new JSONArray;
+        ObjectPtr o(ja);
+        for (size_t i = 0, n = size(); i < n; ++i) {
+            ObjectPtr v = Get(i).Materialize();
+            if (!v) {
+                return ObjectPtr();
+            }
+            ja->Put(v);
+        }
+        return o;
+    }
+    case kJSONString: {
+        Slice s;
+        if (ReadString(s)) {
+            return ObjectPtr(new JSONString(s.ToString()));
+        }
+        break;
+    }
+    case kJSONInteger:
+        if (Payload(kJSONInteger, sizeof(simcc::int64))) {
+            return ObjectPtr(new JSONInteger(GetInteger()));
+        }
+        break;
+    case kJSONDouble:
+        if (Payload(kJSONDouble, sizeof(simcc::float64))) {
+            return ObjectPtr(new JSONDouble(GetDouble()));
+        }
+        break;
+    case kJSONBoolean:
+        if (Payload(kJSONBoolean, 1)) {
+            return ObjectPtr(new JSONBoolean(GetBool()));
+        }
+        break;
+    case kJSONNull:
+        return ObjectPtr(new JSONNull);
+    default:
+        break;
+    }
+    return ObjectPtr();
+}
+
+bool JSONSnapshot::Write(const Object& root, simcc::DataStream& ds) {
+    size_t base = ds.size();
+    ds.Write(kMagic, sizeof(kMagic));
+    ds << kVersion << kByteOrderMark << (simcc::uint32)0 << (simcc::uint32)kHeaderSize;
+    WriteValue(&root, ds, base);
+
+    size_t size = ds.size() - base;
+    if (size > 0xFFFFFFFFu || ds.IsWriteBad()) {
+        return false;
+    }
+
+    WriteAt(ds, base + 8, static_cast<simcc::uint32>(size));
+    return true;
+}
+
+void JSONSnapshot::WriteValue(const Object* o, simcc::DataStream& ds, size_t base) {
+    if (o->IsTypeOf(kJSONStringView)) {
+        ds << (simcc::uint8)kJSONString;
+        WriteString(static_cast<const JSONStringView*>(o)->slice(), ds);
+        return;
+    }
+
+    ds << (simcc::uint8)o->type();
+    switch (o->type()) {
+    case kJSONObject: {
+        const JSONObject* jo = static_cast<const JSONObject*>(o);
+        std::vector<Member> members;
+        members.reserve(jo->size());
+        for (auto it = jo->begin(), ite = jo->end(); it != ite; ++it) {
+            members.push_back(Member(Slice(static_cast<const string&>(it->first)), it->second.get()));
+        }
+        std::sort(members.begin(), members.end(), &MemberLess);
+
+        // Reserve the table, which is filled when the members are written
+        size_t table = ds.size();
+        ds << (simcc::uint32)members.size();
+        for (size_t i = 0; i < members.size(); ++i) {
+            ds << (simcc::uint32)0 << (simcc::uint32)0;
+        }
+
+        for (size_t i = 0; i < members.size(); ++i) {
+            WriteAt(ds, table + 4 + i * 8, static_cast<simcc::uint32>(ds.size() - base));
+            ds << (simcc::uint8)kJSONString << (simcc::uint32)members[i].first.size();
+            ds.Write(members[i].first.data(), members[i].first.size());
+            ds << (simcc::uint8)0;
+
+            WriteAt(ds, table + 8 + i * 8, static_cast<simcc::uint32>(ds.size() - base));
+            WriteValue(members[i].second, ds, base);
+        }
+        break;
+    }
+    case kJSONArray: {
+        const JSONArray* ja = static_cast<const JSONArray*>(o);
+        size_t table = ds.size();
+        ds << (simcc::uint32)ja->size();
+        for (size_t i = 0; i < ja->size(); ++i) {
+            ds << (simcc::uint32)0;
+        }
+
+        size_t i = 0;
+        for (auto it = ja->begin(), ite = ja->end(); it != ite; ++it, ++i) {
+            WriteAt(ds, table + 4 + i * 4, static_cast<simcc::uint32>(ds.size() - base));
+            WriteValue(it->get(), ds, base);
+        }
+        break;
+    }
+    case kJSONString:
+        WriteString(Slice(static_cast<const JSONString*>(o)->value()), ds);
+        break;
+    case kJSONInteger:
+        ds << static_cast<const JSONInteger*>(o)->value();
+        break;
+    case kJSONDouble:
+        ds << static_cast<const JSONDouble*>(o)->value();
+        break;
+    case kJSONBoolean:
+        ds << (simcc::uint8)(static_cast<const JSONBoolean*>(o)->value() ? 1 : 0);
+        break;
+    default:
+        break;
+    }
+}
+
+bool JSONSnapshot::Open(const char* data, size_t len) {
+    // Release the file mapped by an earlier OpenFile
+    Close();
+    return Attach(data, len);
+}
+
+bool JSONSnapshot::Attach(const char* data, size_t len) {
+    if (!data || len < kHeaderSize + 1 || memcmp(data, kMagic, sizeof(kMagic)) != 0
+            || ReadAt<simcc::uint16>(data + 4) != kVersion
+            || ReadAt<simcc::uint16>(data + 6) != kByteOrderMark) {
+        return false;
+    }
+
+    simcc::uint32 size = ReadAt<simcc::uint32>(data + 8);
+    simcc::uint32 root = ReadAt<simcc::uint32>(data + 12);
+    if (size > len || root < kHeaderSize || root >= size) {
+        return false;
+    }
+
+    root_ = JSONSnapshotValue(data, size, root);
+    return true;
+}
+
+bool JSONSnapshot::OpenFile(const string& path) {
+    Close();
+
+    // Only the accessed pages are read
+    if (!file_.Open(path, simcc::MappedFile::kRandom)) {
+        return false;
+    }
+
+    if (!Attach(file_.data(), file_.size())) {
+        file_.Close();
+        return false;
+    }
+    return true;
+}
+
+void JSONSnapshot::Close() {
+    root_ = JSONSnapshotValue();
+    file_.Close();
+}
+
+}
+}
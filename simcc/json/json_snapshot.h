@@ -0,0 +1,173 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+#include "simcc/slice.h"
+#include "simcc/mapped_file.h"
+
+#include "json_common.h"
+
+namespace simcc {
+namespace json {
+
+// A value of a JSONSnapshot. It refers to the binary data of the snapshot,
+// nothing is decoded until it is accessed and nothing is cached.
+//
+// A JSONSnapshotValue is only valid during the lifetime of the snapshot data.
+class SIMCC_EXPORT JSONSnapshotValue {
+public:
+    // An invalid value
+    JSONSnapshotValue() : data_(NULL), size_(0), offset_(0) {}
+
+    // @return false if the value is not found or the data is corrupted
+    bool valid() const {
+        return data_ != NULL;
+    }
+
+    JSONType type() const;
+
+    // Get the value associated with a key of an object.
+    // It is a binary search in the sorted key table of the object.
+    // @return An invalid value if this is not an object or the key is not found
+    JSONSnapshotValue Get(const Slice& key) const;
+
+    // Get the element at an index of an array, or the value of the member
+    // at an index of an object (in the order of the keys).
+    // @return An invalid value if the index is out of range
+    JSONSnapshotValue Get(size_t index) const;
+
+    // The key of the member at an index of an object, the keys are sorted.
+    // @return An empty slice if this is not an object or the index is out of range
+    Slice key(size_t index) const;
+
+    // The number of the members of an object or the elements of an array,
+    // 0 for the other values.
+    size_t size() const;
+
+    // Gets the scalar value.
+    // @return default_value, if the value is invalid or of the other type
+    bool GetBool(bool default_value = false) const;
+    simcc::int64 GetInteger(simcc::int64 default_value = 0) const;
+    simcc::float64 GetDouble(simcc::float64 default_value = 0.0) const;
+
+    // The string refers to the snapshot data, and it is followed by a '\0'
+    Slice GetString(const Slice& default_value = Slice()) const;
+
+    // Get a decimal number whether it is a double or an integer
+    simcc::float64 GetDecimal(simcc::float64 default_value = 0.0) const;
+
+    // Build the json objects of this value and all its children,
+    // e.g. a JSONObject for an object.
+    // @return NULL if the value is invalid or the data is corrupted
+    ObjectPtr Materialize() const;
+
+private:
+    friend class JSONSnapshot;
+    JSONSnapshotValue(const char* data, size_t size, simcc::uint32 offset);
+
+    // The type and the payload of the value.
+    // @param len the length of the payload which is required
+    // @return NULL if the value is not of the type or the data is corrupted
+    const char* Payload(JSONType t, size_t len) const;
+
+    // The value at an offset of the snapshot, which must be after this one
+    JSONSnapshotValue At(simcc::uint32 offset) const;
+
+    // The key string of the member at an index of an object
+    JSONSnapshotValue KeyAt(size_t index) const;
+
+    // @return false if this is not a string or the string is truncated
+    bool ReadString(Slice& s) const;
+
+private:
+    const char* data_; // The whole snapshot
+    size_t size_;
+    simcc::uint32 offset_;
+};
+
+// A binary json format which can be read in place, e.g. from a memory
+// mapped file or a received buffer, without building the json objects.
+//
+// The members of an object are kept in a table sorted by the keys, and the
+// elements of an array are kept in a table of their offsets. So a value is
+// found by a binary search in every object on the path, and the data is
+// only touched where it is read.
+//
+// The format is (the integers are in the byte order of the writer):
+//    header   : "SJSN" uint16(version) uint16(0x0102) uint32(size) uint32(root)
+//    null     : uint8(kJSONNull)
+//    boolean  : uint8(kJSONBoolean) uint8(value)
+//    integer  : uint8(kJSONInteger) int64
+//    double   : uint8(kJSONDouble) float64
+//    string   : uint8(kJSONString) uint32(length) bytes '\0'
+//    array    : uint8(kJSONArray) uint32(count) uint32(element offset) * count
+//    object   : uint8(kJSONObject) uint32(count) (uint32(key offset) uint32(value offset)) * count
+// All the offsets are from the beginning of the snapshot, the keys are
+// strings and a child is always after its parent.
+//
+// Usage:
+//    // Build the snapshot once
+//    simcc::DataStream ds;
+//    JSONSnapshot::Write(jo, ds);
+//    ds.WriteFile("/data/conf.snapshot");
+//
+//    // Read it in every process
+//    JSONSnapshot s;
+//    if (s.OpenFile("/data/conf.snapshot")) {
+//        int64 port = s.Get("server").Get("port").GetInteger();
+//    }
+//
+// @note Only the header is checked when it is opened, every access checks
+//   the bounds of the data, so a corrupted snapshot gives the invalid values
+//   instead of crashing. A snapshot written by a machine of the other byte
+//   order is refused. A snapshot and its values are thread safe since
+//   nothing is changed after it is opened.
+class SIMCC_EXPORT JSONSnapshot {
+public:
+    JSONSnapshot() {}
+
+    // Append the snapshot of a json object tree to a data stream
+    // @return false if the snapshot is bigger than 4GB
+    static bool Write(const Object& root, simcc::DataStream& ds);
+
+    // Open a snapshot in memory, the data is not copied.
+    // The snapshot opened before, including a mapped file, is closed.
+    // @note The data MUST outlive the snapshot and its values
+    // @return false if it is not a snapshot or it is truncated
+    bool Open(const char* data, size_t len);
+
+    // Map a snapshot file into memory
+    bool OpenFile(const string& path);
+
+    // Release the data, all the values MUST NOT be used any more.
+    void Close();
+
+    // The root object or array
+    JSONSnapshotValue root() const {
+        return root_;
+    }
+
+    JSONSnapshotValue Get(const Slice& key) const {
+        return root_.Get(key);
+    }
+
+    JSONSnapshotValue Get(size_t index) const {
+        return root_.Get(index);
+    }
+
+private:
+    static void WriteValue(const Object* o, simcc::DataStream& ds, size_t base);
+
+    // Set the root to the snapshot in data, which is not closed before
+    bool Attach(const char* data, size_t len);
+
+private:
+    JSONSnapshotValue root_;
+    simcc::MappedFile file_;
+
+    // Disallow copy
+    JSONSnapshot(const JSONSnapshot&);
+    JSONSnapshot& operator=(const JSONSnapshot&);
+};
+
+}
+}
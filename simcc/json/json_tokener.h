@@ -3,8 +3,13 @@
 
 #pragma once
 #include "simcc/tokener.h"
+#include "simcc/simd_scan.h"
 #include "json.h"
 
+#ifdef H_JSON_INTERNED_KEY
+#include <unordered_map>
+#endif
+
 namespace simcc {
 namespace json {
 
@@ -42,11 +47,42 @@ public:
 
     bool NextString(char quote, bool parse_protobuf, string& rs);
 
+    // The same as NextString, but no copy is made. The slice refers to
+    // the source text directly if there is no escape in the string,
+    // otherwise it refers to the internal buffer which is only valid
+    // until the next call.
+    bool NextString(char quote, bool parse_protobuf, Slice& rs);
+
+    // @return true if <code>s</code> refers to the source text
+    bool IsInSource(const Slice& s) const {
+        return s.data() >= data() && s.data() <= data() + size();
+    }
+
     // Get the next value. The value can be a Boolean, Double, Integer,
     // JSONArray, JSONObject, Long, or string, or the JSONObject.NULL object.
     // @return An object. or NULL if something wrong
     Object* NextValue(JSONParser* parser);
 
+    // Get the unquoted text which begins with the character <code>c</code>
+    // we have just read. This could be the values true, false, or null,
+    // or it can be a number.
+    // @return the text or an empty slice if there is no value
+    Slice NextUnquotedText(char c);
+
+    // @return true if <code>c</code> can be a character of an unquoted text
+    static bool IsUnquotedTextChar(char c);
+
+    // Skip the next value without building it. Only the brackets and the
+    // quotes are matched, the scalars are not converted and the escapes
+    // are not decoded, so it is much cheaper than NextValue.
+    // @return false if the brackets don't match or a string is not terminated
+    bool SkipValue();
+
+    // Skip the characters up to the next close quote character, the quote
+    // character <code>quote</code> has been read.
+    // @return false if the string is not terminated
+    bool SkipString(char quote);
+
     // @brief skip comment strings
     //   Skip c-style or cpp-style comment
     // @note when return false, we don't skip any character
@@ -70,6 +106,33 @@ public:
 
     static void EncodeUnicodeNumber(simcc::uint32 codepoint, char encbuf[/*12*/], simcc::uint32& encbuf_len);
 
+    // The memory pool where the parsed json objects are allocated from.
+    // NULL means allocating from the heap.
+    simcc::qh::Pool* pool() const {
+        return pool_;
+    }
+
+    void set_pool(simcc::qh::Pool* pool) {
+        pool_ = pool;
+    }
+
+    // In the in-situ mode, the strings without any escape are parsed as
+    // JSONStringView objects which refer to the source text instead of
+    // copying it, so the source text MUST outlive the parsed document.
+    bool in_situ() const {
+        return in_situ_;
+    }
+
+    void set_in_situ(bool in_situ) {
+        in_situ_ = in_situ;
+    }
+
+#ifdef H_JSON_INTERNED_KEY
+    // Intern an object key. The keys seen in this parsing are cached,
+    // so the global table is only looked up once for every distinct key.
+    JSONKey InternKey(const Slice& s);
+#endif
+
 private:
     // Convert an unicode 4 bytes escape string sequence to an unicode number
     bool DecodeUnicode4BytesSequence(simcc::uint32& unicode);
@@ -77,24 +140,45 @@ private:
 
 private:
     enum { kDefaultBufferSize = 512 };
-    simcc::DataStream buf_; // The data cache buffer to improve performance
+    simcc::DataStream buf_; // The data cache buffer of the strings with escapes
+    simcc::qh::Pool* pool_;
+    bool in_situ_;
+
+#ifdef H_JSON_INTERNED_KEY
+    std::unordered_map<Slice, JSONKey, JSONKey::TextHasher> keys_;
+#endif
 };
 
 
 inline JSONTokener::JSONTokener(const string& s)
     : Tokener(s)
-    , buf_(kDefaultBufferSize) {
+    , pool_(NULL)
+    , in_situ_(false) {
 }
 
 inline JSONTokener::JSONTokener(const char* ps, const simcc::int32 len)
     : Tokener(ps, len)
-    , buf_(kDefaultBufferSize) {
+    , pool_(NULL)
+    , in_situ_(false) {
 }
 
 inline JSONTokener::~JSONTokener() {
 }
 
-inline bool JSONTokener::NextString(char quote, bool parse_protobuf, string& rs) {
+#ifdef H_JSON_INTERNED_KEY
+inline JSONKey JSONTokener::InternKey(const Slice& s) {
+    auto it = keys_.find(s);
+    if (it != keys_.end()) {
+        return it->second;
+    }
+
+    JSONKey key(s.data(), s.size());
+    keys_.insert(std::make_pair(Slice(key.data(), key.size()), key));
+    return key;
+}
+#endif
+
+inline bool JSONTokener::NextString(char quote, bool parse_protobuf, Slice& rs) {
     buf_.Reset();
 
 #define Z16 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
@@ -106,8 +190,32 @@ inline bool JSONTokener::NextString(char quote, bool parse_protobuf, string& rs)
         Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16
     };
 #undef Z16
+    const char* end = data() + size();
     char c = 0;
     for (;;) {
+        // Skip the plain characters in bulk, only the quote, backslash and
+        // control characters need to be handled one by one below.
+        const char* p = GetCurrent();
+        if (p < end) {
+            const char* e = SIMDScan::FindQuoteOrEscape(p, end, quote);
+            if (e < end && *e == quote && buf_.size() == 0) {
+                // The most common case : a string without any escape
+                rs = Slice(p, e - p);
+                SetCurrent(e + 1);
+                return true;
+            }
+
+            // The buffer is only allocated when a string has escapes
+            if (!buf_.capacity()) {
+                buf_.Reserve(kDefaultBufferSize);
+            }
+
+            if (e != p) {
+                buf_.Write(p, e - p);
+                SetCurrent(e);
+            }
+        }
+
         c = Next();
 
         switch (c) {
@@ -192,7 +300,7 @@ inline bool JSONTokener::NextString(char quote, bool parse_protobuf, string& rs)
         default:
 
             if (c == quote) {
-                rs.assign(buf_.data(), buf_.size());
+                rs = Slice(buf_.data(), buf_.size());
                 return true;
             }
 
@@ -202,6 +310,16 @@ inline bool JSONTokener::NextString(char quote, bool parse_protobuf, string& rs)
     } // end of for ( ;; )
 }
 
+inline bool JSONTokener::NextString(char quote, bool parse_protobuf, string& rs) {
+    Slice s;
+    if (!NextString(quote, parse_protobuf, s)) {
+        return false;
+    }
+
+    rs.assign(s.data(), s.size());
+    return true;
+}
+
 inline bool JSONTokener::NextString(char quote, string& rs) {
     return NextString(quote, false, rs);
 }
@@ -217,23 +335,38 @@ inline Object* JSONTokener::NextValue(JSONParser* parser) {
     switch (c) {
     case '"':
     case '\'': {
-        JSONString* jstring = new JSONString();
-        if (!NextString(c, jstring->value())) {
-            delete jstring;
-            jstring = NULL;
+        Slice s;
+        if (!NextString(c, false, s)) {
             parser->set_error(JSONParser::kJSONStringNotQuoted, this->GetCurrentPosition());
+            return NULL;
+        }
+
+        Object* jstring = NULL;
+        if (in_situ_ && IsInSource(s)) {
+            jstring = Object::New<JSONStringView>(pool_, s);
+        } else {
+            jstring = Object::New<JSONString>(pool_, string(s.data(), s.size()));
+        }
+
+        if (!jstring) {
+            parser->set_error(JSONParser::kOutOfMemory, this->GetCurrentPosition());
+            return NULL;
         }
         return jstring;
     }
     case '{':
         Back();
         {
-            JSONObject* jobj = new JSONObject();
-            if (jobj->Parse(this) > 0 && jobj->error() == JSONParser::kNoError) {
+            JSONObject* jobj = Object::New<JSONObject>(pool_);
+            if (!jobj) {
+                parser->set_error(JSONParser::kOutOfMemory, this->GetCurrentPosition());
+                return NULL;
+            }
+
+            if (jobj->Parse(this, parser) > 0 && parser->ok()) {
                 return jobj;
             } else {
-                parser->set_error(jobj->error(), this->GetCurrentPosition());
-                delete jobj;
+                JSONParser::Abandon(jobj, pool_);
                 return NULL;
             }
         }
@@ -241,12 +374,16 @@ inline Object* JSONTokener::NextValue(JSONParser* parser) {
     case '(':
         Back();
         {
-            JSONArray* jarray = new JSONArray();
-            if (jarray->Parse(this) > 0 && jarray->error() == JSONParser::kNoError) {
+            JSONArray* jarray = Object::New<JSONArray>(pool_);
+            if (!jarray) {
+                parser->set_error(JSONParser::kOutOfMemory, this->GetCurrentPosition());
+                return NULL;
+            }
+
+            if (jarray->Parse(this, parser) > 0 && parser->ok()) {
                 return jarray;
             } else {
-                parser->set_error(jarray->error(), this);
-                delete jarray;
+                JSONParser::Abandon(jarray, pool_);
                 return NULL;
             }
         }
@@ -255,15 +392,94 @@ inline Object* JSONTokener::NextValue(JSONParser* parser) {
         break;
     }
 
-    /*
-     * Handle unquoted text. This could be the values true, false, or
-     * null, or it can be a number. An implementation (such as this one)
-     * is allowed to also accept non-standard forms.
-     *
-     * Accumulate characters until we reach the end of the text or a
-     * formatting character.
-     */
+    Slice text = NextUnquotedText(c);
+    if (text.empty()) {
+        //printf( "Miss value\n" );
+        parser->set_error(JSONParser::kBlankValue, this);
+        return NULL;
+    }
+
+    return JSONObject::ConvertToObject(text.data(), text.size(), parser, this);
+}
+
+inline bool JSONTokener::SkipString(char quote) {
+    const char* end = data() + size();
+    const char* p = GetCurrent();
+    for (;;) {
+        p = SIMDScan::FindQuoteOrEscape(p, end, quote);
+        if (p >= end || *p == 0) {
+            return false;
+        }
+
+        if (*p == quote) {
+            SetCurrent(p + 1);
+            return true;
+        }
+
+        // Skip the escaped character, or a control character which is
+        // kept as it is by NextString
+        p += (*p == '\\') ? 2 : 1;
+    }
+}
+
+inline bool JSONTokener::SkipValue() {
+    string closers; // The expected close brackets of the nested values
+    for (;;) {
+        if (!SkipComment()) {
+            return false;
+        }
+
+        char c = NextClean();
+        switch (c) {
+        case 0:
+            return false;
+        case '"':
+        case '\'':
+            if (!SkipString(c)) {
+                return false;
+            }
+            break;
+        case '{':
+            closers.push_back('}');
+            break;
+        case '[':
+            closers.push_back(']');
+            break;
+        case '(':
+            closers.push_back(')');
+            break;
+        case '}':
+        case ']':
+        case ')':
+            if (closers.empty() || closers.back() != c) {
+                Back();
+                return false;
+            }
+            closers.resize(closers.size() - 1);
+            break;
+        case ',':
+        case ':':
+        case ';':
+            // The separators only appear in an object or an array
+            if (closers.empty()) {
+                Back();
+                return false;
+            }
+            break;
+        default:
+            if (NextUnquotedText(c).empty()) {
+                return false;
+            }
+            break;
+        }
 
+        if (closers.empty()) {
+            return true;
+        }
+    }
+}
+
+inline bool JSONTokener::IsUnquotedTextChar(char c) {
     //the static table of ",:]}/\\\"[{;=#" and space, tab and control characters
     static char specialchars[256] = {
         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -283,45 +499,61 @@ inline Object* JSONTokener::NextValue(JSONParser* parser) {
         1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
         1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1
     };
+    return specialchars[(unsigned char)c] != 0;
+}
+
+inline Slice JSONTokener::NextUnquotedText(char c) {
+    /*
+     * Handle unquoted text. This could be the values true, false, or
+     * null, or it can be a number. An implementation (such as this one)
+     * is allowed to also accept non-standard forms.
+     *
+     * Accumulate characters until we reach the end of the text or a
+     * formatting character.
+     */
 
     const char* startpos = GetCurrent() - 1;
-    while (specialchars[(int)c]) {
+    while (IsUnquotedTextChar(c)) {
         c = Next();
     }
 
     Back();
 
-    if (GetCurrent() <= startpos) {
-        //printf( "Miss value\n" );
-        parser->set_error(JSONParser::kBlankValue, this);
-        return NULL;
+    // Spaces are allowed inside the text, but not at the end of it
+    const char* endpos = GetCurrent();
+    while (endpos > startpos && *(endpos - 1) == ' ') {
+        --endpos;
+    }
+
+    if (endpos <= startpos) {
+        return Slice();
     }
 
-    return JSONObject::ConvertToObject(startpos, GetCurrent() - startpos, parser, this);
+    return Slice(startpos, endpos - startpos);
 }
 
 
 inline bool JSONTokener::SkipComment() {
-    char c = NextClean();
-    if (c != '/') {
-        Back();
-        return true;
-    }
+    for (;;) {
+        // Only peek the next non-space character, since a comment is rare
+        if (!SkipSpaces() || *GetCurrent() != '/') {
+            return true;
+        }
 
-    c = Next();
-    bool successful = false;
+        Next(); // skip '/'
+        char c = Next();
+        bool successful = false;
 
-    if (c == '*') {
-        successful = SkipCStyleComment();
-    } else if (c == '/') {
-        successful = SkipCppStyleComment();
-    }
+        if (c == '*') {
+            successful = SkipCStyleComment();
+        } else if (c == '/') {
+            successful = SkipCppStyleComment();
+        }
 
-    if (successful) {
-        return SkipComment();
-    } else {
-        Back();
-        return false;
+        if (!successful) {
+            Back();
+            return false;
+        }
     }
 }
 
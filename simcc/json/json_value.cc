@@ -3,6 +3,7 @@
 #include "simcc/utility.h"
 #include "json.h"
 #include "json_tokener.h"
+#include "json_dtoa_inl.h"
 
 namespace simcc {
 namespace json {
@@ -17,31 +18,15 @@ JSONInteger& JSONInteger::operator=(simcc::int64 v) {
 }
 
 namespace {
-inline void WriteUint64(simcc::uint64 ui64, simcc::DataStream& ds) {
-    char buffer[20];
-    char* p = buffer;
-    do {
-        *p++ = char(ui64 % 10) + '0';
-        ui64 /= 10;
-    } while (ui64 > 0);
-
-    do {
-        --p;
-        ds.Write(*p);
-    } while (p != buffer);
-}
-
 inline void WriteInt64(simcc::int64 i64, simcc::DataStream& ds) {
-    if (i64 < 0) {
-        ds.Write('-');
-        i64 = -i64;
-    }
-    WriteUint64((uint64_t)i64, ds);
+    char buf[dtoa::kInt64MaxLen + 1];
+    ds.Write(buf, dtoa::i64toa(i64, buf) - buf);
 }
 }
 
 void JSONInteger::ToString(string& s, bool /*readable*/, bool /*utf8_to_unicode*/)const {
-    s = std::to_string(value_);
+    char buf[dtoa::kInt64MaxLen + 1];
+    s.assign(buf, dtoa::i64toa(value_, buf));
 }
 
 void JSONInteger::ToStringBuf(simcc::DataStream& sb, size_t indent, bool /*utf8_to_unicode*/)const {
@@ -49,13 +34,7 @@ void JSONInteger::ToStringBuf(simcc::DataStream& sb, size_t indent, bool /*utf8_
         sb.Write('\t');
     }
 
-#if 1
     WriteInt64(value_, sb);
-#else
-    string s;
-    ToString(s);
-    sb.Write(s.c_str(), s.length());
-#endif
 }
 
 bool JSONInteger::Equals(const Object& rhs) {
@@ -94,52 +73,34 @@ bool JSONDouble::Equals(simcc::float64 v, simcc::float64 tolarence) {
     return simcc::Util::Equals(value_, v, tolarence);
 }
 
-void JSONDouble::ToString(string& s, bool /*readable*/, bool /*utf8_to_unicode*/)const {
-    s = std::to_string(value_);
-    if (s.find('.') != string::npos) {
-        simcc::StringUtil::Trim(s, '0', false);
-        if (*s.rbegin() == '.') {
-            s.append(1, '0');
-        }
-    } else {
-        //TODO fix JSONDouble to int   
+namespace {
+// Writes the shortest string which can be converted back to the same double.
+// JSON has no representation of NaN and Infinity, so they are written as null.
+// @return the end of the written string, which is not null-terminated
+inline char* WriteDouble(double d, char* buf) {
+    if (!std::isfinite(d)) {
+        memcpy(buf, "null", 4);
+        return buf + 4;
     }
+
+    return dtoa::dtoa(d, buf);
+}
 }
 
-namespace {
-    // TODO Optimization with custom double-to-string converter.
-    inline void WriteDouble(double d, simcc::DataStream& ds) {
-        enum { kDoubleMaxLen = 64 };
-        ds.Expand(kDoubleMaxLen);
-        int ret = snprintf(reinterpret_cast<char*>(ds.GetCurrentWriteBuffer()), kDoubleMaxLen - 1, "%f", d);
-        assert(ret >= 1);
-        const char* p = reinterpret_cast<const char*>(ds.GetCurrentWriteBuffer());
-        ds.seekp(ret);
-        const char* pend = reinterpret_cast<const char*>(ds.GetCurrentWriteBuffer());
-        assert(pend - p == ret);
-        while (p != pend) {
-            if (*p++ == '.') {
-                break;
-            }
-        }
-
-        if (p == pend) {
-            ds.Write(".0", 2); // make sure the output is a double number
-        }
-    }
+void JSONDouble::ToString(string& s, bool /*readable*/, bool /*utf8_to_unicode*/)const {
+    char buf[dtoa::kDoubleMaxLen];
+    s.assign(buf, WriteDouble(value_, buf));
 }
 
 void JSONDouble::ToStringBuf(simcc::DataStream& sb, size_t indent, bool /*utf8_to_unicode*/)const {
     for (size_t i = 1; i < indent; i++) {
         sb.Write('\t');
     }
-#if 1
-    WriteDouble(value_, sb);
-#else
-    string s;
-    ToString(s);
-    sb.Write(s.c_str(), s.length());
-#endif
+
+    sb.Expand(dtoa::kDoubleMaxLen);
+    char* begin = reinterpret_cast<char*>(sb.GetCurrentWriteBuffer());
+    char* end = WriteDouble(value_, begin);
+    sb.seekp(static_cast<simcc::int32>(end - begin));
 }
 
 bool JSONDouble::Equals(const Object& rhs) {
@@ -224,9 +185,8 @@ JSONString& JSONString::operator=(const string& v) {
 }
 
 void JSONString::ToString(string& s, bool /*readable*/, bool utf8_to_unicode)const {
-    simcc::DataStream buf(512);
-    JSONObject::Quote(value_, utf8_to_unicode, buf);
-    s.assign(buf.data(), buf.size());
+    s.clear();
+    JSONWriter::Serialize(*this, s, false, utf8_to_unicode);
 }
 
 void JSONString::ToStringBuf(simcc::DataStream& sb, size_t indent, bool utf8_to_unicode)const {
@@ -242,6 +202,10 @@ bool JSONString::Equals(const Object& rhs) {
         return true;
     }
 
+    if (rhs.IsTypeOf(kJSONStringView)) {
+        return static_cast<const JSONStringView&>(rhs).slice() == Slice(value_);
+    }
+
     return false;
 }
 
@@ -258,6 +222,46 @@ bool JSONString::LoadFrom(simcc::DataStream& file) {
 //------------------------------------------------------------------
 
 
+void JSONStringView::ToString(string& s, bool /*readable*/, bool utf8_to_unicode)const {
+    s.clear();
+    JSONWriter::Serialize(*this, s, false, utf8_to_unicode);
+}
+
+void JSONStringView::ToStringBuf(simcc::DataStream& sb, size_t indent, bool utf8_to_unicode)const {
+    for (size_t i = 1; i < indent; i++) {
+        sb.Write('\t');
+    }
+
+    JSONObject::Quote(view_.data(), view_.size(), utf8_to_unicode, sb);
+}
+
+bool JSONStringView::Equals(const Object& rhs) {
+    if (rhs.IsTypeOf(kJSONString)) {
+        return Slice(static_cast<const JSONString&>(rhs).value()) == view_;
+    }
+
+    if (rhs.type() == type() && static_cast<const JSONStringView&>(rhs).view_ == view_) {
+        return true;
+    }
+
+    return false;
+}
+
+void JSONStringView::SaveTo(simcc::DataStream& file) const {
+    // The same format as JSONString::SaveTo
+    file << (simcc::uint8)kJSONString
+        << (simcc::uint32)view_.size();
+    file.Write(view_.data(), view_.size());
+}
+
+bool JSONStringView::LoadFrom(simcc::DataStream& /*file*/) {
+    assert(false && "A JSONStringView is loaded as a JSONString");
+    return false;
+}
+
+//------------------------------------------------------------------
+
+
 void JSONNull::ToString(string& s, bool /*readable*/, bool /*utf8_to_unicode*/)const {
     static const string n = "null";
     s = n;
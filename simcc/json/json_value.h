@@ -161,7 +161,40 @@ private:
     // override method from base class json::Object
     virtual bool LoadFrom(simcc::DataStream& file);
     virtual void SaveTo(simcc::DataStream& file) const;
+};
+
+// The concrete object of JSON : JSONStringView
+//
+// A string parsed in the in-situ mode (see JSONObject::ParseInSitu).
+// It refers to the source text instead of owning a copy of it, so the
+// source text MUST outlive it. It is read only, use JSONString for a
+// string which can be modified.
+class SIMCC_EXPORT JSONStringView : public Object {
+public:
+    enum { Type = kJSONStringView };
+    JSONStringView(const Slice& view = Slice())
+        : Object(kJSONStringView), view_(view) {}
+
+    const Slice& slice() const {
+        return view_;
+    }
+
+    using Object::ToString; // string ToString(bool readable = false, bool utf8_to_unicode = true) const;
+    virtual void ToString(string& s, bool readable = false, bool utf8_to_unicode = true)const;
+    virtual void ToStringBuf(simcc::DataStream& sb, size_t indent = 0, bool utf8_to_unicode = true)const;
 
+    // @warning This method is quite not effective, so make sure why you need call this method
+    // @note We mostly use this method to do some unit test
+    // @return true If rhs is a JSONStringView or JSONString and the value is equal to each other
+    virtual bool Equals(const Object& rhs);
+private:
+    // override method from base class json::Object
+    // It is saved as a JSONString, so it is loaded as a JSONString
+    virtual bool LoadFrom(simcc::DataStream& file);
+    virtual void SaveTo(simcc::DataStream& file) const;
+
+private:
+    Slice view_;
 };
 
 
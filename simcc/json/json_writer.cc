@@ -0,0 +1,189 @@
+#include "simcc/inner_pre.h"
+
+#include "json.h"
+#include "json_writer.h"
+
+#ifdef H_OS_WINDOWS
+#include <io.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+namespace simcc {
+namespace json {
+
+namespace {
+bool IsContainer(const Object* o) {
+    return o->type() == kJSONObject || o->type() == kJSONArray;
+}
+}
+
+// The text is streamed into <code>s</code> through a small buffer which
+// stays in the cache, no buffer of the whole text is built and copied.
+//   A text shorter than a chunk is appended at once. A longer one grows
+// the string by 4 times, so it is copied by fewer reallocations than the
+// doubling of std::string. The unused capacity is not touched.
+void JSONWriter::Serialize(const Object& o, string& s, bool readable, bool utf8_to_unicode) {
+    const size_t chunk_size = 16 * 1024;
+    JSONWriter w([&s, chunk_size](const char* data, size_t len) {
+        if (len >= chunk_size && s.capacity() - s.size() < len) {
+            s.reserve((s.size() + len) * 4);
+        }
+        s.append(data, len);
+        return true;
+    }, chunk_size);
+    w.Write(o, readable, utf8_to_unicode);
+}
+
+void JSONWriter::Serialize(const Object& o, simcc::DataStream& ds, bool readable, bool utf8_to_unicode) {
+    o.ToStringBuf(ds, readable ? 1 : 0, utf8_to_unicode);
+}
+
+bool JSONWriter::SerializeToFd(const Object& o, int fd, bool readable, bool utf8_to_unicode) {
+    JSONWriter w([fd](const char* data, size_t len) {
+        while (len > 0) {
+#ifdef H_OS_WINDOWS
+            int n = ::_write(fd, data, static_cast<unsigned int>(len));
+#else
+            ssize_t n = ::write(fd, data, len);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+#endif
+            if (n <= 0) {
+                return false;
+            }
+
+            data += n;
+            len -= n;
+        }
+        return true;
+    });
+    return w.Write(o, readable, utf8_to_unicode);
+}
+
+JSONWriter::JSONWriter(const Sink& sink, size_t chunk_size)
+    : sink_(sink), chunk_size_(chunk_size), buf_(chunk_size + 512) {
+}
+
+bool JSONWriter::Write(const Object& o, bool readable, bool utf8_to_unicode) {
+    buf_.Reset();
+    if (!WriteValue(&o, readable ? 1 : 0, utf8_to_unicode)) {
+        return false;
+    }
+    return Flush(true);
+}
+
+bool JSONWriter::WriteValue(const Object* o, size_t indent, bool utf8_to_unicode) {
+    switch (o->type()) {
+    case kJSONObject:
+        return WriteObject(static_cast<const JSONObject*>(o), indent, utf8_to_unicode);
+    case kJSONArray:
+        return WriteArray(static_cast<const JSONArray*>(o), indent, utf8_to_unicode);
+    default:
+        o->ToStringBuf(buf_, indent, utf8_to_unicode);
+        return Flush(false);
+    }
+}
+
+bool JSONWriter::WriteObject(const JSONObject* jo, size_t indent, bool utf8_to_unicode) {
+    if (indent > 1) {
+        WriteIndent(indent - 1);
+    }
+
+    buf_.Write('{');
+    if (indent > 0) {
+        buf_.Write('\n');
+    }
+
+    bool need_comma = false;
+    for (auto it = jo->begin(), ite = jo->end(); it != ite; ++it) {
+        if (need_comma) {
+            buf_.Write(',');
+            if (indent > 0) {
+                buf_.Write('\n');
+            }
+        } else {
+            need_comma = true;
+        }
+
+        WriteIndent(indent);
+        JSONObject::Quote(it->first, utf8_to_unicode, buf_);
+        buf_.Write(':');
+
+        bool ok = false;
+        if (indent > 0 && IsContainer(it->second.get())) {
+            buf_.Write('\n');
+            ok = WriteValue(it->second.get(), indent + 1, utf8_to_unicode);
+        } else {
+            ok = WriteValue(it->second.get(), 0, utf8_to_unicode);
+        }
+
+        if (!ok) {
+            return false;
+        }
+    }
+
+    if (indent > 0) {
+        buf_.Write('\n');
+        WriteIndent(indent - 1);
+    }
+
+    buf_.Write('}');
+    return true;
+}
+
+bool JSONWriter::WriteArray(const JSONArray* ja, size_t indent, bool utf8_to_unicode) {
+    if (indent > 1) {
+        WriteIndent(indent - 1);
+    }
+
+    buf_.Write('[');
+    if (indent > 0) {
+        buf_.Write('\n');
+    }
+
+    bool need_comma = false;
+    for (auto it = ja->begin(), ite = ja->end(); it != ite; ++it) {
+        if (need_comma) {
+            buf_.Write(',');
+            if (indent > 0) {
+                buf_.Write('\n');
+            }
+        } else {
+            need_comma = true;
+        }
+
+        if (!WriteValue(it->get(), indent > 0 ? indent + 1 : 0, utf8_to_unicode)) {
+            return false;
+        }
+    }
+
+    if (indent > 0) {
+        buf_.Write('\n');
+        WriteIndent(indent - 1);
+    }
+
+    buf_.Write(']');
+    return true;
+}
+
+void JSONWriter::WriteIndent(size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        buf_.Write('\t');
+    }
+}
+
+bool JSONWriter::Flush(bool force) {
+    if (buf_.size() == 0 || (!force && buf_.size() < chunk_size_)) {
+        return true;
+    }
+
+    bool ok = sink_(buf_.data(), buf_.size());
+    buf_.Reset();
+    return ok;
+}
+
+}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+#include "simcc/data_stream.h"
+
+#include "json_common.h"
+
+#include <functional>
+
+namespace simcc {
+namespace json {
+
+// A serializer of the json object trees, which produces the same text as
+// Object::ToString and Object::ToStringBuf.
+//
+// The text is written directly into the string, DataStream or file
+// descriptor of the caller, it is not built in a buffer of its own first.
+//
+// A huge document can be streamed to a Sink in chunks, and the whole text
+// is never kept in memory.
+//
+// Usage:
+//    string body;
+//    JSONWriter::Serialize(jo, body);
+//
+//    JSONWriter w([&](const char* data, size_t len) {
+//        return conn->Send(data, len);
+//    });
+//    w.Write(jo);
+class SIMCC_EXPORT JSONWriter {
+public:
+    // The receiver of the chunks of the text.
+    // @return false to stop writing
+    typedef std::function<bool(const char* data, size_t len)> Sink;
+
+    // Append the text to <code>s</code> or <code>ds</code>
+    static void Serialize(const Object& o, string& s, bool readable = false, bool utf8_to_unicode = true);
+    static void Serialize(const Object& o, simcc::DataStream& ds, bool readable = false, bool utf8_to_unicode = true);
+
+    // Write the text to a file descriptor, e.g. a file or a socket
+    // @return false if failed to write
+    static bool SerializeToFd(const Object& o, int fd, bool readable = false, bool utf8_to_unicode = true);
+
+    // @param chunk_size the text is passed to the sink once the buffered text reaches it
+    explicit JSONWriter(const Sink& sink, size_t chunk_size = 64 * 1024);
+
+    // Stream the text of <code>o</code> to the sink
+    // @return false if the sink stopped the writing
+    bool Write(const Object& o, bool readable = false, bool utf8_to_unicode = true);
+
+private:
+    bool WriteValue(const Object* o, size_t indent, bool utf8_to_unicode);
+    bool WriteObject(const JSONObject* jo, size_t indent, bool utf8_to_unicode);
+    bool WriteArray(const JSONArray* ja, size_t indent, bool utf8_to_unicode);
+    void WriteIndent(size_t n);
+
+    // Pass the buffered text to the sink if it is big enough
+    bool Flush(bool force);
+
+private:
+    Sink sink_;
+    size_t chunk_size_;
+    simcc::DataStream buf_;
+};
+
+}
+}
@@ -0,0 +1,215 @@
+#include "simcc/inner_pre.h"
+#include "simcc/mapped_file.h"
+
+#ifdef H_OS_WINDOWS
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace simcc {
+
+namespace {
+const size_t kReadChunkSize = 64 * 1024;
+}
+
+MappedFile::MappedFile()
+    : data_(NULL), size_(0), mapped_(false)
+#ifdef H_OS_WINDOWS
+    , file_(INVALID_HANDLE_VALUE), mapping_(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef H_OS_WINDOWS
+namespace {
+bool ReadAll(HANDLE file, string& buf) {
+    for (;;) {
+        size_t len = buf.size();
+        buf.resize(len + kReadChunkSize);
+        DWORD n = 0;
+        if (!::ReadFile(file, &buf[len], static_cast<DWORD>(kReadChunkSize), &n, NULL)) {
+            buf.resize(len);
+            // The write end of a pipe is closed
+            return ::GetLastError() == ERROR_BROKEN_PIPE;
+        }
+
+        buf.resize(len + n);
+        if (n == 0) {
+            return true;
+        }
+    }
+}
+}
+
+bool MappedFile::Open(const string& path, Advice advice) {
+    Close();
+
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (advice == kSequential) {
+        flags = FILE_FLAG_SEQUENTIAL_SCAN;
+    } else if (advice == kRandom) {
+        flags = FILE_FLAG_RANDOM_ACCESS;
+    }
+
+    HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                OPEN_EXISTING, flags, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    file_ = file;
+    if (::GetFileType(file) != FILE_TYPE_DISK) {
+        if (!ReadAll(file, buf_)) {
+            Close();
+            return false;
+        }
+
+        data_ = buf_.empty() ? NULL : buf_.data();
+        size_ = buf_.size();
+        return true;
+    }
+
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(file, &size)) {
+        Close();
+        return false;
+    }
+
+    if (size.QuadPart == 0) {
+        return true;
+    }
+
+    mapping_ = ::CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping_) {
+        Close();
+        return false;
+    }
+
+    data_ = static_cast<const char*>(::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) {
+        Close();
+        return false;
+    }
+
+    size_ = static_cast<size_t>(size.QuadPart);
+    mapped_ = true;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (mapped_) {
+        ::UnmapViewOfFile(data_);
+    }
+
+    if (mapping_) {
+        ::CloseHandle(mapping_);
+    }
+
+    if (file_ != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(file_);
+    }
+
+    data_ = NULL;
+    size_ = 0;
+    mapped_ = false;
+    string().swap(buf_);
+    mapping_ = NULL;
+    file_ = INVALID_HANDLE_VALUE;
+}
+#else
+namespace {
+bool ReadAll(int fd, string& buf) {
+    for (;;) {
+        size_t len = buf.size();
+        buf.resize(len + kReadChunkSize);
+        ssize_t n = ::read(fd, &buf[len], kReadChunkSize);
+        if (n < 0) {
+            buf.resize(len);
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        buf.resize(len + n);
+        if (n == 0) {
+            return true;
+        }
+    }
+}
+}
+
+bool MappedFile::Open(const string& path, Advice advice) {
+    Close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // A pipe or a device can not be mapped. An empty regular file may be
+    // a generated one which has no size, e.g. /proc/cpuinfo.
+    if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+        bool ok = ReadAll(fd, buf_);
+        ::close(fd);
+        if (!ok) {
+            string().swap(buf_);
+            return false;
+        }
+
+        data_ = buf_.empty() ? NULL : buf_.data();
+        size_ = buf_.size();
+        return true;
+    }
+
+    void* p = ::mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping is kept after the file is closed
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+
+    data_ = static_cast<const char*>(p);
+    size_ = static_cast<size_t>(st.st_size);
+    mapped_ = true;
+
+    // The advices are only the hints, so the errors are ignored
+    if (advice == kSequential) {
+        ::madvise(p, size_, MADV_SEQUENTIAL);
+        ::madvise(p, size_, MADV_WILLNEED);
+    } else if (advice == kRandom) {
+        ::madvise(p, size_, MADV_RANDOM);
+    }
+
+    return true;
+}
+
+void MappedFile::Close() {
+    if (mapped_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+
+    data_ = NULL;
+    size_ = 0;
+    mapped_ = false;
+    string().swap(buf_);
+}
+#endif
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+#include "simcc/slice.h"
+
+namespace simcc {
+
+// A read-only memory mapped file. The content of the file is accessed
+// directly by the pages of the file, no copy is made.
+//   A file which can not be mapped (a pipe, a character device or a file
+// without a known size such as the ones in /proc) is read into a buffer instead.
+//
+// Usage:
+//    MappedFile f;
+//    if (f.Open("/data/dump.json")) {
+//        Process(f.data(), f.size());
+//    }
+class SIMCC_EXPORT MappedFile {
+public:
+    // The hint of how the pages will be accessed
+    enum Advice {
+        kNormal,
+        kSequential, // Read ahead aggressively, e.g. to parse the whole file
+        kRandom,     // Do not read ahead, e.g. to look up some parts of the file
+    };
+
+    MappedFile();
+    ~MappedFile();
+
+    // Map the whole file into the memory.
+    // @return false if failed to open, map or read the file
+    bool Open(const string& path, Advice advice = kNormal);
+
+    // Unmap the file. The data MUST NOT be used any more.
+    void Close();
+
+    // The content of the file. It is NULL for an empty file.
+    const char* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    Slice slice() const {
+        return Slice(data_, size_);
+    }
+
+    // false if the file is read into a buffer instead of being mapped
+    bool mapped() const {
+        return mapped_;
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+    bool mapped_;
+    string buf_; // The content of the file which is not mapped
+
+#ifdef H_OS_WINDOWS
+    void* file_;
+    void* mapping_;
+#endif
+
+    // Disallow copy
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+}
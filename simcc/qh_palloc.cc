@@ -198,8 +198,21 @@ qh_destroy_pool(qh_pool_t *pool)
 void
 qh_reset_pool(qh_pool_t *pool)
 {/*{{{*/
-    qh_pool_t        *p;
-    qh_pool_large_t  *l;
+    qh_pool_t          *p;
+    qh_pool_large_t    *l;
+    qh_pool_cleanup_t  *c;
+
+    /*
+     * the cleanup handlers are allocated from this pool,
+     * so we must run and drop them before the memory is reused
+     */
+    for (c = pool->cleanup; c; c = c->next) {
+        if (c->handler) {
+            c->handler(c->data);
+        }
+    }
+
+    pool->cleanup = NULL;
 
     for (l = pool->large; l; l = l->next) {
         if (l->alloc) {
@@ -211,7 +224,10 @@ qh_reset_pool(qh_pool_t *pool)
 
     for (p = pool; p; p = p->d.next) {
         p->d.last = (unsigned char *) p + sizeof(qh_pool_t);
+        p->d.failed = 0;
     }
+
+    pool->current = pool;
 }/*}}}*/
 
 
@@ -234,6 +250,16 @@ qh_palloc(qh_pool_t *pool, size_t size)
                 return m;
             }
 
+            /*
+             * the recycled blocks are not passed by qh_palloc_block after
+             * qh_reset_pool, so we move the current block forward here
+             * once it failed too many times, or every allocation walks
+             * all the full blocks from the first one
+             */
+            if (p == pool->current && p->d.failed++ > 4 && p->d.next) {
+                pool->current = p->d.next;
+            }
+
             p = p->d.next;
 
         } while (p);
@@ -264,6 +290,16 @@ qh_pnalloc(qh_pool_t *pool, size_t size)
                 return m;
             }
 
+            /*
+             * the recycled blocks are not passed by qh_palloc_block after
+             * qh_reset_pool, so we move the current block forward here
+             * once it failed too many times, or every allocation walks
+             * all the full blocks from the first one
+             */
+            if (p == pool->current && p->d.failed++ > 4 && p->d.next) {
+                pool->current = p->d.next;
+            }
+
             p = p->d.next;
 
         } while (p);
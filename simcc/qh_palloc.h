@@ -192,6 +192,12 @@ namespace qh {
             qh_pfree(pool_, p);
         }
 
+        // Release all the memory allocated from this pool at once,
+        // the cleanup handlers are called before that.
+        void reset() {
+            qh_reset_pool(pool_);
+        }
+
     private:
         qh_pool_t * pool_;
     };
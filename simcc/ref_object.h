@@ -78,6 +78,10 @@ public:
         }
     }
 
+    RefPtr(RefPtr&& r) noexcept : ptr_(r.ptr_) {
+        r.ptr_ = NULL;
+    }
+
     template< class U >
     RefPtr(const RefPtr<U>& r) {
         ptr_ = dynamic_cast<object_type*>(r.get());
@@ -91,6 +95,18 @@ public:
         return *this;
     }
 
+    RefPtr& operator=(RefPtr&& r) noexcept {
+        if (this != &r) {
+            T* old = ptr_;
+            ptr_ = r.ptr_;
+            r.ptr_ = NULL;
+            if (old) {
+                old->Release();
+            }
+        }
+        return *this;
+    }
+
     // assigner
     RefPtr& operator=(object_type* rep) {
         Bind(rep);
@@ -0,0 +1,292 @@
+#include "simcc/inner_pre.h"
+#include "simd_scan.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define H_SIMD_SCAN_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define H_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define H_TARGET_AVX2
+#endif
+
+namespace simcc {
+
+namespace {
+
+inline int CountTrailingZeros(simcc::uint32 mask) {
+    assert(mask != 0);
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+inline bool IsQuoteOrEscape(unsigned char c, unsigned char quote) {
+    return c == quote || c == '\\' || c < 0x20;
+}
+
+inline bool IsQuoteCandidate(unsigned char c, bool non_ascii) {
+    return c == '"' || c == '\\' || c == '/' || c < 0x20 || (non_ascii && c >= 0x80);
+}
+
+inline bool IsSpace(unsigned char c) {
+    return static_cast<unsigned char>(c - 1) < 0x20;
+}
+
+const char* FindQuoteOrEscapeScalar(const char* p, const char* end, char quote) {
+    for (; p < end; ++p) {
+        if (IsQuoteOrEscape(static_cast<unsigned char>(*p), static_cast<unsigned char>(quote))) {
+            return p;
+        }
+    }
+    return end;
+}
+
+const char* FindQuoteCandidateScalar(const char* p, const char* end, bool non_ascii) {
+    for (; p < end; ++p) {
+        if (IsQuoteCandidate(static_cast<unsigned char>(*p), non_ascii)) {
+            return p;
+        }
+    }
+    return end;
+}
+
+const char* SkipSpacesScalar(const char* p, const char* end) {
+    for (; p < end; ++p) {
+        if (!IsSpace(static_cast<unsigned char>(*p))) {
+            return p;
+        }
+    }
+    return end;
+}
+
+#ifdef H_SIMD_SCAN_X86
+const char* FindQuoteOrEscapeSSE2(const char* p, const char* end, char quote) {
+    const __m128i q = _mm_set1_epi8(quote);
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i ctrl = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, bs));
+        // v <= 0x1F (unsigned) <==> max(v, 0x1F) == 0x1F
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl));
+        int mask = _mm_movemask_epi8(m);
+        if (mask) {
+            return p + CountTrailingZeros(static_cast<simcc::uint32>(mask));
+        }
+    }
+    return FindQuoteOrEscapeScalar(p, end, quote);
+}
+
+H_TARGET_AVX2
+const char* FindQuoteOrEscapeAVX2(const char* p, const char* end, char quote) {
+    const __m256i q = _mm256_set1_epi8(quote);
+    const __m256i bs = _mm256_set1_epi8('\\');
+    const __m256i ctrl = _mm256_set1_epi8(0x1F);
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, q), _mm256_cmpeq_epi8(v, bs));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl), ctrl));
+        simcc::uint32 mask = static_cast<simcc::uint32>(_mm256_movemask_epi8(m));
+        if (mask) {
+            return p + CountTrailingZeros(mask);
+        }
+    }
+    return FindQuoteOrEscapeSSE2(p, end, quote);
+}
+
+const char* FindQuoteCandidateSSE2(const char* p, const char* end, bool non_ascii) {
+    const __m128i q = _mm_set1_epi8('"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i ctrl = _mm_set1_epi8(0x1F);
+    // The high bits of the bytes are the non-ASCII ones
+    const int high = non_ascii ? 0xFFFF : 0;
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, bs));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, slash));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl));
+        int mask = _mm_movemask_epi8(m) | (_mm_movemask_epi8(v) & high);
+        if (mask) {
+            return p + CountTrailingZeros(static_cast<simcc::uint32>(mask));
+        }
+    }
+    return FindQuoteCandidateScalar(p, end, non_ascii);
+}
+
+H_TARGET_AVX2
+const char* FindQuoteCandidateAVX2(const char* p, const char* end, bool non_ascii) {
+    const __m256i q = _mm256_set1_epi8('"');
+    const __m256i bs = _mm256_set1_epi8('\\');
+    const __m256i slash = _mm256_set1_epi8('/');
+    const __m256i ctrl = _mm256_set1_epi8(0x1F);
+    const simcc::uint32 high = non_ascii ? 0xFFFFFFFF : 0;
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, q), _mm256_cmpeq_epi8(v, bs));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, slash));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl), ctrl));
+        simcc::uint32 mask = static_cast<simcc::uint32>(_mm256_movemask_epi8(m))
+                             | (static_cast<simcc::uint32>(_mm256_movemask_epi8(v)) & high);
+        if (mask) {
+            return p + CountTrailingZeros(mask);
+        }
+    }
+    return FindQuoteCandidateSSE2(p, end, non_ascii);
+}
+
+// A byte v is a white space <==> (unsigned)(v - 1) <= 0x1F, so NUL is not
+const char* SkipSpacesSSE2(const char* p, const char* end) {
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i ws = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), one);
+        __m128i m = _mm_cmpeq_epi8(_mm_max_epu8(v, ws), ws);
+        simcc::uint32 mask = static_cast<simcc::uint32>(_mm_movemask_epi8(m)) ^ 0xFFFF;
+        if (mask) {
+            return p + CountTrailingZeros(mask);
+        }
+    }
+    return SkipSpacesScalar(p, end);
+}
+
+H_TARGET_AVX2
+const char* SkipSpacesAVX2(const char* p, const char* end) {
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i ws = _mm256_set1_epi8(0x1F);
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), one);
+        __m256i m = _mm256_cmpeq_epi8(_mm256_max_epu8(v, ws), ws);
+        simcc::uint32 mask = ~static_cast<simcc::uint32>(_mm256_movemask_epi8(m));
+        if (mask) {
+            return p + CountTrailingZeros(mask);
+        }
+    }
+    return SkipSpacesSSE2(p, end);
+}
+
+bool CPUSupportsAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // The OS must save the YMM registers
+    __cpuid(info, 1);
+    const int kOSXSAVE = 1 << 27;
+    const int kAVX = 1 << 28;
+    if ((info[2] & kOSXSAVE) == 0 || (info[2] & kAVX) == 0) {
+        return false;
+    }
+    if ((_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif // H_SIMD_SCAN_X86
+
+SIMDScan::Level DetectLevel() {
+#ifdef H_SIMD_SCAN_X86
+    if (CPUSupportsAVX2()) {
+        return SIMDScan::kAVX2;
+    }
+    return SIMDScan::kSSE2;
+#else
+    return SIMDScan::kScalar;
+#endif
+}
+
+struct Dispatcher {
+    SIMDScan::Level supported;
+    SIMDScan::Level level;
+    const char* (*find_quote_or_escape)(const char*, const char*, char);
+    const char* (*find_quote_candidate)(const char*, const char*, bool);
+    const char* (*skip_spaces)(const char*, const char*);
+
+    Dispatcher() {
+        supported = DetectLevel();
+        Set(supported);
+    }
+
+    void Set(SIMDScan::Level l) {
+        level = l;
+        switch (l) {
+#ifdef H_SIMD_SCAN_X86
+        case SIMDScan::kAVX2:
+            find_quote_or_escape = &FindQuoteOrEscapeAVX2;
+            find_quote_candidate = &FindQuoteCandidateAVX2;
+            skip_spaces = &SkipSpacesAVX2;
+            break;
+        case SIMDScan::kSSE2:
+            find_quote_or_escape = &FindQuoteOrEscapeSSE2;
+            find_quote_candidate = &FindQuoteCandidateSSE2;
+            skip_spaces = &SkipSpacesSSE2;
+            break;
+#endif
+        default:
+            level = SIMDScan::kScalar;
+            find_quote_or_escape = &FindQuoteOrEscapeScalar;
+            find_quote_candidate = &FindQuoteCandidateScalar;
+            skip_spaces = &SkipSpacesScalar;
+            break;
+        }
+    }
+};
+
+// Initialized on the first use, so it works during the static initialization
+Dispatcher& GetDispatcher() {
+    static Dispatcher d;
+    return d;
+}
+}
+
+SIMDScan::Level SIMDScan::level() {
+    return GetDispatcher().level;
+}
+
+SIMDScan::Level SIMDScan::supported_level() {
+    return GetDispatcher().supported;
+}
+
+bool SIMDScan::set_level(Level l) {
+    Dispatcher& d = GetDispatcher();
+    if (l > d.supported) {
+        return false;
+    }
+
+    d.Set(l);
+    return true;
+}
+
+const char* SIMDScan::FindQuoteOrEscape(const char* p, const char* end, char quote) {
+    return GetDispatcher().find_quote_or_escape(p, end, quote);
+}
+
+const char* SIMDScan::FindQuoteCandidate(const char* p, const char* end, bool non_ascii) {
+    return GetDispatcher().find_quote_candidate(p, end, non_ascii);
+}
+
+const char* SIMDScan::SkipSpaces(const char* p, const char* end) {
+    return GetDispatcher().skip_spaces(p, end);
+}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "simcc/inner_pre.h"
+
+namespace simcc {
+
+// Byte scanning routines used by the parsers, which process 16 bytes (SSE2)
+// or 32 bytes (AVX2) a time. The fastest implementation supported by the
+// running CPU is chosen at runtime, and the scalar one is used on other
+// platforms.
+//
+// All the routines never read the memory at or after <code>end</code>.
+class SIMCC_EXPORT SIMDScan {
+public:
+    enum Level {
+        kScalar = 0,
+        kSSE2 = 1,
+        kAVX2 = 2,
+    };
+
+    // The implementation currently used
+    static Level level();
+
+    // The best implementation supported by the running CPU
+    static Level supported_level();
+
+    // Change the implementation. It is mostly used by tests and benchmarks.
+    // It is not thread safe, so call it before any parsing.
+    // @return false if the CPU does not support this level
+    static bool set_level(Level l);
+
+    // Finds the first byte which is <code>quote</code>, a backslash
+    // or a control character (less than 0x20) in [p, end).
+    // @return the position of the byte, or end if there is no such a byte
+    static const char* FindQuoteOrEscape(const char* p, const char* end, char quote);
+
+    // Finds the first byte which may be escaped when a json string is quoted:
+    // a '"', a backslash, a '/', a control character (less than 0x20), or
+    // a non-ASCII byte (not less than 0x80) if <code>non_ascii</code> is true.
+    // @return the position of the byte, or end if there is no such a byte
+    static const char* FindQuoteCandidate(const char* p, const char* end, bool non_ascii);
+
+    // Skips the white spaces, i.e. the bytes in [0x01, 0x20], in [p, end).
+    // A NUL byte is not a white space.
+    // @return the position of the first non-white-space byte,
+    //     or end if there is no such a byte
+    static const char* SkipSpaces(const char* p, const char* end);
+};
+
+}
@@ -2,6 +2,7 @@
 
 #include "simcc/inner_pre.h"
 #include "simcc/slice.h"
+#include "simcc/simd_scan.h"
 
 namespace simcc {
 
@@ -123,6 +124,11 @@ public:
     }
 
 protected:
+    // White spaces are the bytes in [0x01, 0x20]
+    static bool IsSpace(char c) {
+        return static_cast<unsigned char>(c - 1) < 0x20;
+    }
+
     void SetCurrent(size_t pos) {
         current_ = data_ + pos;
     }
@@ -213,13 +219,8 @@ inline char Tokener::Current() {
 }
 
 inline char Tokener::NextClean() {
-    for (char c = 0; current_ < end_;) {
-        c = *current_++;
-
-        /** c < 0 means This is not an ASCII character, like GBK code */
-        if (c > ' ' || c == 0 || c < 0) {
-            return c;
-        }
+    if (SkipSpaces()) {
+        return *current_++;
     }
 
     return 0;
@@ -303,18 +304,17 @@ inline char Tokener::SkipBackTo(char to) {
 }
 
 inline bool Tokener::SkipSpaces() {
-    for (char c = 0; current_ < end_;) {
-        c = *current_++;
-
-        if (c > ' ' || c <= 0) {
-            Back();
-            return true;
-        } else {
-            continue;
+    // Most tokens are preceded by none or a single white space, which are
+    // checked here. The longer runs, e.g. indents, are skipped in blocks.
+    // The bytes >= 0x80 (not ASCII, like GBK code) and NUL are not spaces.
+    if (current_ < end_ && IsSpace(*current_)) {
+        ++current_;
+        if (current_ < end_ && IsSpace(*current_)) {
+            current_ = SIMDScan::SkipSpaces(current_ + 1, end_);
         }
     }
 
-    return false;
+    return current_ < end_;
 }
 
 
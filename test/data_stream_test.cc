@@ -482,3 +482,52 @@ TEST_UNIT(test_memory_data_stream_2) {
 H_IS_POD_TYPE(TestStruct2, true);
 
 
+
+TEST_UNIT(test_memory_data_stream_growth_policy) {
+    std::string s(100, 'a');
+
+    // The default policy grows by half of the required size
+    DataStream ds;
+    ds.Write(s.data(), s.size());
+    H_TEST_ASSERT(ds.capacity() == 151);
+
+    DataStream exact;
+    exact.SetGrowthPolicy(1.0);
+    exact.Write(s.data(), s.size());
+    H_TEST_ASSERT(exact.capacity() == 101);
+    exact.Write('b');
+    H_TEST_ASSERT(exact.capacity() == 102);
+
+    DataStream limited;
+    limited.SetGrowthPolicy(2.0, 10);
+    limited.Write(s.data(), s.size());
+    H_TEST_ASSERT(limited.capacity() == 111);
+
+    // Shrunk to the data and the spare byte
+    limited.Reserve(4096);
+    H_TEST_ASSERT(limited.capacity() == 4096);
+    H_TEST_ASSERT(limited.ShrinkToFit());
+    H_TEST_ASSERT(limited.capacity() == 101);
+    H_TEST_ASSERT(std::string(limited.data(), limited.size()) == s);
+    limited.ToText();
+    H_TEST_ASSERT(strcmp(limited.data(), s.c_str()) == 0);
+
+    // The outside memory is kept
+    char buf[64];
+    DataStream outside(buf, sizeof(buf), false);
+    outside.Write("abc", 3);
+    H_TEST_ASSERT(outside.ShrinkToFit());
+    H_TEST_ASSERT(outside.data() == buf && outside.capacity() == sizeof(buf));
+
+    // Copied out of the outside memory when it grows
+    outside.Write(s.data(), s.size());
+    H_TEST_ASSERT(outside.data() != buf);
+    H_TEST_ASSERT(std::string(outside.data(), outside.size()) == "abc" + s);
+
+    // The offsets are not truncated to 32 bits
+    outside.seekg(simcc::int64(1) << 32);
+    H_TEST_ASSERT(outside.IsReadBad());
+    H_TEST_ASSERT(outside.tellg() == outside.size());
+    outside.seekp(-(simcc::int64(1) << 32));
+    H_TEST_ASSERT(outside.size() == 0);
+}
@@ -2,6 +2,7 @@
 #include "test_common.h"
 #include "simcc/data_stream.h"
 #include "simcc/file_util.h"
+#include "simcc/mapped_file.h"
 
 #include <iostream>
 
@@ -83,3 +84,42 @@ TEST_UNIT(FileUtil_test_1) {
     H_TEST_ASSERT(r == 0);
 }
 
+TEST_UNIT(MappedFile_test) {
+    std::string path = "temp_mapped_file.dat";
+    DataStream ds;
+    for (int i = 0; i < 1000; ++i) {
+        ds.Write(path.data(), path.size());
+    }
+    H_TEST_ASSERT(ds.WriteFile(path));
+
+    MappedFile f;
+    H_TEST_ASSERT(f.Open(path));
+    H_TEST_ASSERT(f.mapped());
+    H_TEST_ASSERT(f.size() == ds.size());
+    H_TEST_ASSERT(memcmp(f.data(), ds.data(), ds.size()) == 0);
+    f.Close();
+    H_TEST_ASSERT(f.data() == NULL && f.size() == 0 && !f.mapped());
+
+    H_TEST_ASSERT(f.Open(path, MappedFile::kSequential));
+    H_TEST_ASSERT(f.size() == ds.size());
+    H_TEST_ASSERT(memcmp(f.data(), ds.data(), ds.size()) == 0);
+    H_TEST_ASSERT(f.Open(path, MappedFile::kRandom));
+    H_TEST_ASSERT(f.size() == ds.size());
+
+    // An empty file
+    DataStream empty;
+    H_TEST_ASSERT(empty.WriteFile(path));
+    H_TEST_ASSERT(f.Open(path));
+    H_TEST_ASSERT(f.size() == 0);
+    f.Close();
+    FileUtil::Unlink(path);
+
+    H_TEST_ASSERT(!f.Open("temp_mapped_file.not_exist"));
+
+#ifdef __linux__
+    // A file which has no size is read instead
+    H_TEST_ASSERT(f.Open("/proc/self/status"));
+    H_TEST_ASSERT(!f.mapped() && f.size() > 0);
+    H_TEST_ASSERT(f.slice().ToString().find("Name:") != std::string::npos);
+#endif
+}
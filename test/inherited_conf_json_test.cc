@@ -2,6 +2,7 @@
 #include "test_common.h"
 #include "simcc/json/json.h"
 #include "simcc/json/inherited_conf_json.h"
+#include "simcc/file_util.h"
 #include <iostream>
 
 TEST_UNIT(inherited_conf_json_test1) {
@@ -47,3 +48,71 @@ TEST_UNIT(inherited_conf_json_test_failed) {
 }
 
 
+
+namespace {
+void WriteConf(const std::string& path, const std::string& text) {
+    simcc::DataStream ds;
+    ds.Write(text.data(), text.size());
+    H_TEST_ASSERT(ds.WriteFile(path));
+}
+}
+
+TEST_UNIT(inherited_conf_loader) {
+    using namespace simcc::json;
+    WriteConf("temp_conf_base.json", "{\"host\" : \"base\", \"server\" : {\"port\" : 80, \"tags\" : [1]}}");
+    WriteConf("temp_conf_a.json", "{\"inherited_from\" : \"temp_conf_base.json\", \"host\" : \"a\"}");
+    WriteConf("temp_conf_b.json", "{\"inherited_from\" : \"temp_conf_base.json\", \"server\" : {\"port\" : 81}}");
+
+    InheritedConfLoader loader;
+    JSONObjectPtr a = loader.Load("temp_conf_a.json");
+    JSONObjectPtr b = loader.Load("temp_conf_b.json");
+    H_TEST_ASSERT(a && b);
+    H_TEST_ASSERT(loader.size() == 3);
+    H_TEST_ASSERT(a->GetString("host") == "a");
+    H_TEST_ASSERT(a->GetJSONObject("server")->GetInteger("port") == 80);
+    H_TEST_ASSERT(b->GetString("host") == "base");
+    H_TEST_ASSERT(b->GetJSONObject("server")->GetInteger("port") == 81);
+    H_TEST_ASSERT(b->Equals(*InheritedConfJSONObject::Parse("temp_conf_b.json")));
+
+    // The cache is not changed by the caller
+    a->Put("host", "changed");
+    a->GetJSONObject("server")->Put("port", "changed");
+    a->GetJSONObject("server")->GetJSONArray("tags")->Put("changed");
+    b->GetJSONObject("server")->Put("host", "MUTATED");
+    JSONObjectPtr a2 = loader.Load("temp_conf_a.json");
+    H_TEST_ASSERT(a2->GetString("host") == "a");
+    H_TEST_ASSERT(a2->GetJSONObject("server")->GetInteger("port") == 80);
+    H_TEST_ASSERT(a2->GetJSONObject("server")->GetJSONArray("tags")->size() == 1);
+    H_TEST_ASSERT(a2->GetJSONObject("server") != a->GetJSONObject("server"));
+    H_TEST_ASSERT(!loader.Load("temp_conf_b.json")->GetJSONObject("server")->Get("host"));
+
+    // Rewritten at once with the same size
+    WriteConf("temp_conf_c.json", "{\"port\" : 80}");
+    H_TEST_ASSERT(loader.Load("temp_conf_c.json")->GetInteger("port") == 80);
+    WriteConf("temp_conf_c.json", "{\"port\" : 81}");
+    H_TEST_ASSERT(loader.Load("temp_conf_c.json")->GetInteger("port") == 81);
+    H_TEST_ASSERT(loader.Load("temp_conf_c.json")->GetInteger("port") == 81);
+    simcc::FileUtil::Unlink("temp_conf_c.json");
+    H_TEST_ASSERT(!loader.Load("temp_conf_c.json"));
+
+    // Reloaded when the base is changed
+    WriteConf("temp_conf_base.json", "{\"host\" : \"base2\", \"server\" : {\"port\" : 8080}}");
+    JSONObjectPtr b2 = loader.Load("temp_conf_b.json");
+    H_TEST_ASSERT(b2->GetString("host") == "base2");
+    H_TEST_ASSERT(b2->GetJSONObject("server")->GetInteger("port") == 81);
+    H_TEST_ASSERT(!b2->GetJSONObject("server")->GetJSONArray("tags"));
+    H_TEST_ASSERT(loader.Load("temp_conf_a.json")->GetJSONObject("server")->GetInteger("port") == 8080);
+
+    // An inheritance loop or a removed file
+    WriteConf("temp_conf_base.json", "{\"inherited_from\" : \"temp_conf_a.json\", \"host\" : \"loop\"}");
+    JSONObjectPtr a3 = loader.Load("temp_conf_a.json");
+    H_TEST_ASSERT(a3 && a3->GetString("host") == "a");
+    simcc::FileUtil::Unlink("temp_conf_a.json");
+    H_TEST_ASSERT(!loader.Load("temp_conf_a.json"));
+    H_TEST_ASSERT(loader.size() == 2);
+
+    simcc::FileUtil::Unlink("temp_conf_b.json");
+    simcc::FileUtil::Unlink("temp_conf_base.json");
+    loader.Clear();
+    H_TEST_ASSERT(loader.size() == 0);
+}
@@ -0,0 +1,84 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+
+TEST_UNIT(testJSONArrayBulkPut) {
+    const simcc::uint32 kCount = 10000;
+    std::vector<simcc::int64> i64(kCount);
+    std::vector<simcc::float64> f64(kCount);
+    std::vector<simcc::int32> i32(kCount);
+    for (simcc::uint32 i = 0; i < kCount; ++i) {
+        i64[i] = (simcc::int64)i * 1000000007LL;
+        f64[i] = i + 0.5;
+        i32[i] = -(simcc::int32)i;
+    }
+
+    simcc::json::JSONArrayPtr jap(new simcc::json::JSONArray);
+    simcc::json::JSONArray& ja = *jap;
+    ja.reserve(kCount * 3);
+    ja.PutInt64Array(&i64[0], kCount)->PutFloat64Array(&f64[0], kCount)->PutInt32Array(&i32[0], kCount);
+    H_TEST_ASSERT(ja.size() == kCount * 3);
+
+    // Random access
+    for (simcc::uint32 i = 0; i < kCount; ++i) {
+        H_TEST_ASSERT(ja.GetInteger(i) == i64[i]);
+        H_TEST_ASSERT(ja.GetDouble(kCount + i) == f64[i]);
+        H_TEST_ASSERT(ja.GetInteger(kCount * 2 + i) == i32[i]);
+    }
+    H_TEST_ASSERT(ja.Get(kCount * 3) == NULL);
+    H_TEST_ASSERT(ja.Get(-1) == NULL);
+
+    std::vector<simcc::int64> out;
+    ja.GetInt64Array(out);
+    H_TEST_ASSERT(out.size() == kCount * 3);
+    H_TEST_ASSERT(std::equal(i64.begin(), i64.end(), out.begin()));
+
+    H_TEST_ASSERT(ja.Remove(0));
+    H_TEST_ASSERT(ja.size() == kCount * 3 - 1);
+    H_TEST_ASSERT(ja.GetInteger(0) == i64[1]);
+    H_TEST_ASSERT(!ja.Remove(kCount * 3));
+
+    const bool b[] = {true, false, true};
+    const std::string s[] = {"a", "b"};
+    simcc::json::JSONObject jo;
+    jo.Put("a", jap.get());
+    jo.PutBoolArray("b", b, 3);
+    jo.PutStringArray("s", s, 2);
+    H_TEST_ASSERT(jo.GetJSONArray("b")->GetBool(2));
+    H_TEST_ASSERT(jo.GetJSONArray("s")->GetString(1) == "b");
+
+    // Serialize and deserialize
+    simcc::DataStream ds;
+    ds << jo;
+    simcc::json::JSONObject jo2;
+    ds >> jo2;
+    H_TEST_ASSERT(jo.Equals(jo2));
+}
+
+TEST_UNIT(testJSONParseErrorState) {
+    simcc::json::JSONArray ja;
+    H_TEST_ASSERT(ja.ok());
+
+    // The error of a nested value is reported at its own location
+    const char* bad = "[1, {\"a\" 2}]";
+    H_TEST_ASSERT(!ja.Parse(bad));
+    H_TEST_ASSERT(ja.error() == simcc::json::JSONParser::kKeyValueSeperatorError);
+    H_TEST_ASSERT(bad[ja.error_location()] == '2');
+    H_TEST_ASSERT(strcmp(ja.strerror(), "kKeyValueSeperatorError") == 0);
+
+    // A successful parsing clears the error
+    simcc::json::JSONArray ja2;
+    H_TEST_ASSERT(ja2.Parse("[1, {\"a\" : [2]}]"));
+    H_TEST_ASSERT(ja2.ok());
+    H_TEST_ASSERT(strcmp(ja2.strerror(), "kNoError") == 0);
+    H_TEST_ASSERT(!ja2.Parse("[]", 0));
+    H_TEST_ASSERT(ja2.error() == simcc::json::JSONParser::kParameterWrong);
+    simcc::json::JSONArray::ErrorCode ec = ja2.error();
+    H_TEST_ASSERT(ec == simcc::json::JSONArray::kParameterWrong);
+
+    simcc::json::JSONObject jo;
+    H_TEST_ASSERT(!jo.Parse("{\"a\":[1, 2}"));
+    H_TEST_ASSERT(jo.error() == simcc::json::JSONParser::kJSONArrayNotEndWithBrackets);
+    H_TEST_ASSERT(jo.Parse("{\"a\":[1, 2]}"));
+    H_TEST_ASSERT(jo.ok());
+    H_TEST_ASSERT(jo.error_location() == 0);
+}
@@ -0,0 +1,160 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+
+namespace rpc {
+struct Server {
+    std::string host;
+    simcc::uint16 port;
+    std::vector<std::string> tags;
+
+    Server() : port(0) {}
+};
+H_JSON_BIND(Server, H_JSON_FIELD(host), H_JSON_FIELD(port), H_JSON_FIELD(tags))
+
+struct Config {
+    simcc::int64 id;
+    std::string name;
+    double ratio;
+    bool enabled;
+    int retries;
+    Server master;
+    std::vector<Server> slaves;
+    std::vector<bool> flags;
+    std::map<std::string, int> limits;
+
+    Config() : id(0), ratio(0), enabled(false), retries(3) {}
+};
+H_JSON_BIND(Config,
+            H_JSON_FIELD(id),
+            H_JSON_FIELD_AS("user_name", name),
+            H_JSON_FIELD(ratio),
+            H_JSON_FIELD(enabled),
+            H_JSON_FIELD(retries),
+            H_JSON_FIELD(master),
+            H_JSON_FIELD(slaves),
+            H_JSON_FIELD(flags),
+            H_JSON_FIELD(limits))
+}
+
+TEST_UNIT(testJSONBinder) {
+    using namespace simcc::json;
+    const char* json =
+        "{\n"
+        "    // The members are in any order, and the unknown ones are skipped\n"
+        "    \"user_name\" : \"simcc\\u4e2d\", \"id\" : 9223372036854775807,\n"
+        "    \"unknown\" : { \"a\" : [1, {\"b\" : \"}]\"}], \"c\" : null },\n"
+        "    \"ratio\" : 1, \"enabled\" : true, \"retries\" : null,\n"
+        "    \"master\" : { \"host\" : '127.0.0.1', \"port\" : 8080, \"tags\" : [\"a\", \"b\",] },\n"
+        "    \"slaves\" : [ {\"port\" : 1}, {\"host\" : \"h2\"} ],\n"
+        "    \"flags\" : [true, false, , true],\n"
+        "    \"limits\" : { \"qps\" : 100, \"conn\" : -1 },\n"
+        "}";
+    rpc::Config c;
+    JSONBinder b;
+    H_TEST_ASSERT(b.Parse(json, strlen(json), c) == strlen(json));
+    H_TEST_ASSERT(b.ok());
+    H_TEST_ASSERT(c.id == 9223372036854775807LL);
+    H_TEST_ASSERT(c.name == "simcc\xe4\xb8\xad");
+    H_TEST_ASSERT(c.ratio == 1.0);
+    H_TEST_ASSERT(c.enabled);
+    H_TEST_ASSERT(c.retries == 3); // null keeps the value
+    H_TEST_ASSERT(c.master.host == "127.0.0.1");
+    H_TEST_ASSERT(c.master.port == 8080);
+    H_TEST_ASSERT(c.master.tags.size() == 2 && c.master.tags[1] == "b");
+    H_TEST_ASSERT(c.slaves.size() == 2);
+    H_TEST_ASSERT(c.slaves[0].host.empty() && c.slaves[0].port == 1);
+    H_TEST_ASSERT(c.slaves[1].host == "h2" && c.slaves[1].port == 0);
+    H_TEST_ASSERT(c.flags.size() == 4 && c.flags[0] && !c.flags[1] && !c.flags[2] && c.flags[3]);
+    H_TEST_ASSERT(c.limits.size() == 2 && c.limits["qps"] == 100 && c.limits["conn"] == -1);
+
+    // The same text as the DOM, except the order of the members
+    std::string s = JSONBinder::ToString(c);
+    H_TEST_ASSERT(s.find("{\"id\":9223372036854775807,\"user_name\":\"simcc\\u4e2d\",") == 0);
+    JSONObject expected;
+    H_TEST_ASSERT(expected.Parse(
+                      "{\"id\" : 9223372036854775807, \"user_name\" : \"simcc\xe4\xb8\xad\", \"ratio\" : 1.0,"
+                      " \"enabled\" : true, \"retries\" : 3,"
+                      " \"master\" : {\"host\" : \"127.0.0.1\", \"port\" : 8080, \"tags\" : [\"a\", \"b\"]},"
+                      " \"slaves\" : [{\"host\" : \"\", \"port\" : 1, \"tags\" : []}, {\"host\" : \"h2\", \"port\" : 0, \"tags\" : []}],"
+                      " \"flags\" : [true, false, false, true], \"limits\" : {\"conn\" : -1, \"qps\" : 100}}"));
+    JSONObject actual;
+    H_TEST_ASSERT(actual.Parse(s));
+    H_TEST_ASSERT(actual.Equals(expected));
+    H_TEST_ASSERT(JSONBinder::ToString(c, false).find("\"simcc\xe4\xb8\xad\"") != std::string::npos);
+
+    // Parsed back
+    rpc::Config c2;
+    H_TEST_ASSERT(b.Parse(s.data(), s.size(), c2) == s.size());
+    H_TEST_ASSERT(JSONBinder::ToString(c2) == s);
+
+    // Appended to a DataStream
+    simcc::DataStream ds;
+    ds.Write("[", 1);
+    JSONBinder::Serialize(c.master, ds);
+    H_TEST_ASSERT(std::string(ds.data(), ds.size()) == "[{\"host\":\"127.0.0.1\",\"port\":8080,\"tags\":[\"a\",\"b\"]}");
+
+    // Any type as the root
+    std::vector<int> v;
+    H_TEST_ASSERT(b.Parse("[1; 2; 3]", 9, v) && v.size() == 3 && v[2] == 3);
+    H_TEST_ASSERT(JSONBinder::ToString(v) == "[1,2,3]");
+    std::vector<double> d(2, 0.5);
+    d.push_back(std::numeric_limits<double>::infinity());
+    H_TEST_ASSERT(JSONBinder::ToString(d) == "[0.5,0.5,null]");
+    std::vector<simcc::uint64> u(1, 18446744073709551615ULL);
+    u.push_back(9223372036854775808ULL);
+    u.push_back(0);
+    H_TEST_ASSERT(JSONBinder::ToString(u) == "[18446744073709551615,9223372036854775808,0]");
+
+    // The unsigned integers above INT64_MAX are parsed back
+    std::string us = JSONBinder::ToString(u);
+    std::vector<simcc::uint64> u2;
+    H_TEST_ASSERT(b.Parse(us.data(), us.size(), u2) == us.size() && u2 == u);
+    std::vector<simcc::int64> i64;
+    H_TEST_ASSERT(!b.Parse(us.data(), us.size(), i64) && b.error() == JSONParser::kTypeMismatch);
+    std::vector<simcc::uint32> u32;
+    H_TEST_ASSERT(!b.Parse(us.data(), us.size(), u32) && b.error() == JSONParser::kTypeMismatch);
+    const char* overflow = "[18446744073709551616]";
+    H_TEST_ASSERT(!b.Parse(overflow, strlen(overflow), u2) && b.error() == JSONParser::kTypeMismatch);
+}
+
+TEST_UNIT(testJSONBinderError) {
+    using namespace simcc::json;
+    struct Case {
+        const char* json;
+        JSONParser::ErrorCode error;
+    } cases[] = {
+        { "{\"id\" : \"1\"}", JSONParser::kTypeMismatch },
+        { "{\"id\" : 1.5}", JSONParser::kTypeMismatch },
+        { "{\"user_name\" : 1}", JSONParser::kTypeMismatch },
+        { "{\"enabled\" : 1}", JSONParser::kTypeMismatch },
+        { "{\"master\" : []}", JSONParser::kTypeMismatch },
+        { "{\"master\" : {\"port\" : 65536}}", JSONParser::kTypeMismatch },
+        { "{\"master\" : {\"port\" : -1}}", JSONParser::kTypeMismatch },
+        { "{\"slaves\" : {}}", JSONParser::kTypeMismatch },
+        { "{\"limits\" : {\"a\" : true}}", JSONParser::kTypeMismatch },
+        { "{\"retries\" : 2147483648}", JSONParser::kTypeMismatch },
+        { "[]", JSONParser::kTypeMismatch },
+        { "{\"id\" : 1", JSONParser::kJSONObjectNotEndWithBraces },
+        { "{\"id\" 1}", JSONParser::kKeyValueSeperatorError },
+        { "{\"id\" : 1 \"ratio\" : 1}", JSONParser::kInvalidCharacter },
+        { "{\"id\" : }", JSONParser::kBlankValue },
+        { "{\"flags\" : [true \"a\"]}", JSONParser::kJSONArrayNotEndWithBrackets },
+        { "{\"flags\" : [true, false", JSONParser::kJSONArrayNotEndWithBrackets },
+        { "{\"unknown\" : [1}", JSONParser::kInvalidCharacter },
+        { "{\"user_name\" : \"abc", JSONParser::kJSONStringNotQuoted },
+        { "{/* abc", JSONParser::kCommentFormatError },
+    };
+
+    for (size_t i = 0; i < H_ARRAYSIZE(cases); ++i) {
+        rpc::Config c;
+        JSONBinder b;
+        H_TEST_ASSERT(b.Parse(cases[i].json, strlen(cases[i].json), c) == 0);
+        H_TEST_ASSERT(b.error() == cases[i].error);
+    }
+
+    rpc::Config c;
+    JSONBinder b;
+    H_TEST_ASSERT(b.Parse(NULL, 0, c) == 0);
+    H_TEST_ASSERT(b.error() == JSONParser::kParameterWrong);
+    H_TEST_ASSERT(b.Parse("null", 4, c) == 4);
+}
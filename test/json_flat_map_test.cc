@@ -0,0 +1,109 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+#include "simcc/json/json_flat_map.h"
+
+TEST_UNIT(testJSONFlatMap) {
+    typedef simcc::json::FlatMap<std::string, int> Map;
+    Map m;
+    H_TEST_ASSERT(m.empty());
+    H_TEST_ASSERT(m.find("a") == m.end());
+
+    // Crosses the linear probe limit, so both lookup paths are covered
+    const int kCount = 300;
+    for (int i = 0; i < kCount; ++i) {
+        m[std::to_string(i)] = i;
+        H_TEST_ASSERT(m.size() == (size_t)i + 1);
+        for (int j = 0; j <= i; j += 7) {
+            std::string key = std::to_string(j);
+            Map::iterator it = m.find(key);
+            H_TEST_ASSERT(it != m.end() && it->second == j);
+            Map::iterator it2 = m.find_by_hash(std::hash<std::string>()(key), [&key](const std::string& k) { return k == key; });
+            H_TEST_ASSERT(it2 == it);
+        }
+    }
+
+    H_TEST_ASSERT(!m.insert(Map::value_type("10", 100)).second);
+    H_TEST_ASSERT(m["10"] == 10);
+    H_TEST_ASSERT(m.count("300") == 0);
+
+    // Insertion order is kept
+    int n = 0;
+    for (Map::const_iterator it = m.begin(); it != m.end(); ++it, ++n) {
+        H_TEST_ASSERT(it->second == n);
+    }
+
+    // Erase from the middle and the hash index is still right
+    H_TEST_ASSERT(m.erase("5") == 1);
+    H_TEST_ASSERT(m.erase("5") == 0);
+    H_TEST_ASSERT(m.size() == kCount - 1);
+    for (int i = 0; i < kCount; ++i) {
+        Map::iterator it = m.find(std::to_string(i));
+        if (i == 5) {
+            H_TEST_ASSERT(it == m.end());
+        } else {
+            H_TEST_ASSERT(it != m.end() && it->second == i);
+        }
+    }
+
+    // Erase until it goes back to a linear searched map
+    for (Map::iterator it = m.begin(); it != m.end();) {
+        if (it->second % 50 != 0) {
+            it = m.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    H_TEST_ASSERT(m.size() == 6);
+    H_TEST_ASSERT(m.find("250")->second == 250);
+    H_TEST_ASSERT(m.find("251") == m.end());
+
+    Map r;
+    r.reserve(100);
+    r["x"] = 1;
+    H_TEST_ASSERT(r.find("x")->second == 1);
+    r.swap(m);
+    H_TEST_ASSERT(m.size() == 1 && r.size() == 6);
+    m.clear();
+    H_TEST_ASSERT(m.empty() && m.find("x") == m.end());
+}
+
+TEST_UNIT(testJSONObjectManyKeys) {
+    simcc::json::JSONObject jo;
+    const int kCount = 256;
+    for (int i = 0; i < kCount; ++i) {
+        jo.Put("key" + std::to_string(i), (simcc::int64)i);
+    }
+    H_TEST_ASSERT(jo.size() == kCount);
+    for (int i = 0; i < kCount; ++i) {
+        H_TEST_ASSERT(jo.GetInteger("key" + std::to_string(i), -1) == i);
+    }
+    H_TEST_ASSERT(jo.Get("key256") == NULL);
+
+    // Override an existing key
+    jo.Put("key7", "seven");
+    H_TEST_ASSERT(jo.size() == kCount);
+    H_TEST_ASSERT(jo.GetString("key7") == "seven");
+
+    // Equals does not depend on the order of the keys
+    simcc::json::JSONObject jo2;
+    for (int i = kCount - 1; i >= 0; --i) {
+        if (i == 7) {
+            jo2.Put("key7", "seven");
+        } else {
+            jo2.Put("key" + std::to_string(i), (simcc::int64)i);
+        }
+    }
+    H_TEST_ASSERT(jo.Equals(jo2));
+
+    simcc::json::ObjectPtr o = simcc::json::JSONParser::Load(jo.ToString().data(), jo.ToString().size());
+    H_TEST_ASSERT(o && o->Equals(jo));
+
+    simcc::json::Object* v = jo.Get("key100");
+    jo.Remove(v);
+    jo.Remove("key200");
+    H_TEST_ASSERT(jo.size() == kCount - 2);
+    H_TEST_ASSERT(jo.Get("key100") == NULL);
+    H_TEST_ASSERT(jo.Get("key200") == NULL);
+    H_TEST_ASSERT(jo.GetInteger("key255") == 255);
+    H_TEST_ASSERT(!jo.Equals(jo2));
+}
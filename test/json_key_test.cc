@@ -0,0 +1,120 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+
+#include <atomic>
+#include <thread>
+
+TEST_UNIT(testJSONKey) {
+    using simcc::json::JSONKey;
+    size_t n = JSONKey::table_size();
+    {
+        JSONKey a("json_key_test_a");
+        JSONKey b(std::string("json_key_test_a"));
+        JSONKey c("json_key_test_c", 15);
+        H_TEST_ASSERT(JSONKey::table_size() == n + 2);
+
+        // The same text shares one buffer
+        H_TEST_ASSERT(a == b);
+        H_TEST_ASSERT(a.data() == b.data());
+        H_TEST_ASSERT(a != c);
+        H_TEST_ASSERT(a < c && !(c < a) && !(a < b));
+        H_TEST_ASSERT(a == "json_key_test_a");
+        H_TEST_ASSERT(std::string("json_key_test_c") == c);
+        H_TEST_ASSERT(a.hash() == JSONKey::Hash("json_key_test_a", 15));
+
+        JSONKey f;
+        H_TEST_ASSERT(JSONKey::Find("json_key_test_c", 15, f));
+        H_TEST_ASSERT(f == c);
+        H_TEST_ASSERT(!JSONKey::Find("json_key_test_x", 15, f));
+
+        // The empty key
+        JSONKey e("");
+        H_TEST_ASSERT(e.empty() && e == JSONKey() && e.str().empty());
+
+        JSONKey moved(std::move(a));
+        H_TEST_ASSERT(moved == b && a.empty());
+        a = c;
+        H_TEST_ASSERT(a == c);
+    }
+
+    // Removed with the last reference
+    H_TEST_ASSERT(JSONKey::table_size() == n);
+}
+
+TEST_UNIT(testJSONKeyThreads) {
+    using simcc::json::JSONKey;
+    size_t n = JSONKey::table_size();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.push_back(std::thread([]() {
+            for (int i = 0; i < 20000; ++i) {
+                // Keys are created and released all the time
+                std::string s = "json_key_thread_" + std::to_string(i % 16);
+                JSONKey k1(s);
+                JSONKey k2(s);
+                H_TEST_ASSERT(k1 == k2);
+                H_TEST_ASSERT(k1.str() == s);
+            }
+        }));
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    H_TEST_ASSERT(JSONKey::table_size() == n);
+}
+
+#ifdef H_JSON_INTERNED_KEY
+TEST_UNIT(testJSONObjectInternedKey) {
+    simcc::json::JSONObject jo1, jo2;
+    H_TEST_ASSERT(jo1.Parse("{\"name\":\"a\", \"age\":1}"));
+    H_TEST_ASSERT(jo2.Parse("{\"name\":\"b\", \"age\":2}"));
+
+    // The same key of the two objects is stored once
+    H_TEST_ASSERT(jo1.begin()->first.data() == jo2.begin()->first.data());
+    H_TEST_ASSERT(jo1.GetString("name") == "a");
+    H_TEST_ASSERT(jo2.GetInteger("age") == 2);
+    H_TEST_ASSERT(jo1.Get("unknown_key_of_json_key_test") == NULL);
+
+    simcc::json::JSONKey name("name");
+    H_TEST_ASSERT(jo2.Get(name) == jo2.GetJSONString("name"));
+
+    jo1.Put("name", "c");
+    H_TEST_ASSERT(jo1.GetString("name") == "c");
+    jo1.Remove("name");
+    H_TEST_ASSERT(jo1.Get(name) == NULL);
+    H_TEST_ASSERT(jo1.size() == 1);
+}
+
+TEST_UNIT(testJSONObjectInternedKeyLookup) {
+    // Big enough to be hashed by FlatMap
+    simcc::json::JSONObject jo;
+    for (int i = 0; i < 20; ++i) {
+        jo.Put("json_key_lookup_" + std::to_string(i), simcc::int64(i));
+    }
+    jo.Put("", simcc::int64(100));
+
+    // The objects are looked up by text concurrently
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.push_back(std::thread([&jo, &failures]() {
+            const simcc::json::JSONObject& cjo = jo;
+            for (int i = 0; i < 20000; ++i) {
+                if (cjo.GetInteger("json_key_lookup_" + std::to_string(i % 20)) != i % 20
+                        || cjo.GetInteger("") != 100
+                        || cjo.Get("json_key_lookup_x") != NULL) {
+                    failures++;
+                }
+            }
+        }));
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    H_TEST_ASSERT(failures == 0);
+}
+#endif
@@ -0,0 +1,93 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+
+TEST_UNIT(testJSONLazyDocument) {
+    using namespace simcc::json;
+    const char* json =
+        "/* a request */ {\n"
+        "    \"user\" : { \"id\" : \"u\\\"1\", \"age\" : 18, \"vip\" : true },\n"
+        "    \"ts\" : 1476748800 ,\n"
+        "    \"ratio\" : 0.25,\n"
+        "    \"tags\" : [ \"a\", [1, 2], { \"k\" : \"}]\" }, , null ],\n"
+        "    \"k\\u0065y\" : 'single'\n"
+        "}";
+    JSONLazyDocument doc;
+    H_TEST_ASSERT(doc.Parse(json) == strlen(json));
+    H_TEST_ASSERT(doc.ok());
+    H_TEST_ASSERT(doc.root().type() == kJSONObject);
+    H_TEST_ASSERT(doc.root().size() == 5);
+
+    JSONLazyValue user = doc.Get("user");
+    H_TEST_ASSERT(user.valid() && user.type() == kJSONObject);
+    H_TEST_ASSERT(user.Get("id").GetString() == "u\"1");
+    H_TEST_ASSERT(user.Get("age").GetInteger() == 18);
+    H_TEST_ASSERT(user.Get("age").type() == kJSONInteger);
+    H_TEST_ASSERT(user.Get("vip").GetBool());
+    H_TEST_ASSERT(doc.Get("ts").GetInteger() == 1476748800);
+    H_TEST_ASSERT(doc.Get("ts").raw() == "1476748800");
+    H_TEST_ASSERT(doc.Get("ratio").type() == kJSONDouble);
+    H_TEST_ASSERT(doc.Get("ratio").GetDecimal() > 0.24 && doc.Get("ratio").GetDecimal() < 0.26);
+    H_TEST_ASSERT(doc.Get("key").GetString() == "single"); // The escaped key is decoded
+
+    // The wrong types and the missing values
+    H_TEST_ASSERT(doc.Get("ts").GetString("x") == "x");
+    H_TEST_ASSERT(user.Get("id").GetInteger(-1) == -1);
+    H_TEST_ASSERT(!doc.Get("unknown").valid());
+    H_TEST_ASSERT(!doc.Get("unknown").Get("id").valid());
+    H_TEST_ASSERT(!doc.Get("ts").Get("id").valid());
+    H_TEST_ASSERT(!doc.Get(size_t(0)).valid());
+
+    JSONLazyValue tags = doc.Get("tags");
+    H_TEST_ASSERT(tags.type() == kJSONArray);
+    H_TEST_ASSERT(tags.size() == 5);
+    H_TEST_ASSERT(tags.Get(0).GetString() == "a");
+    H_TEST_ASSERT(tags.Get(1).Get(1).GetInteger() == 2);
+    H_TEST_ASSERT(tags.Get(2).Get("k").GetString() == "}]");
+    H_TEST_ASSERT(tags.Get(3).type() == kJSONNull); // A blank element
+    H_TEST_ASSERT(tags.Get(4).type() == kJSONNull);
+    H_TEST_ASSERT(!tags.Get(5).valid());
+    H_TEST_ASSERT(doc.ok());
+
+    // Materialize a subtree, which is the same as parsing it all
+    JSONObject jo;
+    H_TEST_ASSERT(jo.Parse(json));
+    ObjectPtr o = tags.Materialize();
+    H_TEST_ASSERT(o && o->type() == kJSONArray);
+    H_TEST_ASSERT(o->Equals(*jo.GetJSONArray("tags")));
+    o = doc.root().Materialize();
+    H_TEST_ASSERT(o && o->Equals(jo));
+    H_TEST_ASSERT(tags.Get(3).Materialize()->type() == kJSONNull);
+}
+
+TEST_UNIT(testJSONLazyDocumentError) {
+    using namespace simcc::json;
+    const char* bad[] = {
+        "",
+        "123",
+        "{\"a\":[1, 2}",
+        "{\"a\":\"abc}",
+        "[1, 2]]", // The rest is not parsed, the same as JSONObject::Parse
+    };
+
+    JSONLazyDocument doc;
+    for (size_t i = 0; i < H_ARRAYSIZE(bad) - 1; ++i) {
+        H_TEST_ASSERT(doc.Parse(bad[i], strlen(bad[i])) == 0);
+        H_TEST_ASSERT(!doc.ok());
+        H_TEST_ASSERT(!doc.root().valid());
+    }
+    H_TEST_ASSERT(doc.Parse(bad[4]) == 6);
+
+    // The structure is right, but the syntax error is found when it is accessed
+    const char* json = "{\"a\":{\"b\" 1}, \"c\":2, \"d\":[1 : 2], \"e\":0x1G}";
+    H_TEST_ASSERT(doc.Parse(json) == strlen(json));
+    H_TEST_ASSERT(doc.Get("c").GetInteger() == 2);
+    H_TEST_ASSERT(doc.ok());
+    H_TEST_ASSERT(!doc.Get("a").Get("b").valid());
+    H_TEST_ASSERT(doc.error() == JSONParser::kKeyValueSeperatorError);
+    H_TEST_ASSERT(doc.error_location() == 10);
+    H_TEST_ASSERT(doc.Get("d").size() == 0);
+    H_TEST_ASSERT(doc.error() == JSONParser::kJSONArrayNotEndWithBrackets);
+    H_TEST_ASSERT(!doc.Get("a").Materialize());
+    H_TEST_ASSERT(doc.Get("e").GetInteger(-1) == -1);
+    H_TEST_ASSERT(doc.error() == JSONParser::kInvalidHexadecimalCharacter);
+}
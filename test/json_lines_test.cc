@@ -0,0 +1,87 @@
+#include "test_common.h"
+#include "simcc/data_stream.h"
+#include "simcc/file_util.h"
+#include "simcc/json/json.h"
+
+#include <atomic>
+
+namespace {
+std::string MakeLines(size_t count) {
+    std::string s;
+    for (size_t i = 0; i < count; ++i) {
+        s += "{\"id\":" + std::to_string(i) + ", \"name\":\"record " + std::to_string(i) + "\", \"tags\":[1, 2, 3]}\n";
+        if (i % 7 == 0) {
+            s += "  \r\n"; // A blank line
+        }
+    }
+    return s;
+}
+}
+
+TEST_UNIT(testJSONLinesLoader) {
+    using namespace simcc::json;
+
+    // Big enough to be parsed by several threads
+    const size_t kCount = 20000;
+    std::string text = MakeLines(kCount);
+    for (size_t threads = 1; threads <= 4; ++threads) {
+        JSONLinesLoader loader(threads);
+        std::vector<ObjectPtr> records;
+        H_TEST_ASSERT(loader.Load(text.data(), text.size(), records));
+        H_TEST_ASSERT(records.size() == kCount);
+        for (size_t i = 0; i < records.size(); ++i) {
+            JSONObject* jo = static_cast<JSONObject*>(records[i].get());
+            H_TEST_ASSERT(jo->GetInteger("id") == static_cast<simcc::int64>(i));
+        }
+
+        // The handler runs on the worker threads, so the failures are
+        // counted there and checked after Load returns
+        std::atomic<size_t> count(0);
+        std::atomic<size_t> failures(0);
+        std::atomic<simcc::int64> sum(0);
+        auto handler = [&](const ObjectPtr& o, const simcc::Slice& line) {
+            if (!o || line.size() == 0 || line[line.size() - 1] != '}') {
+                failures++;
+                return;
+            }
+            count++;
+            sum += static_cast<JSONObject*>(o.get())->GetInteger("id");
+        };
+        bool ok = loader.Load(text.data(), text.size(), handler);
+        H_TEST_ASSERT(ok);
+        H_TEST_ASSERT(failures == 0);
+        H_TEST_ASSERT(count == kCount);
+        H_TEST_ASSERT(sum == static_cast<simcc::int64>(kCount * (kCount - 1) / 2));
+    }
+
+    // From a file
+    std::string path = "temp_json_lines.json";
+    simcc::DataStream ds;
+    ds.Write(text.data(), text.size());
+    H_TEST_ASSERT(ds.WriteFile(path));
+    JSONLinesLoader loader;
+    std::vector<ObjectPtr> records;
+    H_TEST_ASSERT(loader.LoadFile(path, records));
+    simcc::FileUtil::Unlink(path);
+    H_TEST_ASSERT(records.size() == kCount);
+    H_TEST_ASSERT(static_cast<JSONObject*>(records.back().get())->GetInteger("id") == kCount - 1);
+    H_TEST_ASSERT(!loader.LoadFile("temp_json_lines.not_exist", records));
+}
+
+TEST_UNIT(testJSONLinesLoaderError) {
+    using namespace simcc::json;
+    std::string text = "[1]\n\n{\"a\":1}\n{\"a\":\n[2]\n{bad}";
+    JSONLinesLoader loader(2);
+    std::vector<ObjectPtr> records;
+    H_TEST_ASSERT(!loader.Load(text.data(), text.size(), records));
+    H_TEST_ASSERT(records.size() == 5);
+    H_TEST_ASSERT(records[0] && records[1] && !records[2] && records[3] && !records[4]);
+    H_TEST_ASSERT(loader.failed_count() == 2);
+    H_TEST_ASSERT(loader.first_failed_line() == 4);
+
+    // The error is cleared by the next loading
+    H_TEST_ASSERT(loader.Load(text.data(), 3, records));
+    H_TEST_ASSERT(loader.failed_count() == 0 && loader.first_failed_line() == 0);
+    H_TEST_ASSERT(loader.Load("", 0, records));
+    H_TEST_ASSERT(records.empty());
+}
@@ -129,3 +129,79 @@ TEST_UNIT(json_merge_test4) {
 
 
 
+TEST_UNIT(json_merge_copy_on_write) {
+    using namespace simcc::json;
+    JSONObject base;
+    H_TEST_ASSERT(base.Parse("{\"server\" : {\"host\" : \"a\", \"ports\" : [1, 2], \"tls\" : {\"on\" : false}}, \"list\" : [1]}"));
+    std::string base_text = base.ToString();
+
+    // The values of base are shared
+    JSONObject child;
+    child.Merge(&base, false);
+    H_TEST_ASSERT(child.GetJSONObject("server") == base.GetJSONObject("server"));
+    H_TEST_ASSERT(child.GetJSONArray("list") == base.GetJSONArray("list"));
+    H_TEST_ASSERT(child.GetJSONObject("server")->shared());
+
+    // A shared object is copied before it is merged into
+    JSONObject patch;
+    H_TEST_ASSERT(patch.Parse("{\"server\" : {\"host\" : \"b\", \"tls\" : {\"on\" : true}}}"));
+    child.Merge(&patch, true);
+    H_TEST_ASSERT(base.ToString() == base_text);
+    JSONObject* server = child.GetJSONObject("server");
+    H_TEST_ASSERT(server != base.GetJSONObject("server"));
+    H_TEST_ASSERT(server->GetString("host") == "b");
+    H_TEST_ASSERT(server->GetJSONObject("tls")->GetBool("on"));
+    H_TEST_ASSERT(server->GetJSONArray("ports") == base.GetJSONObject("server")->GetJSONArray("ports"));
+
+    // Copied when it is modified
+    JSONObject* tls = server->GetMutableJSONObject("tls");
+    H_TEST_ASSERT(tls == server->GetJSONObject("tls")); // Not shared
+    JSONArray* ports = server->GetMutableJSONArray("ports");
+    H_TEST_ASSERT(ports != base.GetJSONObject("server")->GetJSONArray("ports"));
+    ports->Put((simcc::int64)3);
+    child.GetMutableJSONArray("list")->Put((simcc::int64)2);
+    H_TEST_ASSERT(base.ToString() == base_text);
+    H_TEST_ASSERT(ports->size() == 3 && child.GetJSONArray("list")->size() == 2);
+    H_TEST_ASSERT(child.GetMutableJSONObject("list") == NULL);
+    H_TEST_ASSERT(child.GetMutableJSONArray("unknown") == NULL);
+}
+
+TEST_UNIT(json_merge_copy_on_write_shared_value) {
+    using namespace simcc::json;
+    JSONObject b;
+    H_TEST_ASSERT(b.Parse("{\"s\" : {\"x\" : 1, \"a\" : [{\"k\" : \"v\"}]}}"));
+    std::string b_text = b.ToString();
+
+    // The ordinary getters return the value shared with b
+    JSONObject c;
+    c.Merge(&b, false);
+    H_TEST_ASSERT(c.GetJSONObject("s") == b.GetJSONObject("s"));
+
+    // The mutable getters copy it, b is not changed
+    JSONObject* s = c.GetMutableJSONObject("s");
+    H_TEST_ASSERT(s != b.GetJSONObject("s"));
+    s->Put("z", (simcc::int64)3);
+    s->GetMutableJSONArray("a")->Put("w");
+    H_TEST_ASSERT(b.ToString() == b_text);
+    H_TEST_ASSERT(s->size() == 3 && s->GetInteger("x") == 1 && s->GetInteger("z") == 3);
+    H_TEST_ASSERT(s->GetJSONArray("a")->ToString() == "[{\"k\":\"v\"},\"w\"]");
+
+    // The copy is made once
+    H_TEST_ASSERT(c.GetMutableJSONObject("s") == s);
+}
+
+TEST_UNIT(json_merge_in_place) {
+    using namespace simcc::json;
+    // An object which is not shared by Merge is merged in place,
+    // the ObjectPtr held by the caller sees the merged keys
+    JSONObject a;
+    H_TEST_ASSERT(a.Parse("{\"s\" : {\"x\" : 1}}"));
+    JSONObject b;
+    H_TEST_ASSERT(b.Parse("{\"s\" : {\"y\" : 2}}"));
+    ObjectPtr held = a.Get("s");
+    a.Merge(&b, true);
+    JSONObject* s = cast<JSONObject>(held);
+    H_TEST_ASSERT(s == a.GetJSONObject("s"));
+    H_TEST_ASSERT(s->size() == 2 && s->GetInteger("x") == 1 && s->GetInteger("y") == 2);
+    H_TEST_ASSERT(b.ToString() == "{\"s\":{\"y\":2}}");
+}
@@ -0,0 +1,81 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+
+TEST_UNIT(testJSONPointer) {
+    using namespace simcc::json;
+    const char* json =
+        "{\n"
+        "    \"user\" : { \"name\" : \"simcc\", \"tags\" : [\"a\", \"b\", {\"k\":1}, , 3] },\n"
+        "    \"a/b\" : 1, \"m~n\" : 2, \"\" : 3, \"10\" : 4,\n"
+        "    \"list\" : ( [1, 2], [3, 4] ) // comment\n"
+        "}";
+    JSONObject jo;
+    H_TEST_ASSERT(jo.Parse(json));
+    JSONLazyDocument doc;
+    H_TEST_ASSERT(doc.Parse(json));
+
+    struct {
+        const char* path;
+        const char* raw; // NULL if not found
+    } cases[] = {
+        { "", json },
+        { "/user/name", "\"simcc\"" },
+        { "/user/tags/0", "\"a\"" },
+        { "/user/tags/2/k", "1" },
+        { "/user/tags/4", "3" },
+        { "/a~1b", "1" },
+        { "/m~0n", "2" },
+        { "/", "3" },
+        { "/10", "4" },
+        { "/list/1/0", "3" },
+        { "/user/tags/5", NULL },
+        { "/user/tags/01", NULL },
+        { "/user/tags/-", NULL },
+        { "/user/name/0", NULL },
+        { "/user/unknown", NULL },
+        { "/unknown/name", NULL },
+    };
+
+    for (size_t i = 0; i < H_ARRAYSIZE(cases); ++i) {
+        JSONPointer p(cases[i].path);
+        H_TEST_ASSERT(p.ok());
+
+        simcc::Slice raw;
+        bool found = p.Find(json, strlen(json), raw);
+        H_TEST_ASSERT(found == (cases[i].raw != NULL));
+        Object* o = p.Find(&jo);
+        H_TEST_ASSERT((o != NULL) == found);
+        JSONLazyValue v = p.Find(doc.root());
+        H_TEST_ASSERT(v.valid() == found);
+        if (!found) {
+            continue;
+        }
+
+        H_TEST_ASSERT(raw == cases[i].raw);
+        H_TEST_ASSERT(v.raw() == raw);
+
+        // The same value as the json object tree
+        JSONObject tmp;
+        std::string s = "{\"v\":" + raw.ToString() + "}";
+        H_TEST_ASSERT(tmp.Parse(s));
+        H_TEST_ASSERT(tmp.Get("v")->Equals(*o));
+    }
+
+    // A blank array element is a null in the tree but it has no text
+    JSONPointer blank("/user/tags/3");
+    H_TEST_ASSERT(blank.Find(&jo)->type() == kJSONNull);
+    simcc::Slice raw;
+    H_TEST_ASSERT(!blank.Find(json, strlen(json), raw));
+
+    // The invalid paths
+    const char* bad[] = { "user", "/a~", "/a~2" };
+    for (size_t i = 0; i < H_ARRAYSIZE(bad); ++i) {
+        JSONPointer p(bad[i]);
+        H_TEST_ASSERT(!p.ok());
+        H_TEST_ASSERT(p.Find(&jo) == NULL);
+    }
+
+    // A syntax error on the path
+    const char* broken = "{\"a\" 1, \"b\":2}";
+    H_TEST_ASSERT(!JSONPointer("/b").Find(broken, strlen(broken), raw));
+}
@@ -0,0 +1,134 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+#include "simcc/qh_palloc.h"
+
+namespace {
+const char* kJSONText = "{\"name\":\"simcc\",\"id\":100,\"score\":0.5,\"ok\":true,\"none\":null,"
+                        "\"tags\":[\"a\",\"b\",,{\"k\":1}],\"sub\":{\"long_string_value\":\"abcdefghijklmnopqrstuvwxyz\"}}";
+}
+
+TEST_UNIT(testJSONParserLoadWithPool) {
+    simcc::qh::Pool pool(4096);
+    simcc::json::ObjectPtr o = simcc::json::JSONParser::Load(kJSONText, -1, &pool);
+    H_TEST_ASSERT(o);
+    H_TEST_ASSERT(o->pooled());
+    simcc::json::JSONObject* jo = simcc::json::cast<simcc::json::JSONObject>(o);
+    H_TEST_ASSERT(jo);
+    H_TEST_ASSERT(jo->GetString("name") == "simcc");
+    H_TEST_ASSERT(jo->GetInteger("id") == 100);
+    H_TEST_ASSERT(jo->GetJSONArray("tags")->size() == 4);
+    H_TEST_ASSERT(jo->GetJSONArray("tags")->Get(0)->pooled());
+    H_TEST_ASSERT(jo->GetJSONObject("sub")->GetString("long_string_value") == "abcdefghijklmnopqrstuvwxyz");
+
+    simcc::json::ObjectPtr heap = simcc::json::JSONParser::Load(kJSONText);
+    H_TEST_ASSERT(!heap->pooled());
+    H_TEST_ASSERT(heap->Equals(*o));
+    H_TEST_ASSERT(heap->ToString() == o->ToString());
+
+    // A heap object can be put into a pooled document
+    jo->Put("heap", heap);
+    H_TEST_ASSERT(jo->GetJSONObject("heap") == heap.get());
+
+    // The pool holds a reference of the document
+    o.SetNull();
+    H_TEST_ASSERT(heap->RefCount() == 2);
+    pool.reset();
+    H_TEST_ASSERT(heap->RefCount() == 1);
+
+    // The pool can be reused after reset
+    for (int i = 0; i < 100; i++) {
+        o = simcc::json::JSONParser::Load(kJSONText, -1, &pool);
+        H_TEST_ASSERT(o && o->Equals(*heap));
+        o.SetNull();
+        pool.reset();
+    }
+}
+
+TEST_UNIT(testJSONParserLoadWithPoolError) {
+    simcc::qh::Pool pool(4096);
+    simcc::json::ObjectPtr o = simcc::json::JSONParser::Load("{\"a\":[1,2,{\"b\":}]}", -1, &pool);
+    H_TEST_ASSERT(!o);
+    o = simcc::json::JSONParser::Load("{\"a\":[1,2,{\"b\":3}]}", -1, &pool);
+    H_TEST_ASSERT(o);
+}
+
+TEST_UNIT(testJSONParserLoadWithPoolAbandon) {
+    // The partial documents are destroyed along with the pool
+    simcc::qh::Pool pool(4096);
+    const char* texts[] = {
+        "{\"a\":[1,2,{\"b\":\"a long string which is not in the small buffer\", \"c\":[{}, [x]]}]}",
+        "[{\"a\":{\"b\":{\"c\":[1, 2, 3, \"abc\"]}}}, [1, 2, 3], {\"d\":",
+    };
+
+    for (int i = 0; i < 100; i++) {
+        for (size_t j = 0; j < H_ARRAYSIZE(texts); j++) {
+            H_TEST_ASSERT(!simcc::json::JSONParser::Load(texts[j], -1, &pool));
+            H_TEST_ASSERT(!simcc::json::JSONParser::Load(texts[j]));
+        }
+        pool.reset();
+    }
+}
+
+TEST_UNIT(testJSONParserLoadWithPoolReuseBigDocument) {
+    // Many more nodes than a block of the pool holds
+    std::string text = "[";
+    for (int i = 0; i < 2000; i++) {
+        text += (i ? "," : "");
+        text += kJSONText;
+    }
+    text += "]";
+
+    simcc::json::ObjectPtr heap = simcc::json::JSONParser::Load(text.data(), text.size());
+    H_TEST_ASSERT(heap);
+
+    simcc::qh::Pool pool(4096);
+    for (int i = 0; i < 5; i++) {
+        simcc::json::ObjectPtr o = simcc::json::JSONParser::Load(text.data(), text.size(), &pool);
+        H_TEST_ASSERT(o && o->Equals(*heap));
+        o.SetNull();
+
+        // The recycled blocks are filled one by one, not walked from the first one
+        size_t behind_current = 0;
+        for (qh_pool_t* p = pool.pool()->current; p; p = p->d.next) {
+            ++behind_current;
+        }
+        H_TEST_ASSERT(behind_current <= 2);
+        pool.reset();
+    }
+}
+
+// The _DEBUG builds of qh_palloc don't allocate through qh_set_alloc
+#ifndef _DEBUG
+namespace {
+void* FailedAlloc(size_t /*size*/) {
+    return NULL;
+}
+}
+
+TEST_UNIT(testJSONParserLoadWithPoolOutOfMemory) {
+    // The first block is used up, then every kind of node in turn is the
+    // one which can't be allocated as the prefix grows
+    const char* value = "{\"a\":[null,,true,1,0.5,\"abc\",{},[]]}";
+    std::string prefix = "[";
+    for (int i = 0; i < 64; i++) {
+        prefix += "0,";
+        std::string text = prefix;
+        for (int j = 0; j < 100; j++) {
+            text += (j ? "," : "");
+            text += value;
+        }
+        text += "]";
+
+        simcc::qh::Pool pool(4096);
+        qh_set_alloc(&FailedAlloc);
+        simcc::json::ObjectPtr o = simcc::json::JSONParser::Load(text.data(), text.size(), &pool);
+        qh_set_alloc(NULL);
+        H_TEST_ASSERT(!o);
+
+        pool.reset();
+        o = simcc::json::JSONParser::Load(text.data(), text.size(), &pool);
+        H_TEST_ASSERT(o);
+        H_TEST_ASSERT(simcc::json::cast<simcc::json::JSONArray>(o)->size() == size_t(i + 101));
+    }
+}
+#endif
@@ -0,0 +1,132 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+
+namespace {
+// Parse the text in the chunks of <code>chunk_size</code> bytes
+simcc::json::ObjectPtr PushParse(const char* text, size_t len, size_t chunk_size) {
+    using namespace simcc::json;
+    JSONDOMBuilder builder;
+    JSONPushParser p(&builder);
+    JSONPushParser::Status st = JSONPushParser::kNeedMoreData;
+    for (size_t i = 0; i < len && st == JSONPushParser::kNeedMoreData; i += chunk_size) {
+        // Copy the chunk, so the parser must not refer to the previous ones
+        std::string chunk(text + i, std::min(chunk_size, len - i));
+        st = p.Feed(chunk.data(), chunk.size());
+    }
+    return p.Finish() == JSONPushParser::kDone ? builder.root() : simcc::json::ObjectPtr();
+}
+}
+
+TEST_UNIT(testJSONPushParser) {
+    using namespace simcc::json;
+    const char* json =
+        "/* a document */ {\n"
+        "    \"name\" : \"simcc\", \"single\" : 'quoted \"string\"',\n"
+        "    \"escape\" : \"\\\"\\\\\\/\\b\\f\\n\\r\\t\\u4e2d\\u6587\",\n"
+        "    \"k\\u0065y\" : -1.5e3, // comment\n"
+        "    \"numbers\" : [0, -12, 3.25, 0x1F, 1 , true, false, null],\n"
+        "    \"blank\" : [,1,,], \"nested\" : [[], {}, [{\"a\":[1]}]],\n"
+        "    \"semicolon\" : [1;2],\n"
+        "}";
+    size_t len = strlen(json);
+    JSONObject jo;
+    H_TEST_ASSERT(jo.Parse(json, len));
+
+    // Every split of the text gives the same document
+    for (size_t chunk_size = 1; chunk_size <= len; ++chunk_size) {
+        ObjectPtr o = PushParse(json, len, chunk_size);
+        H_TEST_ASSERT(o && o->Equals(jo));
+    }
+
+    // Feed returns kDone once the root is completed
+    JSONDOMBuilder builder;
+    JSONPushParser p(&builder);
+    const char* two = "[1, 2] [3]";
+    H_TEST_ASSERT(p.Feed(two, 3) == JSONPushParser::kNeedMoreData);
+    H_TEST_ASSERT(p.Feed(two + 3, strlen(two) - 3) == JSONPushParser::kDone);
+    H_TEST_ASSERT(p.position() == 6);
+    H_TEST_ASSERT(p.Finish() == JSONPushParser::kDone);
+    H_TEST_ASSERT(builder.done());
+    H_TEST_ASSERT(builder.root()->type() == kJSONArray);
+
+    // A new document
+    p.Reset();
+    builder.Reset();
+    H_TEST_ASSERT(p.Feed("{}", 2) == JSONPushParser::kDone);
+    H_TEST_ASSERT(builder.root()->type() == kJSONObject);
+}
+
+TEST_UNIT(testJSONPushParserFile) {
+    const char* path = "../test/test_data/json/browser_relative2.json";
+    simcc::DataStream buf;
+    H_TEST_ASSERT(buf.ReadFile(path));
+    simcc::json::JSONObject jo;
+    H_TEST_ASSERT(jo.Parse(buf.data(), buf.size()));
+
+    size_t sizes[] = { 7, 64, 1000, buf.size() };
+    for (size_t i = 0; i < H_ARRAYSIZE(sizes); ++i) {
+        simcc::json::ObjectPtr o = PushParse(buf.data(), buf.size(), sizes[i]);
+        H_TEST_ASSERT(o && o->Equals(jo));
+    }
+}
+
+TEST_UNIT(testJSONPushParserError) {
+    using namespace simcc::json;
+    struct {
+        const char* json;
+        JSONParser::ErrorCode error;
+    } cases[] = {
+        { "", JSONParser::kInvalidCharacter },
+        { "  123", JSONParser::kInvalidCharacter },
+        { "{\"a\":1", JSONParser::kJSONObjectNotEndWithBraces },
+        { "[1, 2", JSONParser::kJSONArrayNotEndWithBrackets },
+        { "[1, 2}", JSONParser::kJSONArrayNotEndWithBrackets },
+        { "{\"a\" 1}", JSONParser::kKeyValueSeperatorError },
+        { "{a:1}", JSONParser::kInvalidCharacter },
+        { "{\"a\":}", JSONParser::kBlankValue },
+        { "{\"a\":\"abc", JSONParser::kJSONStringNotQuoted },
+        { "{\"a\":\"\\x\"}", JSONParser::kJSONStringNotQuoted },
+        { "{\"a\":\"abc\\\"}", JSONParser::kJSONStringNotQuoted },
+        { "{\"a\":1x}", JSONParser::kInvalidIntegerOrDoubleString },
+        { "{\"a\":1 /* comment", JSONParser::kCommentFormatError },
+        { "{\"a\":1 /x}", JSONParser::kCommentFormatError },
+    };
+
+    for (size_t i = 0; i < H_ARRAYSIZE(cases); ++i) {
+        size_t len = strlen(cases[i].json);
+        for (size_t chunk_size = 1; chunk_size <= len + 1; ++chunk_size) {
+            JSONDOMBuilder builder;
+            JSONPushParser p(&builder);
+            for (size_t j = 0; j < len; j += chunk_size) {
+                p.Feed(cases[i].json + j, std::min(chunk_size, len - j));
+            }
+            H_TEST_ASSERT(p.Finish() == JSONPushParser::kFailed);
+            H_TEST_ASSERT(p.error() == cases[i].error);
+            H_TEST_ASSERT(p.error_location() <= len);
+        }
+
+        // The same as the other parsers
+        JSONObject jo;
+        H_TEST_ASSERT(jo.Parse(cases[i].json, len) == 0);
+    }
+
+    // The error location
+    JSONDOMBuilder builder;
+    JSONPushParser p(&builder);
+    H_TEST_ASSERT(p.Feed("{\"a\":1,", 7) == JSONPushParser::kNeedMoreData);
+    H_TEST_ASSERT(p.Feed(" \"b\" 2}", 7) == JSONPushParser::kFailed);
+    H_TEST_ASSERT(p.error() == JSONParser::kKeyValueSeperatorError);
+    H_TEST_ASSERT(p.error_location() == 12);
+    H_TEST_ASSERT(p.Feed("}", 1) == JSONPushParser::kFailed);
+
+    // Stopped by the handler
+    class StopHandler : public JSONSAXHandler {
+    public:
+        virtual bool Int64(simcc::int64 i) {
+            return i != 2;
+        }
+    } stop;
+    JSONPushParser p2(&stop);
+    H_TEST_ASSERT(p2.Feed("[1, 2, 3]", 9) == JSONPushParser::kFailed);
+    H_TEST_ASSERT(p2.error() == JSONParser::kTerminatedByHandler);
+}
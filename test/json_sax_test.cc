@@ -0,0 +1,198 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+
+namespace {
+
+// Rebuild the json text from the SAX events
+class EchoHandler : public simcc::json::JSONSAXHandler {
+public:
+    virtual bool Null() {
+        Comma();
+        out_ += "null";
+        return true;
+    }
+    virtual bool Bool(bool b) {
+        Comma();
+        out_ += b ? "true" : "false";
+        return true;
+    }
+    virtual bool Int64(simcc::int64 i) {
+        Comma();
+        out_ += std::to_string(i);
+        return true;
+    }
+    virtual bool Double(simcc::float64 d) {
+        Comma();
+        simcc::json::JSONDouble jd(d);
+        out_ += jd.ToString();
+        return true;
+    }
+    virtual bool String(const char* s, size_t len) {
+        Comma();
+        simcc::json::JSONString js(std::string(s, len));
+        out_ += js.ToString();
+        return true;
+    }
+    virtual bool StartObject() {
+        Comma();
+        out_ += "{";
+        need_comma_ = false;
+        return true;
+    }
+    virtual bool Key(const char* s, size_t len) {
+        Comma();
+        simcc::json::JSONString js(std::string(s, len));
+        out_ += js.ToString();
+        out_ += ":";
+        need_comma_ = false;
+        return true;
+    }
+    virtual bool EndObject(size_t /*member_count*/) {
+        out_ += "}";
+        need_comma_ = true;
+        return true;
+    }
+    virtual bool StartArray() {
+        Comma();
+        out_ += "[";
+        need_comma_ = false;
+        return true;
+    }
+    virtual bool EndArray(size_t /*element_count*/) {
+        out_ += "]";
+        need_comma_ = true;
+        return true;
+    }
+
+    const std::string& out() const {
+        return out_;
+    }
+
+private:
+    void Comma() {
+        if (need_comma_) {
+            out_ += ",";
+        }
+        need_comma_ = true;
+    }
+
+    std::string out_;
+    bool need_comma_ = false;
+};
+
+// Only cares about the top level "id" field
+class IdHandler : public simcc::json::JSONSAXHandler {
+public:
+    virtual bool StartObject() {
+        ++depth_;
+        return true;
+    }
+    virtual bool EndObject(size_t) {
+        --depth_;
+        return true;
+    }
+    virtual bool Key(const char* s, size_t len) {
+        is_id_ = (depth_ == 1 && std::string(s, len) == "id");
+        return true;
+    }
+    virtual bool Int64(simcc::int64 i) {
+        if (is_id_) {
+            id_ = i;
+            return false; // we have got what we want, stop parsing
+        }
+        return true;
+    }
+
+    int depth_ = 0;
+    bool is_id_ = false;
+    simcc::int64 id_ = 0;
+};
+}
+
+TEST_UNIT(testJSONSAXParser) {
+    const char* texts[] = {
+        "{\"a\":1,\"b\":[1,2.5,\"x\",true,false,null,{},[]],\"c\":{\"d\":\"\\u4e2d\\t\"}}",
+        "[1,,3]",
+        "/*comment*/{ \"k\" : 'v' , // cpp comment\n \"n\":-100, }",
+        "[]",
+        "{}",
+    };
+
+    for (size_t i = 0; i < H_ARRAYSIZE(texts); i++) {
+        EchoHandler h;
+        simcc::json::JSONSAXParser p;
+        H_TEST_ASSERT(p.Parse(texts[i], -1, &h) > 0);
+        H_TEST_ASSERT(p.ok());
+
+        simcc::json::ObjectPtr dom = simcc::json::JSONParser::Load(texts[i]);
+        H_TEST_ASSERT(dom);
+        simcc::json::ObjectPtr sax = simcc::json::JSONParser::Load(h.out().data(), h.out().size());
+        H_TEST_ASSERT(sax);
+        H_TEST_ASSERT(dom->Equals(*sax));
+    }
+}
+
+TEST_UNIT(testJSONSAXParserStopByHandler) {
+    const char* text = "{\"sub\":{\"id\":1},\"id\":1234,\"big\":[1,2,3,4,5,6,7,8,9]}";
+    IdHandler h;
+    simcc::json::JSONSAXParser p;
+    H_TEST_ASSERT(p.Parse(text, -1, &h) == 0);
+    H_TEST_ASSERT(p.error() == simcc::json::JSONParser::kTerminatedByHandler);
+    H_TEST_ASSERT(h.id_ == 1234);
+}
+
+TEST_UNIT(testJSONSAXParserError) {
+    const char* texts[] = {
+        "{\"a\":}",
+        "{\"a\" 1}",
+        "[1,2",
+        "{\"a\":1",
+        "abc",
+    };
+
+    for (size_t i = 0; i < H_ARRAYSIZE(texts); i++) {
+        simcc::json::JSONSAXHandler h;
+        simcc::json::JSONSAXParser p;
+        H_TEST_ASSERT(p.Parse(texts[i], -1, &h) == 0);
+        H_TEST_ASSERT(!p.ok());
+        H_TEST_ASSERT(!simcc::json::JSONParser::Load(texts[i]));
+    }
+}
+
+TEST_UNIT(testJSONParserValidate) {
+    // Validate agrees with Load
+    const char* texts[] = {
+        "{\"a\":1}",
+        "[1,,2,]",
+        "{/* comment */ \"a\" : ['b', \"c\\u4e2d\\n\"], \"d\" : {\"e\" : -1.5e3}, }",
+        "[true, false, null, (1; 2)]",
+        "{\"a\":}",
+        "{\"a\" 1}",
+        "[1,2",
+        "{\"a\":1",
+        "{\"a\":\"b}",
+        "{\"a\":[1,2,{\"b\":}]}",
+        "{\"a\":1.2.3}",
+        "{a:1}",
+        "(1, 2)",
+        "abc",
+        "   ",
+    };
+
+    for (size_t i = 0; i < H_ARRAYSIZE(texts); i++) {
+        simcc::json::JSONParser p;
+        simcc::json::ObjectPtr o = simcc::json::JSONParser::Load(texts[i]);
+        H_TEST_ASSERT((p.Validate(texts[i]) > 0) == (o.get() != NULL));
+        H_TEST_ASSERT(p.ok() == (o.get() != NULL));
+    }
+
+    std::string path = "../test/test_data/json/browser_relative2.json";
+    simcc::DataStream ds;
+    H_TEST_ASSERT(ds.ReadFile(path));
+    simcc::json::JSONParser p;
+    H_TEST_ASSERT(p.Validate(ds.data(), ds.size()) > 0);
+    H_TEST_ASSERT(p.Validate(ds.data(), ds.size() / 2) == 0);
+    H_TEST_ASSERT(!p.ok());
+    H_TEST_ASSERT(p.Validate(NULL, 0) == 0);
+    H_TEST_ASSERT(p.error() == simcc::json::JSONParser::kParameterWrong);
+}
@@ -0,0 +1,114 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+#include "simcc/file_util.h"
+
+TEST_UNIT(testJSONSnapshot) {
+    using namespace simcc::json;
+    const char* json =
+        "{\n"
+        "    \"name\" : \"simcc\", \"version\" : 2, \"ratio\" : 0.5,\n"
+        "    \"enabled\" : true, \"none\" : null, \"\" : \"empty key\",\n"
+        "    \"list\" : [1, \"two\", [3], {\"four\" : 4}, false],\n"
+        "    \"server\" : { \"host\" : \"127.0.0.1\", \"port\" : 8080, \"tags\" : [] }\n"
+        "}";
+    JSONObject jo;
+    H_TEST_ASSERT(jo.Parse(json));
+
+    simcc::DataStream ds;
+    H_TEST_ASSERT(JSONSnapshot::Write(jo, ds));
+
+    JSONSnapshot s;
+    H_TEST_ASSERT(s.Open(ds.data(), ds.size()));
+    JSONSnapshotValue root = s.root();
+    H_TEST_ASSERT(root.type() == kJSONObject);
+    H_TEST_ASSERT(root.size() == jo.size());
+
+    H_TEST_ASSERT(s.Get("name").GetString() == "simcc");
+    H_TEST_ASSERT(s.Get("version").GetInteger() == 2);
+    H_TEST_ASSERT(s.Get("version").GetDecimal() == 2.0);
+    H_TEST_ASSERT(s.Get("ratio").GetDouble() == 0.5);
+    H_TEST_ASSERT(s.Get("enabled").GetBool());
+    H_TEST_ASSERT(s.Get("none").type() == kJSONNull);
+    H_TEST_ASSERT(s.Get("").GetString() == "empty key");
+    H_TEST_ASSERT(s.Get("server").Get("host").GetString() == "127.0.0.1");
+    H_TEST_ASSERT(s.Get("server").Get("port").GetInteger() == 8080);
+    H_TEST_ASSERT(s.Get("server").Get("tags").type() == kJSONArray);
+    H_TEST_ASSERT(s.Get("server").Get("tags").size() == 0);
+
+    JSONSnapshotValue list = s.Get("list");
+    H_TEST_ASSERT(list.size() == 5);
+    H_TEST_ASSERT(list.Get(0).GetInteger() == 1);
+    H_TEST_ASSERT(list.Get(1).GetString() == "two");
+    H_TEST_ASSERT(list.Get(2).Get(0).GetInteger() == 3);
+    H_TEST_ASSERT(list.Get(3).Get("four").GetInteger() == 4);
+    H_TEST_ASSERT(!list.Get(4).GetBool(true));
+
+    // Not found or of the other type
+    H_TEST_ASSERT(!s.Get("unknown").valid());
+    H_TEST_ASSERT(!list.Get(5).valid());
+    H_TEST_ASSERT(!s.Get("name").Get("a").valid());
+    H_TEST_ASSERT(s.Get("name").GetInteger(-1) == -1);
+    H_TEST_ASSERT(s.Get("version").GetString("default") == "default");
+
+    // The keys are sorted
+    for (size_t i = 1; i < root.size(); ++i) {
+        H_TEST_ASSERT(root.key(i - 1).compare(root.key(i)) < 0);
+        H_TEST_ASSERT(root.Get(root.key(i)).type() == root.Get(i).type());
+    }
+
+    ObjectPtr o = root.Materialize();
+    H_TEST_ASSERT(o && o->Equals(jo));
+
+    // An array as the root, written after some other data
+    JSONArray ja;
+    H_TEST_ASSERT(ja.Parse("[\"a\", {\"b\" : [1.5]}]"));
+    simcc::DataStream ds2;
+    ds2.Write("prefix", 6);
+    H_TEST_ASSERT(JSONSnapshot::Write(ja, ds2));
+    H_TEST_ASSERT(s.Open(ds2.data() + 6, ds2.size() - 6));
+    H_TEST_ASSERT(s.Get(1).Get("b").Get(0).GetDouble() == 1.5);
+    o = s.root().Materialize();
+    H_TEST_ASSERT(o && o->Equals(ja));
+
+    // A snapshot file
+    std::string path = "temp_json_snapshot.dat";
+    H_TEST_ASSERT(ds.WriteFile(path));
+    JSONSnapshot f;
+    H_TEST_ASSERT(f.OpenFile(path));
+    H_TEST_ASSERT(f.Get("server").Get("port").GetInteger() == 8080);
+
+    // Opening another snapshot releases the mapped file
+    H_TEST_ASSERT(f.Open(ds2.data() + 6, ds2.size() - 6));
+    H_TEST_ASSERT(f.Get(0).GetString() == "a");
+    H_TEST_ASSERT(f.OpenFile(path));
+    H_TEST_ASSERT(f.Get("server").Get("port").GetInteger() == 8080);
+    f.Close();
+    H_TEST_ASSERT(!f.root().valid());
+    simcc::FileUtil::Unlink(path);
+}
+
+TEST_UNIT(testJSONSnapshotCorrupted) {
+    using namespace simcc::json;
+    JSONObject jo;
+    H_TEST_ASSERT(jo.Parse("{\"a\" : [1, \"abc\", {\"b\" : 2.5}], \"c\" : true}"));
+    simcc::DataStream ds;
+    H_TEST_ASSERT(JSONSnapshot::Write(jo, ds));
+
+    JSONSnapshot s;
+    H_TEST_ASSERT(!s.Open(ds.data(), 10));
+    H_TEST_ASSERT(!s.Open(ds.data(), ds.size() - 1));
+    H_TEST_ASSERT(!s.Open("{\"a\":1}", 7));
+    std::string text = jo.ToString();
+    H_TEST_ASSERT(!s.Open(text.data(), text.size()));
+
+    // Every byte flipped gives a valid document or the invalid values, never a crash
+    for (size_t i = 0; i < ds.size(); ++i) {
+        std::string data(ds.data(), ds.size());
+        data[i] = static_cast<char>(data[i] ^ 0xFF);
+        if (s.Open(data.data(), data.size())) {
+            s.root().Materialize();
+            s.Get("a").Get(2).Get("b").GetDouble();
+            s.Get("c").GetBool();
+        }
+    }
+}
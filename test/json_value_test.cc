@@ -0,0 +1,235 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+#include "simcc/data_stream.h"
+#include "simcc/mapped_file.h"
+#include "simcc/qh_palloc.h"
+
+#include <limits>
+#include <random>
+
+namespace {
+std::string DoubleToString(double d) {
+    simcc::json::JSONDouble jd(d);
+    simcc::DataStream ds;
+    jd.ToStringBuf(ds);
+    std::string s(ds.data(), ds.size());
+    // ToString and ToStringBuf must be the same
+    return s == jd.ToString() ? s : "mismatch";
+}
+
+std::string IntegerToString(simcc::int64 i) {
+    simcc::json::JSONInteger ji(i);
+    simcc::DataStream ds;
+    ji.ToStringBuf(ds);
+    std::string s(ds.data(), ds.size());
+    return s == ji.ToString() ? s : "mismatch";
+}
+}
+
+TEST_UNIT(testJSONDoubleToString) {
+    H_TEST_ASSERT(DoubleToString(0.0) == "0.0");
+    H_TEST_ASSERT(DoubleToString(-0.0) == "-0.0");
+    H_TEST_ASSERT(DoubleToString(1.0) == "1.0");
+    H_TEST_ASSERT(DoubleToString(-1.5) == "-1.5");
+    H_TEST_ASSERT(DoubleToString(0.1) == "0.1");
+    H_TEST_ASSERT(DoubleToString(0.123) == "0.123");
+    H_TEST_ASSERT(DoubleToString(0.0008744) == "0.0008744");
+    H_TEST_ASSERT(DoubleToString(123456789.125) == "123456789.125");
+    H_TEST_ASSERT(DoubleToString(1e30) == "1e30");
+    H_TEST_ASSERT(DoubleToString(1.5e-30) == "1.5e-30");
+    H_TEST_ASSERT(DoubleToString(std::numeric_limits<double>::quiet_NaN()) == "null");
+    H_TEST_ASSERT(DoubleToString(std::numeric_limits<double>::infinity()) == "null");
+
+    // Round trip
+    std::mt19937_64 rng(20091007);
+    const double special[] = {
+        std::numeric_limits<double>::max(),
+        std::numeric_limits<double>::min(),
+        std::numeric_limits<double>::denorm_min(),
+        std::numeric_limits<double>::epsilon(),
+        5e-324, 1.7976931348623157e308, 0.30000000000000004,
+    };
+    for (size_t i = 0; i < H_ARRAYSIZE(special) + 100000; ++i) {
+        double d = 0;
+        if (i < H_ARRAYSIZE(special)) {
+            d = special[i];
+        } else {
+            simcc::uint64 u = rng();
+            memcpy(&d, &u, sizeof(d));
+            if (!std::isfinite(d)) {
+                continue;
+            }
+        }
+        std::string s = DoubleToString(d);
+        double r = strtod(s.c_str(), NULL);
+        H_TEST_ASSERT(memcmp(&d, &r, sizeof(d)) == 0);
+
+        simcc::json::ObjectPtr o = simcc::json::JSONParser::Load(("[" + s + "]").c_str());
+        H_TEST_ASSERT(o);
+        H_TEST_ASSERT(simcc::json::cast<simcc::json::JSONArray>(o)->GetJSONDouble(0));
+    }
+}
+
+TEST_UNIT(testJSONIntegerToString) {
+    H_TEST_ASSERT(IntegerToString(0) == "0");
+    H_TEST_ASSERT(IntegerToString(-1) == "-1");
+    H_TEST_ASSERT(IntegerToString(99) == "99");
+    H_TEST_ASSERT(IntegerToString(100) == "100");
+    H_TEST_ASSERT(IntegerToString(std::numeric_limits<simcc::int64>::max()) == "9223372036854775807");
+    H_TEST_ASSERT(IntegerToString(std::numeric_limits<simcc::int64>::min()) == "-9223372036854775808");
+
+    std::mt19937_64 rng(20091007);
+    for (int i = 0; i < 100000; ++i) {
+        simcc::int64 v = static_cast<simcc::int64>(rng()) >> (i % 64);
+        H_TEST_ASSERT(IntegerToString(v) == std::to_string(v));
+    }
+}
+
+namespace {
+simcc::json::ObjectPtr ParseNumber(const std::string& s) {
+    simcc::json::ObjectPtr o = simcc::json::JSONParser::Load(("[" + s + "]").c_str());
+    if (!o) {
+        return simcc::json::ObjectPtr();
+    }
+    return simcc::json::cast<simcc::json::JSONArray>(o)->Get(0);
+}
+
+bool IsInteger(const std::string& s, simcc::int64 v) {
+    simcc::json::ObjectPtr o = ParseNumber(s);
+    return o && o->IsTypeOf(simcc::json::kJSONInteger) && simcc::json::cast<simcc::json::JSONInteger>(o)->value() == v;
+}
+
+bool IsDouble(const std::string& s) {
+    simcc::json::ObjectPtr o = ParseNumber(s);
+    if (!o || !o->IsTypeOf(simcc::json::kJSONDouble)) {
+        return false;
+    }
+    double d = simcc::json::cast<simcc::json::JSONDouble>(o)->value();
+    double expected = strtod(s.c_str(), NULL);
+    return memcmp(&d, &expected, sizeof(d)) == 0;
+}
+}
+
+TEST_UNIT(testJSONNumberParse) {
+    H_TEST_ASSERT(IsInteger("0", 0));
+    H_TEST_ASSERT(IsInteger("-0", 0));
+    H_TEST_ASSERT(IsInteger("+12", 12));
+    H_TEST_ASSERT(IsInteger("9223372036854775807", INT64_MAX));
+    H_TEST_ASSERT(IsInteger("-9223372036854775808", INT64_MIN));
+    H_TEST_ASSERT(IsInteger("0x1F", 31));
+    H_TEST_ASSERT(IsInteger("010", 8));
+    H_TEST_ASSERT(IsInteger("123  ", 123));
+
+    // int64 overflow is promoted to double
+    H_TEST_ASSERT(IsDouble("9223372036854775808"));
+    H_TEST_ASSERT(IsDouble("-9223372036854775809"));
+    H_TEST_ASSERT(IsDouble("123456789012345678901234567890"));
+
+    H_TEST_ASSERT(IsDouble("0.5"));
+    H_TEST_ASSERT(IsDouble(".5"));
+    H_TEST_ASSERT(IsDouble("5."));
+    H_TEST_ASSERT(IsDouble("-0.0"));
+    H_TEST_ASSERT(IsDouble("1e10"));
+    H_TEST_ASSERT(IsDouble("1E+10"));
+    H_TEST_ASSERT(IsDouble("0.0008744"));
+    H_TEST_ASSERT(IsDouble("2.2250738585072011e-308"));
+    H_TEST_ASSERT(IsDouble("1.7976931348623157e308"));
+    H_TEST_ASSERT(IsDouble("4.9406564584124654e-324"));
+    H_TEST_ASSERT(IsDouble("0.30000000000000004"));
+    H_TEST_ASSERT(IsDouble("1e400"));
+    H_TEST_ASSERT(IsDouble("1e-400"));
+    H_TEST_ASSERT(IsDouble("0.000000000000000000000000000000000000000000000000001"));
+
+    // Both the fast path and the slow path must be the same as strtod
+    std::mt19937_64 rng(20091007);
+    for (int i = 0; i < 100000; ++i) {
+        simcc::uint64 m = rng() >> (rng() % 64);
+        int e = static_cast<int>(rng() % 80) - 40;
+        std::string s = std::to_string(m);
+        if (i % 2) {
+            s.insert(s.size() > 1 ? s.size() / 2 : 0, ".");
+        }
+        s += "e" + std::to_string(e);
+        H_TEST_ASSERT(IsDouble(s));
+    }
+
+    const char* invalid[] = { "-", "+", ".", "1e", "1e+", "1.2.3", "12abc", "1-2", "--1", "nul", "nullx", "truex" };
+    for (size_t i = 0; i < H_ARRAYSIZE(invalid); ++i) {
+        H_TEST_ASSERT(!ParseNumber(invalid[i]));
+    }
+}
+
+TEST_UNIT(testJSONStringInSitu) {
+    using namespace simcc::json;
+    const std::string source = "{\"plain\":\"hello world\", \"escaped\":\"a\\tb\", \"empty\":\"\", \"list\":[\"x\", \"\\u4e2d\"]}";
+
+    JSONObject normal;
+    H_TEST_ASSERT(normal.Parse(source.data(), source.size()));
+    H_TEST_ASSERT(normal.GetJSONStringView("plain") == NULL);
+    H_TEST_ASSERT(normal.GetSlice("plain") == "hello world");
+
+    JSONObject jo;
+    H_TEST_ASSERT(jo.ParseInSitu(source.data(), source.size()));
+    H_TEST_ASSERT(jo.Equals(normal) && normal.Equals(jo));
+    H_TEST_ASSERT(jo.ToString() == normal.ToString());
+    H_TEST_ASSERT(jo.ToString(true) == normal.ToString(true));
+
+    // The strings without escapes refer to the source text
+    const JSONStringView* plain = jo.GetJSONStringView("plain");
+    H_TEST_ASSERT(plain && plain->slice() == "hello world");
+    H_TEST_ASSERT(plain->slice().data() > source.data() && plain->slice().data() < source.data() + source.size());
+    H_TEST_ASSERT(jo.GetJSONString("plain") == NULL);
+    H_TEST_ASSERT(jo.GetSlice("plain") == "hello world");
+    H_TEST_ASSERT(jo.GetJSONStringView("empty") && jo.GetSlice("empty", "default").empty());
+    H_TEST_ASSERT(jo.GetJSONArray("list")->GetJSONStringView(0));
+    H_TEST_ASSERT(jo.GetJSONArray("list")->GetSlice(0) == "x");
+
+    // The strings with escapes are decoded into a JSONString
+    H_TEST_ASSERT(jo.GetString("escaped") == "a\tb");
+    H_TEST_ASSERT(jo.GetSlice("escaped") == "a\tb");
+    H_TEST_ASSERT(jo.GetJSONArray("list")->GetString(1) == "\xe4\xb8\xad");
+    H_TEST_ASSERT(jo.GetSlice("unknown", "default") == "default");
+
+    // Saved as a JSONString
+    simcc::DataStream ds;
+    ds << jo;
+    JSONObject loaded;
+    ds >> loaded;
+    H_TEST_ASSERT(loaded.GetString("plain") == "hello world");
+    H_TEST_ASSERT(loaded.Equals(normal));
+
+    JSONArray ja;
+    H_TEST_ASSERT(ja.ParseInSitu("[\"a\", 1, \"b\\\"\"]"));
+    H_TEST_ASSERT(ja.GetSlice(0) == "a" && ja.GetSlice(1).empty() && ja.GetSlice(2) == "b\"");
+    H_TEST_ASSERT(ja.ToString() == "[\"a\",1,\"b\\\"\"]");
+}
+
+TEST_UNIT(testJSONParserLoadInSitu) {
+    using namespace simcc::json;
+    const char* path = "../test/test_data/json/browser_relative2.json";
+    ObjectPtr normal = JSONParser::LoadFile(path);
+    H_TEST_ASSERT(normal);
+
+    simcc::MappedFile f;
+    ObjectPtr doc = JSONParser::LoadFileInSitu(path, f);
+    H_TEST_ASSERT(doc && doc->Equals(*normal) && normal->Equals(*doc));
+    H_TEST_ASSERT(doc->ToString() == normal->ToString());
+
+    simcc::qh::Pool pool(4096);
+    doc = JSONParser::LoadInSitu(f.data(), f.size(), &pool);
+    H_TEST_ASSERT(doc && doc->Equals(*normal));
+    doc = ObjectPtr();
+}
+
+TEST_UNIT(testJSONParserLoadFile) {
+    const char* path = "../test/test_data/json/browser_relative2.json";
+    simcc::DataStream buf;
+    H_TEST_ASSERT(buf.ReadFile(path));
+    simcc::json::JSONObject jo;
+    H_TEST_ASSERT(jo.Parse(buf.data(), buf.size()));
+
+    simcc::json::ObjectPtr doc = simcc::json::JSONParser::LoadFile(path);
+    H_TEST_ASSERT(doc && doc->Equals(jo));
+
+    H_TEST_ASSERT(!simcc::json::JSONParser::LoadFile("../test/test_data/json/not_exist.json"));
+}
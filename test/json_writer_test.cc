@@ -0,0 +1,114 @@
+#include "test_common.h"
+#include "simcc/json/json.h"
+#include "simcc/file_util.h"
+
+#include <fcntl.h>
+#ifdef H_OS_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+// The text produced by the old way
+std::string ToStringBuf(const simcc::json::Object& o, bool readable, bool utf8_to_unicode) {
+    simcc::DataStream ds;
+    o.ToStringBuf(ds, readable ? 1 : 0, utf8_to_unicode);
+    return std::string(ds.data(), ds.size());
+}
+}
+
+TEST_UNIT(testJSONWriter) {
+    using namespace simcc::json;
+    const char* json =
+        "{\n"
+        "    \"name\" : \"simcc\", \"escape\" : \"\\\"\\\\</\\b\\f\\n\\r\\t\\u0001\",\n"
+        "    \"unicode\" : \"\\u4e2d\\u6587\\ud83d\\ude00\\u00e9\", \"\" : [],\n"
+        "    \"numbers\" : [0, -1, 9223372036854775807, -9223372036854775807, 3.25, -1e300, 1e-300],\n"
+        "    \"flags\" : [true, false, null], \"empty\" : {},\n"
+        "    \"nested\" : [[], {}, [{\"a\" : [1, {\"b\" : \"c\"}]}]]\n"
+        "}";
+    JSONObject jo;
+    H_TEST_ASSERT(jo.Parse(json));
+    JSONArray ja;
+    H_TEST_ASSERT(ja.Parse("[1, \"two\", {\"three\" : [3]}, [], 4.5]"));
+    JSONString js("\xe4\xb8\xad\xff\xfe</script>");
+    JSONString tail("\xe4\xb8\xad"); // Escaped at the end of the text
+    JSONInteger ji(-123);
+    JSONString worst("\xc3\xa9\xf0\x9f\x98\x80\"\\\n\xc3\xa9"); // The most escaped characters for every byte
+
+    const Object* objects[] = { &jo, &ja, &js, &tail, &ji, &worst };
+    for (size_t i = 0; i < H_ARRAYSIZE(objects); ++i) {
+        for (int readable = 0; readable < 2; ++readable) {
+            for (int unicode = 0; unicode < 2; ++unicode) {
+                std::string expected = ToStringBuf(*objects[i], readable != 0, unicode != 0);
+
+                // Appended to a string
+                std::string s = "prefix";
+                JSONWriter::Serialize(*objects[i], s, readable != 0, unicode != 0);
+                H_TEST_ASSERT(s == "prefix" + expected);
+
+                simcc::DataStream ds;
+                JSONWriter::Serialize(*objects[i], ds, readable != 0, unicode != 0);
+                H_TEST_ASSERT(std::string(ds.data(), ds.size()) == expected);
+
+                // Streamed in small chunks
+                for (size_t chunk_size = 1; chunk_size < 64; chunk_size *= 4) {
+                    std::string streamed;
+                    JSONWriter w([&streamed](const char* data, size_t len) {
+                        streamed.append(data, len);
+                        return true;
+                    }, chunk_size);
+                    H_TEST_ASSERT(w.Write(*objects[i], readable != 0, unicode != 0));
+                    H_TEST_ASSERT(streamed == expected);
+                }
+            }
+        }
+    }
+
+    // The readable text is parsed back
+    JSONObject readable;
+    H_TEST_ASSERT(readable.Parse(jo.ToString(true)));
+    H_TEST_ASSERT(readable.Equals(jo));
+
+    // Stopped by the sink
+    size_t calls = 0;
+    JSONWriter w([&calls](const char*, size_t) {
+        return ++calls < 2;
+    }, 1);
+    H_TEST_ASSERT(!w.Write(jo));
+    H_TEST_ASSERT(calls == 2);
+}
+
+TEST_UNIT(testJSONWriterFile) {
+    const char* path = "../test/test_data/json/browser_relative2.json";
+    simcc::json::ObjectPtr o = simcc::json::JSONParser::LoadFile(path);
+    H_TEST_ASSERT(o);
+
+    std::string out = "temp_json_writer.json";
+    int fd = ::open(out.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    H_TEST_ASSERT(fd >= 0);
+    H_TEST_ASSERT(simcc::json::JSONWriter::SerializeToFd(*o, fd, true));
+    ::close(fd);
+
+    simcc::DataStream ds;
+    H_TEST_ASSERT(ds.ReadFile(out));
+    H_TEST_ASSERT(std::string(ds.data(), ds.size()) == o->ToString(true));
+    simcc::FileUtil::Unlink(out);
+
+    // A text which is passed to the string in several chunks
+    std::string text = "[";
+    for (int i = 0; i < 10; ++i) {
+        text += (i ? "," : "") + o->ToString();
+    }
+    text += "]";
+    o = simcc::json::JSONParser::Load(text.data(), text.size());
+    H_TEST_ASSERT(o);
+    for (int readable = 0; readable < 2; ++readable) {
+        std::string expected = ToStringBuf(*o, readable != 0, true);
+        H_TEST_ASSERT(expected.size() > 16 * 1024);
+        std::string s = "prefix";
+        simcc::json::JSONWriter::Serialize(*o, s, readable != 0);
+        H_TEST_ASSERT(s == "prefix" + expected);
+    }
+}
@@ -195,3 +195,32 @@ TEST_UNIT(qh_pool) {
     qh_pool_test_2();
     qh_pool_test_3();
 }
+
+TEST_UNIT(qh_pool_reset_reuse) {
+    qh_pool_t* pool = qh_create_pool(4096, QH_MAX_ALLOC_FROM_POOL);
+
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 2000; ++i) {
+            char* p = (char*)qh_palloc(pool, 64);
+            H_TEST_ASSERT(p);
+            memset(p, 'A', 64);
+        }
+
+        size_t blocks = 0;
+        size_t behind_current = 0;
+        for (qh_pool_t* p = pool->current; p; p = p->d.next) {
+            ++behind_current;
+        }
+        for (qh_pool_t* p = pool; p; p = p->d.next) {
+            ++blocks;
+        }
+
+        // The recycled blocks are reused and the full ones are not walked any more
+        H_TEST_ASSERT(blocks > 20);
+        H_TEST_ASSERT(behind_current <= 2);
+        qh_reset_pool(pool);
+        H_TEST_ASSERT(pool->current == pool);
+    }
+
+    qh_destroy_pool(pool);
+}
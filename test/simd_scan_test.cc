@@ -0,0 +1,256 @@
+#include "test_common.h"
+#include "simcc/simd_scan.h"
+#include "simcc/json/json.h"
+#include "simcc/json/json_tokener.h"
+
+#include <random>
+
+namespace {
+const char* FindQuoteOrEscapeSimple(const char* p, const char* end, char quote) {
+    for (; p < end; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (*p == quote || *p == '\\' || c < 0x20) {
+            return p;
+        }
+    }
+    return end;
+}
+
+const char* FindQuoteCandidateSimple(const char* p, const char* end, bool non_ascii) {
+    for (; p < end; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\' || c == '/' || c < 0x20 || (non_ascii && c >= 0x80)) {
+            return p;
+        }
+    }
+    return end;
+}
+
+const char* SkipSpacesSimple(const char* p, const char* end) {
+    for (; p < end; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == 0 || c > 0x20) {
+            return p;
+        }
+    }
+    return end;
+}
+
+// Runs f with every implementation supported by this CPU
+template<class F>
+void ForEachLevel(F f) {
+    simcc::SIMDScan::Level saved = simcc::SIMDScan::level();
+    for (int l = simcc::SIMDScan::kScalar; l <= simcc::SIMDScan::supported_level(); ++l) {
+        H_TEST_ASSERT(simcc::SIMDScan::set_level(static_cast<simcc::SIMDScan::Level>(l)));
+        f();
+    }
+    simcc::SIMDScan::set_level(saved);
+}
+}
+
+TEST_UNIT(testSIMDScanFindQuoteOrEscape) {
+    ForEachLevel([]() {
+        // The special byte at every position of every length, so both the
+        // block loops and the tails are covered
+        for (size_t len = 0; len < 80; ++len) {
+            std::string s(len, 'a');
+            const char* end = s.data() + s.size();
+            H_TEST_ASSERT(simcc::SIMDScan::FindQuoteOrEscape(s.data(), end, '"') == end);
+            for (size_t i = 0; i < len; ++i) {
+                const char specials[] = { '"', '\\', '\0', '\x1F', '\n' };
+                for (char c : specials) {
+                    std::string t = s;
+                    t[i] = c;
+                    const char* e = t.data() + t.size();
+                    H_TEST_ASSERT(simcc::SIMDScan::FindQuoteOrEscape(t.data(), e, '"') == t.data() + i);
+                }
+
+                // Not special : the other quote, a space and high bytes
+                std::string t = s;
+                t[i] = (i % 3 == 0) ? '\'' : (i % 3 == 1 ? ' ' : '\xE4');
+                H_TEST_ASSERT(simcc::SIMDScan::FindQuoteOrEscape(t.data(), t.data() + t.size(), '"') == t.data() + t.size());
+            }
+        }
+
+        // Random data at unaligned offsets
+        std::mt19937 rng(20161018);
+        std::string buf(1024, 0);
+        for (int n = 0; n < 200; ++n) {
+            for (size_t i = 0; i < buf.size(); ++i) {
+                // Mostly printable characters so the special ones are sparse
+                unsigned v = rng() % 512;
+                buf[i] = static_cast<char>(v < 480 ? 0x20 + v % 0x60 : v % 0x100);
+            }
+            size_t begin = rng() % 64;
+            size_t end = begin + rng() % (buf.size() - begin);
+            const char quote = (n % 2) ? '"' : '\'';
+            const char* b = buf.data() + begin;
+            const char* e = buf.data() + end;
+            H_TEST_ASSERT(simcc::SIMDScan::FindQuoteOrEscape(b, e, quote) == FindQuoteOrEscapeSimple(b, e, quote));
+        }
+    });
+}
+
+TEST_UNIT(testSIMDScanFindQuoteCandidate) {
+    ForEachLevel([]() {
+        for (size_t len = 0; len < 80; ++len) {
+            std::string s(len, 'a');
+            const char* end = s.data() + s.size();
+            H_TEST_ASSERT(simcc::SIMDScan::FindQuoteCandidate(s.data(), end, true) == end);
+            for (size_t i = 0; i < len; ++i) {
+                const char specials[] = { '"', '\\', '/', '\0', '\x1F', '\n' };
+                for (char c : specials) {
+                    std::string t = s;
+                    t[i] = c;
+                    H_TEST_ASSERT(simcc::SIMDScan::FindQuoteCandidate(t.data(), t.data() + t.size(), false) == t.data() + i);
+                }
+
+                // A non-ASCII byte only stops the scan if it is required
+                std::string t = s;
+                t[i] = (i % 2) ? '\x80' : '\xFF';
+                H_TEST_ASSERT(simcc::SIMDScan::FindQuoteCandidate(t.data(), t.data() + t.size(), true) == t.data() + i);
+                H_TEST_ASSERT(simcc::SIMDScan::FindQuoteCandidate(t.data(), t.data() + t.size(), false) == t.data() + t.size());
+            }
+        }
+
+        std::mt19937 rng(20161018);
+        std::string buf(1024, 0);
+        for (int n = 0; n < 200; ++n) {
+            for (size_t i = 0; i < buf.size(); ++i) {
+                unsigned v = rng() % 512;
+                buf[i] = static_cast<char>(v < 480 ? 0x20 + v % 0x60 : v % 0x100);
+            }
+            size_t begin = rng() % 64;
+            size_t end = begin + rng() % (buf.size() - begin);
+            const char* b = buf.data() + begin;
+            const char* e = buf.data() + end;
+            bool non_ascii = (n % 2) != 0;
+            H_TEST_ASSERT(simcc::SIMDScan::FindQuoteCandidate(b, e, non_ascii) == FindQuoteCandidateSimple(b, e, non_ascii));
+        }
+    });
+}
+
+TEST_UNIT(testSIMDScanSkipSpaces) {
+    ForEachLevel([]() {
+        for (size_t len = 0; len < 80; ++len) {
+            std::string s(len, ' ');
+            const char* end = s.data() + s.size();
+            H_TEST_ASSERT(simcc::SIMDScan::SkipSpaces(s.data(), end) == end);
+            for (size_t i = 0; i < len; ++i) {
+                const char stops[] = { '\0', '\x21', '{', '\x7F', '\x80', '\xFF' };
+                for (char c : stops) {
+                    std::string t = s;
+                    t[i] = c;
+                    H_TEST_ASSERT(simcc::SIMDScan::SkipSpaces(t.data(), t.data() + t.size()) == t.data() + i);
+                }
+            }
+        }
+
+        std::mt19937 rng(20161018);
+        std::string buf(1024, 0);
+        const char ws[] = { ' ', '\t', '\n', '\r', '\x01', '\x20' };
+        for (int n = 0; n < 200; ++n) {
+            for (size_t i = 0; i < buf.size(); ++i) {
+                unsigned v = rng() % 256;
+                buf[i] = v < 250 ? ws[v % sizeof(ws)] : static_cast<char>(v);
+            }
+            size_t begin = rng() % 64;
+            size_t end = begin + rng() % (buf.size() - begin);
+            const char* b = buf.data() + begin;
+            const char* e = buf.data() + end;
+            H_TEST_ASSERT(simcc::SIMDScan::SkipSpaces(b, e) == SkipSpacesSimple(b, e));
+        }
+    });
+}
+
+TEST_UNIT(testSIMDScanJSONComment) {
+    const char* json =
+        "/* a pretty printed document */\n"
+        "{\n"
+        "    // the name\n"
+        "    \"name\"   :   \"simcc\",\n"
+        "    \"list\" : [\n"
+        "        1,  /* one */\n"
+        "        2\n"
+        "                                        \n"
+        "    ]\n"
+        "}\n";
+    ForEachLevel([json]() {
+        simcc::json::JSONObject jo;
+        H_TEST_ASSERT(jo.Parse(json, strlen(json)));
+        H_TEST_ASSERT(jo.GetString("name") == "simcc");
+        H_TEST_ASSERT(jo.GetJSONArray("list")->size() == 2);
+    });
+
+    const char* bad = "{ \"a\" : /* not closed }";
+    simcc::json::JSONObject jo;
+    H_TEST_ASSERT(!jo.Parse(bad, strlen(bad)));
+}
+
+TEST_UNIT(testSIMDScanJSONString) {
+    ForEachLevel([]() {
+        struct {
+            const char* json;
+            const char* expected;
+        } cases[] = {
+            { "{\"k\":\"\"}", "" },
+            { "{\"k\":\"abc\"}", "abc" },
+            { "{\"k\":\"a long string without any escaped characters in it\"}", "a long string without any escaped characters in it" },
+            { "{\"k\":\"0123456789abcdef0123456789abcdef\\n0123456789abcdef0123456789abcdef\"}", "0123456789abcdef0123456789abcdef\n0123456789abcdef0123456789abcdef" },
+            { "{\"k\":\"\\\"quoted\\\" and \\\\ back\\/slash\\t\"}", "\"quoted\" and \\ back/slash\t" },
+            { "{\"k\":\"\\u4e2d\\u6587 utf8 \xE4\xB8\xAD\xE6\x96\x87 mixed\"}", "\xE4\xB8\xAD\xE6\x96\x87 utf8 \xE4\xB8\xAD\xE6\x96\x87 mixed" },
+            { "{\"k\":'single \"quoted\" string'}", "single \"quoted\" string" },
+        };
+
+        for (size_t i = 0; i < H_ARRAYSIZE(cases); ++i) {
+            simcc::json::JSONObject jo;
+            H_TEST_ASSERT(jo.Parse(cases[i].json, strlen(cases[i].json)));
+            H_TEST_ASSERT(jo.GetString("k") == cases[i].expected);
+        }
+
+        // Unterminated strings
+        const char* bad[] = { "{\"k\":\"abc", "{\"k\":\"0123456789abcdef0123456789abcdef\\", "{\"k\":\"abc\\\"}" };
+        for (size_t i = 0; i < H_ARRAYSIZE(bad); ++i) {
+            simcc::json::JSONObject jo;
+            H_TEST_ASSERT(!jo.Parse(bad[i], strlen(bad[i])));
+        }
+
+        // A NUL byte terminates the text as before
+        std::string s("{\"k\":\"ab\0cd\"}", 13);
+        simcc::json::JSONObject jo;
+        H_TEST_ASSERT(!jo.Parse(s.data(), s.size()));
+    });
+}
+
+TEST_UNIT(testSIMDScanJSONQuote) {
+    struct {
+        const char* value;
+        const char* unicode;  // Quoted with utf8_to_unicode
+        const char* raw;      // Quoted without utf8_to_unicode
+    } cases[] = {
+        { "", "\"\"", "\"\"" },
+        { "a long string without any escaped characters in it",
+          "\"a long string without any escaped characters in it\"",
+          "\"a long string without any escaped characters in it\"" },
+        { "0123456789abcdef0123456789abcdef\"0123456789abcdef0123456789abcdef\\x",
+          "\"0123456789abcdef0123456789abcdef\\\"0123456789abcdef0123456789abcdef\\\\x\"",
+          "\"0123456789abcdef0123456789abcdef\\\"0123456789abcdef0123456789abcdef\\\\x\"" },
+        { "</script> a/b \b\f\n\r\t\x01",
+          "\"</script> a/b \\b\\f\\n\\r\\t\x01\"",
+          "\"</script> a/b \\b\\f\\n\\r\\t\x01\"" },
+        { "0123456789abcdef0123456789abcdef \xE4\xB8\xAD\xE6\x96\x87 0123456789abcdef\xF0\x9F\x98\x80",
+          "\"0123456789abcdef0123456789abcdef \\u4e2d\\u6587 0123456789abcdef\\ud83d\\ude00\"",
+          "\"0123456789abcdef0123456789abcdef \xE4\xB8\xAD\xE6\x96\x87 0123456789abcdef\xF0\x9F\x98\x80\"" },
+        { "GBK \xD6\xD0\xCE\xC4 0123456789abcdef0123456789abcdef\xFF",
+          "\"GBK \xD6\xD0\xCE\xC4 0123456789abcdef0123456789abcdef\xFF\"",
+          "\"GBK \xD6\xD0\xCE\xC4 0123456789abcdef0123456789abcdef\xFF\"" },
+    };
+
+    ForEachLevel([&cases]() {
+        for (size_t i = 0; i < H_ARRAYSIZE(cases); ++i) {
+            simcc::json::JSONString js(cases[i].value);
+            H_TEST_ASSERT(js.ToString(false, true) == cases[i].unicode);
+            H_TEST_ASSERT(js.ToString(false, false) == cases[i].raw);
+        }
+    });
+}
@@ -90,6 +90,26 @@ void test_token_3() {
     token.Back();
     H_TEST_ASSERT(token.GetCurrent() == text);
 }
+
+void test_token_4() {
+    // Long runs of spaces are skipped in blocks
+    std::string text = "a" + std::string(100, ' ') + "\n\t\r" + std::string(40, '\t') + "b \x01\xB0\xA1";
+    text.append(1, '\0');
+    text.append(35, ' ');
+    simcc::Tokener token(text.data(), static_cast<simcc::int32>(text.size()));
+    H_TEST_ASSERT(token.NextClean() == 'a');
+    H_TEST_ASSERT(token.NextClean() == 'b');
+    // GBK code is not a space, but 0x01 is
+    H_TEST_ASSERT(token.NextClean() == '\xB0');
+    H_TEST_ASSERT(token.NextClean() == '\xA1');
+    // NUL is not a space
+    H_TEST_ASSERT(token.NextClean() == 0);
+    H_TEST_ASSERT(token.GetCurrent() == text.data() + text.size() - 35);
+    H_TEST_ASSERT(!token.SkipSpaces());
+    H_TEST_ASSERT(token.GetCurrent() == text.data() + text.size());
+    H_TEST_ASSERT(token.NextClean() == 0);
+    H_TEST_ASSERT(token.GetCurrent() == text.data() + text.size());
+}
 }
 
 TEST_UNIT(TestTokener) {
@@ -97,6 +117,7 @@ TEST_UNIT(TestTokener) {
     test_token_1();
     test_token_2();
     test_token_3();
+    test_token_4();
 }
 
 